@@ -1,107 +1,1039 @@
 /**
- * simdjson Benchmark
+ * Native Benchmark Driver
  *
- * Benchmarks simdjson parsing performance against test data.
+ * One harness for every native backend, so their numbers share timing
+ * code, inputs and output format:
  *
- * Build:
- *   cd benchmarks/competitors/simdjson
- *   mkdir build && cd build
- *   cmake .. -DCMAKE_BUILD_TYPE=Release
- *   make
- *   cd ../../../..
+ *   simdjson-ondemand  parser.iterate / iterate_many (if simdjson.h is found)
+ *   simdjson-dom       Stage 1 / Stage 2 through parser.implementation
+ *   neon               neon_json_find_structural_arena + json_build_tape,
+ *                      json_query_paths, json_ndjson_parse_parallel
+ *   metal              metal_json_full_stage1_borrowed + json_build_tape
+ *                      (macOS; libmetal_bridge.dylib is loaded at runtime)
+ *
+ * Workloads (see Workload below; bench_neon.mojo runs the same ones):
+ *
+ *   parse     each API's own parse - not comparable across backends, since
+ *             simdjson-ondemand only runs Stage 1 and reads the root type
+ *   traverse  visit every value, decode every key and string
+ *   sum       add up every number as a double
+ *   paths     look up 8 JSON Pointers spread over the document's leaves
+ *   ndjson    traverse every record of a .ndjson file
+ *
+ * Each run reports a checksum (value count + decoded string bytes, the
+ * sum, or paths found) and the driver flags backends that disagree.
+ *
+ * Every .json / .ndjson file in data/ (memory-mapped with json_mmap_open,
+ * so nobody copies the document) is run by every backend. Each run is timed
+ * with steady_clock; the report gives median and p99 in ns, GB/s for the
+ * whole parse and separately for Stage 1 (structural index) and Stage 2
+ * (tape / DOM) where the backend can split them, plus cycles, instructions
+ * and cache misses per byte from perf_event_open (Linux) or kperf (macOS,
+ * fixed counters only, needs root). Counters that cannot be opened are
+ * left empty rather than guessed.
+ *
+ * Results go to results/native_benchmarks.csv and .json in the schema
+ * run_all.sh merges (see SCHEMA below and benchmarks/README.md).
+ *
+ * Build (run_all.sh does this):
+ *   ../neon/build.sh
  *   clang++ -O3 -std=c++17 -I competitors/simdjson/singleheader \
- *           bench_simdjson.cpp -o bench_simdjson
+ *           competitors/simdjson/singleheader/simdjson.cpp bench_simdjson.cpp \
+ *           -L../neon -lneon_json -Wl,-rpath,../neon -ldl -o bench_simdjson
  *
- * Or with single-header:
- *   clang++ -O3 -std=c++17 bench_simdjson.cpp -o bench_simdjson
+ * Usage:
+ *   ./bench_simdjson [data_dir] [--backends=neon,simdjson-dom]
+ *                    [--workloads=traverse,sum] [--paths=N]
+ *                    [--iterations=N] [--results=DIR]
  */
 
-// Use single-header simdjson if available
+// Use single-header simdjson if available; without it the simdjson rows are skipped
 #if __has_include("competitors/simdjson/singleheader/simdjson.h")
     #include "competitors/simdjson/singleheader/simdjson.h"
+    #define BENCH_HAVE_SIMDJSON 1
 #elif __has_include("simdjson.h")
     #include "simdjson.h"
-#else
-    #error "simdjson.h not found. Clone simdjson to competitors/simdjson/"
+    #define BENCH_HAVE_SIMDJSON 1
 #endif
 
+#include "../neon/neon_json.h"
+#include "../metal/metal_bridge.h"
+
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <dlfcn.h>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
 namespace fs = std::filesystem;
 
 const int WARMUP_ITERATIONS = 3;
-const int BENCH_ITERATIONS = 10;
+const int MIN_ITERATIONS = 20;          // Enough samples for a meaningful p99
+const int MAX_ITERATIONS = 1000;
+const double TIME_BUDGET_NS = 250e6;    // Per backend and file, after MIN_ITERATIONS
+const size_t MAX_FILE_SIZE = 20 * 1024 * 1024;
+const size_t DEFAULT_PATHS = 8;         // JSON Pointers per document (paths workload)
+
+/* Column order shared by the CSV header, the JSON keys and run_all.sh */
+const char* const SCHEMA[] = {
+    "harness", "backend", "workload", "file", "bytes", "iterations", "checksum",
+    "median_ns", "p99_ns", "gb_per_s", "stage1_gb_per_s", "stage2_gb_per_s",
+    "cycles_per_byte", "instructions_per_byte", "cache_misses_per_kb",
+};
+
+static uint64_t now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// =============================================================================
+// Hardware Counters
+// =============================================================================
+
+struct CounterValues {
+    double cycles = NAN;
+    double instructions = NAN;
+    double cache_misses = NAN;
+};
+
+#if defined(__linux__)
+
+/**
+ * Cycles, instructions and cache misses of this thread (user space only),
+ * as one perf_event_open group so all three cover the same interval.
+ */
+class HardwareCounters {
+public:
+    HardwareCounters() {
+        const uint64_t configs[3] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+        };
+        for (int i = 0; i < 3; i++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[i];
+            attr.disabled = i == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            fds_[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0);
+            if (fds_[i] < 0) break;
+            count_ = i + 1;
+        }
+        // Cache misses are optional (not every PMU exposes them)
+        if (count_ < 2) close_all();
+    }
+
+    ~HardwareCounters() { close_all(); }
+
+    bool available() const { return count_ >= 2; }
+    const char* name() const { return "perf_event_open"; }
+
+    void start() {
+        if (!available()) return;
+        ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    CounterValues stop() {
+        CounterValues v;
+        if (!available()) return v;
+        ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t buf[1 + 3];
+        if (read(fds_[0], buf, sizeof(buf)) < (ssize_t)sizeof(uint64_t)) return v;
+        v.cycles = (double)buf[1];
+        v.instructions = (double)buf[2];
+        if (buf[0] >= 3) v.cache_misses = (double)buf[3];
+        return v;
+    }
+
+private:
+    void close_all() {
+        for (int i = 0; i < count_; i++) close(fds_[i]);
+        count_ = 0;
+    }
+
+    int fds_[3] = {-1, -1, -1};
+    int count_ = 0;
+};
+
+#elif defined(__APPLE__)
+
+/**
+ * Fixed cycle / instruction counters of this thread via the private
+ * kperf framework (loaded at runtime; kpc_force_all_ctrs_set needs root).
+ * Configurable events such as cache misses would need kperfdata's event
+ * database, so that column stays empty on macOS.
+ */
+class HardwareCounters {
+public:
+    HardwareCounters() {
+        lib_ = dlopen("/System/Library/PrivateFrameworks/kperf.framework/kperf", RTLD_LAZY);
+        if (!lib_) return;
+        auto force_all = (int (*)(int))dlsym(lib_, "kpc_force_all_ctrs_set");
+        auto set_counting = (int (*)(uint32_t))dlsym(lib_, "kpc_set_counting");
+        auto set_thread_counting = (int (*)(uint32_t))dlsym(lib_, "kpc_set_thread_counting");
+        get_thread_counters_ = (int (*)(uint32_t, uint32_t, uint64_t*))
+            dlsym(lib_, "kpc_get_thread_counters");
+        if (!force_all || !set_counting || !set_thread_counting || !get_thread_counters_) return;
+        if (force_all(1) != 0) return;
+        if (set_counting(KPC_CLASS_FIXED_MASK) != 0) return;
+        if (set_thread_counting(KPC_CLASS_FIXED_MASK) != 0) return;
+        ok_ = true;
+    }
+
+    ~HardwareCounters() {
+        if (lib_) dlclose(lib_);
+    }
+
+    bool available() const { return ok_; }
+    const char* name() const { return "kperf"; }
+
+    void start() {
+        if (ok_) get_thread_counters_(0, KPC_MAX_COUNTERS, start_);
+    }
+
+    CounterValues stop() {
+        CounterValues v;
+        if (!ok_) return v;
+        uint64_t end[KPC_MAX_COUNTERS];
+        if (get_thread_counters_(0, KPC_MAX_COUNTERS, end) != 0) return v;
+        // Fixed counters: 0 = cycles, 1 = instructions (Apple silicon)
+        v.cycles = (double)(end[0] - start_[0]);
+        v.instructions = (double)(end[1] - start_[1]);
+        return v;
+    }
+
+private:
+    static const uint32_t KPC_CLASS_FIXED_MASK = 1u << 0;
+    static const uint32_t KPC_MAX_COUNTERS = 32;
+
+    void* lib_ = nullptr;
+    int (*get_thread_counters_)(uint32_t, uint32_t, uint64_t*) = nullptr;
+    uint64_t start_[KPC_MAX_COUNTERS] = {};
+    bool ok_ = false;
+};
+
+#else
+
+class HardwareCounters {
+public:
+    bool available() const { return false; }
+    const char* name() const { return "none"; }
+    void start() {}
+    CounterValues stop() { return CounterValues(); }
+};
+
+#endif
+
+// =============================================================================
+// Workloads
+// =============================================================================
+
+/*
+ * What each backend does with a document. Only traverse / sum / paths /
+ * ndjson force a backend to produce every value, so those are the rows to
+ * compare across backends; "parse" is what each API does by itself (for
+ * simdjson-ondemand that is Stage 1 plus the root type only).
+ */
+enum Workload {
+    WORKLOAD_PARSE,         // Backend's own parse, nothing read back
+    WORKLOAD_TRAVERSE,      // Visit every value, decode every key and string
+    WORKLOAD_SUM,           // Add up every number as a double
+    WORKLOAD_PATHS,         // Look up the document's fixed JSON Pointers
+    WORKLOAD_NDJSON,        // Traverse every record of an NDJSON file
+    WORKLOAD_COUNT
+};
+
+const char* const WORKLOAD_NAMES[WORKLOAD_COUNT] = {
+    "parse", "traverse", "sum", "paths", "ndjson",
+};
+
+/* What a workload saw; every backend must report the same checksum */
+struct Tally {
+    uint64_t values = 0;        // Containers, scalars and object keys
+    uint64_t string_bytes = 0;  // Decoded bytes of keys and strings
+    uint64_t found = 0;         // Paths that matched
+    double sum = 0;
+};
+
+static double checksum(Workload w, const Tally& t) {
+    switch (w) {
+    case WORKLOAD_TRAVERSE:
+    case WORKLOAD_NDJSON:
+        return (double)(t.values + t.string_bytes);
+    case WORKLOAD_SUM:
+        return t.sum;
+    case WORKLOAD_PATHS:
+        return (double)t.found;
+    default:
+        return NAN;
+    }
+}
+
+static bool checksums_agree(double a, double b) {
+    if (std::isnan(a) || std::isnan(b)) return true;
+    return std::fabs(a - b) <= 1e-9 * std::max(std::fabs(a), std::fabs(b));
+}
+
+// =============================================================================
+// Backends
+// =============================================================================
+
+struct Document {
+    const uint8_t* data;
+    size_t size;
+    size_t padded_size;     // Readable bytes (json_mmap_mapped_length)
+    bool ndjson;            // .ndjson file: only WORKLOAD_NDJSON applies
+    std::vector<std::string> paths;         // WORKLOAD_PATHS queries
+    std::vector<const char*> path_ptrs;
+};
+
+/* Per-parse stage split in ns; 0 when the backend cannot separate them */
+struct StageTimes {
+    uint64_t stage1_ns = 0;
+    uint64_t stage2_ns = 0;
+};
+
+class Backend {
+public:
+    virtual ~Backend() = default;
+    virtual const char* name() const = 0;
+    virtual bool supports(Workload w) const = 0;
+
+    /** Called once per file before warmup (e.g. to register the mapping). */
+    virtual void prepare(const Document&) {}
+    virtual void finish(const Document&) {}
+
+    /**
+     * Run workload w on doc once, filling stages if the backend can split
+     * them and tally with what it saw.
+     * @return false if the document was rejected
+     */
+    virtual bool run(Workload w, const Document& doc, StageTimes& stages, Tally& tally) = 0;
+};
+
+/* Reusable json_build_tape output, grown to the worst case for n structurals */
+class TapeBuffers {
+public:
+    bool build(const Document& doc, const uint32_t* positions, size_t n) {
+        if (tape_.size() < JSON_TAPE_MAX_ENTRIES(n)) tape_.resize(JSON_TAPE_MAX_ENTRIES(n));
+        if (strings_.size() < JSON_TAPE_STRING_BOUND(n)) strings_.resize(JSON_TAPE_STRING_BOUND(n));
+        size_t strings_len = 0;
+        int64_t entries = json_build_tape(doc.data, doc.size, positions, n,
+                                          tape_.data(), tape_.size(),
+                                          strings_.data(), strings_.size(), &strings_len);
+        entries_ = entries > 0 ? (size_t)entries : 0;
+        return entries > 0;
+    }
+
+    const uint64_t* tape() const { return tape_.data(); }
+    const uint8_t* strings() const { return strings_.data(); }
+    size_t entries() const { return entries_; }
+
+private:
+    std::vector<uint64_t> tape_;
+    std::vector<uint8_t> strings_;
+    size_t entries_ = 0;
+};
+
+static inline uint8_t tape_tag(uint64_t entry) { return (uint8_t)(entry >> 56); }
+static inline size_t tape_payload(uint64_t entry) { return (size_t)(entry & 0x00FFFFFFFFFFFFFFULL); }
+
+static inline uint32_t read_u32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * Tape equivalent of visiting every value: one linear pass, numbers read
+ * from their raw entries, escaped strings decoded into scratch when
+ * decode is set. source is what the string refs are relative to.
+ */
+static bool walk_tape(const uint64_t* tape, size_t n, const uint8_t* strings,
+                      const uint8_t* source, bool decode, std::vector<uint8_t>& scratch,
+                      Tally& t) {
+    for (size_t i = 1; i < n; i++) {
+        uint8_t tag = tape_tag(tape[i]);
+        switch (tag) {
+        case JSON_TAPE_STRING: {
+            t.values++;
+            if (!decode) break;
+            const uint8_t* ref = strings + tape_payload(tape[i]);
+            uint32_t start = read_u32(ref), len = read_u32(ref + 4);
+            if (ref[8] & JSON_TAPE_STRING_ESCAPED) {
+                if (scratch.size() < len) scratch.resize(len);
+                int64_t decoded = json_unescape_string(source + start, len, scratch.data());
+                if (decoded < 0) return false;
+                t.string_bytes += (uint64_t)decoded;
+            } else {
+                t.string_bytes += len;
+            }
+            break;
+        }
+        case JSON_TAPE_INT64:
+            t.values++;
+            t.sum += (double)(int64_t)tape[++i];
+            break;
+        case JSON_TAPE_DOUBLE: {
+            double d;
+            memcpy(&d, &tape[++i], sizeof(d));
+            t.values++;
+            t.sum += d;
+            break;
+        }
+        case JSON_TAPE_START_ARRAY:
+        case JSON_TAPE_START_OBJECT:
+        case JSON_TAPE_TRUE:
+        case JSON_TAPE_FALSE:
+        case JSON_TAPE_NULL:
+            t.values++;
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+static void append_pointer_token(std::string& pointer, const uint8_t* s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '~') {
+            pointer += "~0";
+        } else if (s[i] == '/') {
+            pointer += "~1";
+        } else {
+            pointer += (char)s[i];
+        }
+    }
+}
+
+/**
+ * The fixed paths of a document: `count` JSON Pointers spread evenly over
+ * its scalar leaves (leaf k * L / count of L, in document order), skipping
+ * leaves below keys that contain escapes. bench_neon.mojo derives the same
+ * list from its tape, so both harnesses ask the same questions.
+ */
+static std::vector<std::string> pick_paths(const TapeBuffers& tb, const uint8_t* source,
+                                           size_t count) {
+    struct Frame {
+        bool object;
+        bool escaped;       // Some key on the way here had escapes
+        size_t next_index;
+        size_t prefix;      // Length of the container's own pointer
+    };
+    const uint64_t* tape = tb.tape();
+    std::vector<std::string> leaves;
+    std::vector<Frame> stack;
+    std::string pointer;
+
+    size_t i = 1;
+    while (i < tb.entries()) {
+        uint8_t tag = tape_tag(tape[i]);
+        if (tag == JSON_TAPE_END_ARRAY || tag == JSON_TAPE_END_OBJECT) {
+            stack.pop_back();
+            i++;
+            continue;
+        }
+
+        bool escaped = false;
+        if (!stack.empty()) {
+            Frame& f = stack.back();
+            pointer.resize(f.prefix);
+            pointer += '/';
+            escaped = f.escaped;
+            if (f.object) {
+                const uint8_t* ref = tb.strings() + tape_payload(tape[i]);
+                append_pointer_token(pointer, source + read_u32(ref), read_u32(ref + 4));
+                escaped |= (ref[8] & JSON_TAPE_STRING_ESCAPED) != 0;
+                tag = tape_tag(tape[++i]);
+            } else {
+                pointer += std::to_string(f.next_index++);
+            }
+        }
+
+        if (tag == JSON_TAPE_START_ARRAY || tag == JSON_TAPE_START_OBJECT) {
+            stack.push_back({tag == JSON_TAPE_START_OBJECT, escaped, 0, pointer.size()});
+            i++;
+            continue;
+        }
+        if (!escaped) leaves.push_back(pointer);
+        i += (tag == JSON_TAPE_INT64 || tag == JSON_TAPE_DOUBLE) ? 2 : 1;
+    }
+
+    if (leaves.size() <= count) return leaves;
+    std::vector<std::string> picked;
+    for (size_t k = 0; k < count; k++) picked.push_back(leaves[k * leaves.size() / count]);
+    return picked;
+}
+
+#if defined(BENCH_HAVE_SIMDJSON)
+
+static_assert(JSON_MMAP_PADDING >= simdjson::SIMDJSON_PADDING,
+              "mapped padding must cover simdjson's overreads");
+
+/* Visit every value below v (a document, document_reference or value) */
+template <class V>
+static bool visit_ondemand(V&& v, bool decode, Tally& t) {
+    using simdjson::ondemand::json_type;
+    json_type type;
+    if (v.type().get(type)) return false;
+    t.values++;
+    switch (type) {
+    case json_type::array: {
+        simdjson::ondemand::array array;
+        if (v.get_array().get(array)) return false;
+        for (auto element : array) {
+            simdjson::ondemand::value child;
+            if (element.get(child) || !visit_ondemand(child, decode, t)) return false;
+        }
+        return true;
+    }
+    case json_type::object: {
+        simdjson::ondemand::object object;
+        if (v.get_object().get(object)) return false;
+        for (auto member : object) {
+            simdjson::ondemand::field field;
+            if (std::move(member).get(field)) return false;
+            t.values++;
+            if (decode) {
+                std::string_view key;
+                if (field.unescaped_key().get(key)) return false;
+                t.string_bytes += key.size();
+            }
+            if (!visit_ondemand(field.value(), decode, t)) return false;
+        }
+        return true;
+    }
+    case json_type::string: {
+        if (!decode) return true;
+        std::string_view s;
+        if (v.get_string().get(s)) return false;
+        t.string_bytes += s.size();
+        return true;
+    }
+    case json_type::number: {
+        double d;
+        if (v.get_double().get(d)) return false;
+        t.sum += d;
+        return true;
+    }
+    case json_type::boolean: {
+        bool b;
+        return !v.get_bool().get(b);
+    }
+    case json_type::null: {
+        bool is_null;
+        return !v.is_null().get(is_null) && is_null;
+    }
+    default:
+        return false;
+    }
+}
+
+class SimdjsonOndemandBackend : public Backend {
+public:
+    const char* name() const override { return "simdjson-ondemand"; }
+    bool supports(Workload) const override { return true; }
+
+    bool run(Workload w, const Document& doc, StageTimes&, Tally& t) override {
+        if (w == WORKLOAD_NDJSON) {
+            simdjson::ondemand::document_stream stream;
+            if (parser_.iterate_many(doc.data, doc.size).get(stream)) return false;
+            for (auto result : stream) {
+                simdjson::ondemand::document_reference record;
+                if (std::move(result).get(record) || !visit_ondemand(record, true, t)) return false;
+            }
+            return true;
+        }
+
+        simdjson::padded_string_view view(reinterpret_cast<const char*>(doc.data),
+                                          doc.size, doc.padded_size);
+        simdjson::ondemand::document d;
+        if (parser_.iterate(view).get(d)) return false;
+        switch (w) {
+        case WORKLOAD_TRAVERSE:
+            return visit_ondemand(d, true, t);
+        case WORKLOAD_SUM:
+            return visit_ondemand(d, false, t);
+        case WORKLOAD_PATHS:
+            // at_pointer rewinds, so each lookup scans from the start
+            for (const auto& path : doc.paths) {
+                simdjson::ondemand::value v;
+                if (!d.at_pointer(path).get(v)) t.found++;
+            }
+            return true;
+        default: {
+            // iterate() runs Stage 1; Stage 2 is lazy, so only the root is touched
+            simdjson::ondemand::json_type type;
+            return !d.type().get(type);
+        }
+        }
+    }
+
+private:
+    simdjson::ondemand::parser parser_;
+};
+
+static bool visit_dom(simdjson::dom::element e, bool decode, Tally& t) {
+    using simdjson::dom::element_type;
+    t.values++;
+    switch (e.type()) {
+    case element_type::ARRAY:
+        for (simdjson::dom::element child : simdjson::dom::array(e)) {
+            if (!visit_dom(child, decode, t)) return false;
+        }
+        return true;
+    case element_type::OBJECT:
+        for (simdjson::dom::key_value_pair field : simdjson::dom::object(e)) {
+            t.values++;
+            if (decode) t.string_bytes += field.key.size();
+            if (!visit_dom(field.value, decode, t)) return false;
+        }
+        return true;
+    case element_type::STRING:
+        if (decode) t.string_bytes += std::string_view(e).size();
+        return true;
+    case element_type::INT64:
+    case element_type::UINT64:
+    case element_type::DOUBLE:
+        t.sum += double(e);
+        return true;
+    default:
+        return true;
+    }
+}
+
+/**
+ * DOM parse through the implementation's stage1 / stage2, which
+ * dom::parser exposes for benchmarking; the sum equals parser.parse.
+ */
+class SimdjsonDomBackend : public Backend {
+public:
+    const char* name() const override { return "simdjson-dom"; }
+    bool supports(Workload) const override { return true; }
+
+    void prepare(const Document& doc) override {
+        // A full parse sizes both the implementation and parser.doc
+        if (!doc.ndjson) (void)parser_.parse(doc.data, doc.size, false).error();
+    }
+
+    bool run(Workload w, const Document& doc, StageTimes& stages, Tally& t) override {
+        if (w == WORKLOAD_NDJSON) {
+            simdjson::dom::document_stream stream;
+            if (parser_.parse_many(doc.data, doc.size).get(stream)) return false;
+            for (auto result : stream) {
+                simdjson::dom::element record;
+                if (result.get(record) || !visit_dom(record, true, t)) return false;
+            }
+            return true;
+        }
+
+        uint64_t t0 = now_ns();
+        if (parser_.implementation->stage1(doc.data, doc.size,
+                                           simdjson::stage1_mode::regular)) {
+            return false;
+        }
+        uint64_t t1 = now_ns();
+        if (parser_.implementation->stage2(parser_.doc)) return false;
+        uint64_t t2 = now_ns();
+        stages.stage1_ns = t1 - t0;
+        stages.stage2_ns = t2 - t1;
+
+        simdjson::dom::element root = parser_.doc.root();
+        switch (w) {
+        case WORKLOAD_TRAVERSE:
+            return visit_dom(root, true, t);
+        case WORKLOAD_SUM:
+            return visit_dom(root, false, t);
+        case WORKLOAD_PATHS:
+            for (const auto& path : doc.paths) {
+                if (!root.at_pointer(path).error()) t.found++;
+            }
+            return true;
+        default:
+            return true;
+        }
+    }
+
+private:
+    simdjson::dom::parser parser_;
+};
+
+#endif  // BENCH_HAVE_SIMDJSON
+
+/* json_ndjson_parse_parallel consumer: walk every record's tape */
+struct NdjsonWalk {
+    const uint8_t* input;
+    std::vector<uint8_t>* scratch;
+    Tally* tally;
+    bool ok;
+};
+
+static int walk_records(void* user, const JsonNdjsonRecord* records, size_t count) {
+    NdjsonWalk* w = (NdjsonWalk*)user;
+    for (size_t i = 0; i < count; i++) {
+        const JsonNdjsonRecord& r = records[i];
+        if (r.status < 0 ||
+            !walk_tape(r.tape, (size_t)r.status, r.strings, w->input + r.start, true,
+                       *w->scratch, *w->tally)) {
+            w->ok = false;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+class NeonBackend : public Backend {
+public:
+    NeonBackend() : ctx_(neon_json_init()) {}
+    ~NeonBackend() override { neon_json_free(ctx_); }
+
+    bool ok() const { return ctx_ != nullptr; }
+    const char* name() const override { return "neon"; }
+    bool supports(Workload) const override { return true; }
+
+    bool run(Workload w, const Document& doc, StageTimes& stages, Tally& t) override {
+        if (w == WORKLOAD_PATHS) {
+            // Tape-less: one Stage 1 pass that stops once every path matched
+            spans_.resize(doc.paths.size());
+            int64_t found = json_query_paths(ctx_, doc.data, doc.size, doc.path_ptrs.data(),
+                                             doc.path_ptrs.size(), spans_.data());
+            if (found < 0) return false;
+            t.found = (uint64_t)found;
+            return true;
+        }
+        if (w == WORKLOAD_NDJSON) {
+            // Worker threads: one per online CPU
+            NdjsonWalk walk = {doc.data, &scratch_, &t, true};
+            return json_ndjson_parse_parallel(ctx_, doc.data, doc.size, 0, 0,
+                                              walk_records, &walk) >= 0 && walk.ok;
+        }
+
+        uint64_t t0 = now_ns();
+        int64_t n = neon_json_find_structural_arena(ctx_, doc.data, doc.size);
+        if (n < 0) return false;
+        uint64_t t1 = now_ns();
+        if (!tape_.build(doc, neon_json_arena_positions(ctx_), (size_t)n)) return false;
+        uint64_t t2 = now_ns();
+        stages.stage1_ns = t1 - t0;
+        stages.stage2_ns = t2 - t1;
+
+        if (w == WORKLOAD_PARSE) return true;
+        return walk_tape(tape_.tape(), tape_.entries(), tape_.strings(), doc.data,
+                         w == WORKLOAD_TRAVERSE, scratch_, t);
+    }
+
+private:
+    NeonContext* ctx_;
+    TapeBuffers tape_;
+    std::vector<uint8_t> scratch_;
+    std::vector<JsonSpan> spans_;
+};
+
+/**
+ * GPU Stage 1 plus CPU json_build_tape. The bridge is dlopen'ed from
+ * $METAL_JSON_LIB (as src/metal_ffi.mojo does) or ../metal, so the driver
+ * builds and runs without it; the mapping is registered for no-copy
+ * binding when it is page-aligned. Paths and NDJSON have no GPU entry
+ * point here, so those rows are left to the CPU backends.
+ */
+class MetalBackend : public Backend {
+public:
+    MetalBackend() {
+        std::string dir = std::getenv("METAL_JSON_LIB") ? std::getenv("METAL_JSON_LIB") : "../metal";
+        lib_ = dlopen((dir + "/libmetal_bridge.dylib").c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!lib_) return;
+        init_ = (decltype(init_))dlsym(lib_, "metal_json_init");
+        free_ = (decltype(free_))dlsym(lib_, "metal_json_free");
+        has_pipeline_ = (decltype(has_pipeline_))dlsym(lib_, "metal_json_has_gpjson_pipeline");
+        stage1_ = (decltype(stage1_))dlsym(lib_, "metal_json_full_stage1_borrowed");
+        register_ = (decltype(register_))dlsym(lib_, "metal_json_register_input");
+        unregister_ = (decltype(unregister_))dlsym(lib_, "metal_json_unregister_input");
+        if (!init_ || !free_ || !has_pipeline_ || !stage1_ || !register_ || !unregister_) return;
+        ctx_ = init_((dir + "/json_classify.metallib").c_str());
+        if (ctx_ && !has_pipeline_(ctx_)) {
+            free_(ctx_);
+            ctx_ = nullptr;
+        }
+    }
+
+    ~MetalBackend() override {
+        if (ctx_) free_(ctx_);
+        if (lib_) dlclose(lib_);
+    }
+
+    bool ok() const { return ctx_ != nullptr; }
+    const char* name() const override { return "metal"; }
+
+    bool supports(Workload w) const override {
+        return w == WORKLOAD_PARSE || w == WORKLOAD_TRAVERSE || w == WORKLOAD_SUM;
+    }
+
+    void prepare(const Document& doc) override {
+        (void)register_(ctx_, doc.data, doc.padded_size);
+    }
+
+    void finish(const Document&) override { unregister_(ctx_); }
+
+    bool run(Workload w, const Document& doc, StageTimes& stages, Tally& t) override {
+        const uint32_t* positions = nullptr;
+        const uint8_t* chars = nullptr;
+        uint32_t n = 0;
+        uint64_t t0 = now_ns();
+        if (stage1_(ctx_, doc.data, (uint32_t)doc.size, &positions, &chars, &n) != 0) return false;
+        uint64_t t1 = now_ns();
+        if (!tape_.build(doc, positions, n)) return false;
+        uint64_t t2 = now_ns();
+        stages.stage1_ns = t1 - t0;
+        stages.stage2_ns = t2 - t1;
+
+        if (w == WORKLOAD_PARSE) return true;
+        return walk_tape(tape_.tape(), tape_.entries(), tape_.strings(), doc.data,
+                         w == WORKLOAD_TRAVERSE, scratch_, t);
+    }
+
+private:
+    void* lib_ = nullptr;
+    MetalContext* ctx_ = nullptr;
+    decltype(&metal_json_init) init_ = nullptr;
+    decltype(&metal_json_free) free_ = nullptr;
+    decltype(&metal_json_has_gpjson_pipeline) has_pipeline_ = nullptr;
+    decltype(&metal_json_full_stage1_borrowed) stage1_ = nullptr;
+    decltype(&metal_json_register_input) register_ = nullptr;
+    decltype(&metal_json_unregister_input) unregister_ = nullptr;
+    TapeBuffers tape_;
+    std::vector<uint8_t> scratch_;
+};
+
+// =============================================================================
+// Measurement
+// =============================================================================
 
 struct BenchResult {
+    std::string backend;
+    std::string workload;
     std::string file;
-    size_t file_size;
-    double parse_time_ms;
-    double throughput_mb_s;
+    size_t bytes;
+    size_t iterations;
+    double checksum;            // NAN for WORKLOAD_PARSE
+    double median_ns;
+    double p99_ns;
+    double gb_per_s;
+    double stage1_gb_per_s;     // NAN when not split
+    double stage2_gb_per_s;
+    double cycles_per_byte;     // NAN without counters
+    double instructions_per_byte;
+    double cache_misses_per_kb;
 };
 
-std::string read_file(const fs::path& path) {
-    std::ifstream file(path, std::ios::binary);
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    return ss.str();
+static double median_of(std::vector<uint64_t>& v) {
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? (double)v[n / 2] : ((double)v[n / 2 - 1] + (double)v[n / 2]) / 2.0;
 }
 
-double benchmark_parse(simdjson::ondemand::parser& parser,
-                       simdjson::padded_string& json_content,
-                       int iterations) {
-    double total_time = 0;
+/* Nearest-rank percentile of sorted samples */
+static double percentile_of(const std::vector<uint64_t>& sorted, double p) {
+    size_t rank = (size_t)std::ceil(p * (double)sorted.size());
+    return (double)sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+/**
+ * Warm up, then time runs until MIN_ITERATIONS and TIME_BUDGET_NS are
+ * both reached (or exactly `iterations` when given). Counters cover the
+ * timed loop only; the checksum comes from the first warmup run.
+ * @return false if the backend rejected the document
+ */
+static bool run_backend(Backend& backend, Workload w, HardwareCounters& counters,
+                        const Document& doc, int iterations, BenchResult& r) {
+    StageTimes stages;
+    backend.prepare(doc);
+    for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+        Tally tally;
+        if (!backend.run(w, doc, stages, tally)) {
+            backend.finish(doc);
+            return false;
+        }
+        if (i == 0) r.checksum = checksum(w, tally);
+    }
 
-    for (int i = 0; i < iterations; i++) {
-        auto start = std::chrono::high_resolution_clock::now();
+    std::vector<uint64_t> total, stage1, stage2;
+    int max_iterations = iterations > 0 ? iterations : MAX_ITERATIONS;
+    total.reserve(max_iterations);
+    stage1.reserve(max_iterations);
+    stage2.reserve(max_iterations);
 
-        // Parse with on-demand API
-        auto doc = parser.iterate(json_content);
+    double elapsed = 0;
+    counters.start();
+    for (int i = 0; i < max_iterations; i++) {
+        if (iterations <= 0 && i >= MIN_ITERATIONS && elapsed >= TIME_BUDGET_NS) break;
+        Tally tally;
+        uint64_t t0 = now_ns();
+        backend.run(w, doc, stages, tally);
+        uint64_t t = now_ns() - t0;
+        total.push_back(t);
+        stage1.push_back(stages.stage1_ns);
+        stage2.push_back(stages.stage2_ns);
+        elapsed += (double)t;
+    }
+    CounterValues c = counters.stop();
+    backend.finish(doc);
 
-        // Force parsing by accessing root element
-        // (simdjson is lazy, so we need to trigger actual parsing)
-        simdjson::ondemand::json_type type = doc.type();
-        (void)type;
+    double bytes = (double)doc.size;
+    double processed = bytes * (double)total.size();
+    r.bytes = doc.size;
+    r.iterations = total.size();
+    r.median_ns = median_of(total);
+    r.p99_ns = percentile_of(total, 0.99);
+    r.gb_per_s = bytes / r.median_ns;   // bytes per ns = GB/s
+    double s1 = median_of(stage1), s2 = median_of(stage2);
+    r.stage1_gb_per_s = s1 > 0 ? bytes / s1 : NAN;
+    r.stage2_gb_per_s = s2 > 0 ? bytes / s2 : NAN;
+    r.cycles_per_byte = c.cycles / processed;
+    r.instructions_per_byte = c.instructions / processed;
+    r.cache_misses_per_kb = c.cache_misses / processed * 1024.0;
+    return true;
+}
 
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        total_time += duration.count() / 1000.0;  // Convert to ms
+/* Fill doc.paths from the NEON tape (see pick_paths) */
+static void derive_paths(Document& doc, size_t count) {
+    NeonContext* ctx = neon_json_init();
+    TapeBuffers tb;
+    int64_t n = ctx ? neon_json_find_structural_arena(ctx, doc.data, doc.size) : -1;
+    if (n >= 0 && tb.build(doc, neon_json_arena_positions(ctx), (size_t)n)) {
+        doc.paths = pick_paths(tb, doc.data, std::min<size_t>(count, JSON_QUERY_MAX_PATHS));
     }
+    neon_json_free(ctx);
+    for (const auto& path : doc.paths) doc.path_ptrs.push_back(path.c_str());
+}
+
+// =============================================================================
+// Output
+// =============================================================================
 
-    return total_time / iterations;
+static std::string csv_number(double v, int precision) {
+    if (std::isnan(v)) return "";
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(precision) << v;
+    return s.str();
 }
 
-double benchmark_parse_dom(simdjson::dom::parser& parser,
-                           const std::string& json_content,
-                           int iterations) {
-    double total_time = 0;
+static std::string json_number(double v, int precision) {
+    return std::isnan(v) ? "null" : csv_number(v, precision);
+}
 
-    for (int i = 0; i < iterations; i++) {
-        auto start = std::chrono::high_resolution_clock::now();
+/* Row values in SCHEMA order, numbers formatted by fmt */
+static std::vector<std::string> row_values(const BenchResult& r,
+                                           std::string (*fmt)(double, int)) {
+    return {
+        "native", r.backend, r.workload, r.file,
+        std::to_string(r.bytes), std::to_string(r.iterations), fmt(r.checksum, 6),
+        fmt(r.median_ns, 0), fmt(r.p99_ns, 0), fmt(r.gb_per_s, 3),
+        fmt(r.stage1_gb_per_s, 3), fmt(r.stage2_gb_per_s, 3),
+        fmt(r.cycles_per_byte, 3), fmt(r.instructions_per_byte, 3),
+        fmt(r.cache_misses_per_kb, 3),
+    };
+}
 
-        // Parse with DOM API (full parse)
-        auto doc = parser.parse(json_content);
+static void save_results(const std::vector<BenchResult>& results, const fs::path& dir) {
+    const size_t columns = sizeof(SCHEMA) / sizeof(SCHEMA[0]);
+    fs::create_directories(dir);
 
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        total_time += duration.count() / 1000.0;
+    std::ofstream csv(dir / "native_benchmarks.csv");
+    for (size_t i = 0; i < columns; i++) csv << (i ? "," : "") << SCHEMA[i];
+    csv << "\n";
+    for (const auto& r : results) {
+        auto values = row_values(r, csv_number);
+        for (size_t i = 0; i < columns; i++) csv << (i ? "," : "") << values[i];
+        csv << "\n";
+    }
+
+    // Strings in the schema (harness .. file) are the first 4 columns
+    std::ofstream json(dir / "native_benchmarks.json");
+    json << "[\n";
+    for (size_t k = 0; k < results.size(); k++) {
+        auto values = row_values(results[k], json_number);
+        json << "  {";
+        for (size_t i = 0; i < columns; i++) {
+            json << (i ? ", " : "") << "\"" << SCHEMA[i] << "\": ";
+            if (i < 4) {
+                json << "\"" << values[i] << "\"";
+            } else {
+                json << values[i];
+            }
+        }
+        json << "}" << (k + 1 < results.size() ? "," : "") << "\n";
     }
+    json << "]\n";
 
-    return total_time / iterations;
+    std::cout << std::endl << "Results saved to: " << (dir / "native_benchmarks.csv").string()
+              << " and .json" << std::endl;
+}
+
+static std::string size_string(size_t size) {
+    if (size < 1024 * 1024) return std::to_string(size / 1024) + " KB";
+    return std::to_string(size / 1024 / 1024) + " MB";
+}
+
+static bool name_selected(const std::string& list, const char* name) {
+    if (list.empty()) return true;
+    std::stringstream s(list);
+    std::string item;
+    while (std::getline(s, item, ',')) {
+        if (item == name) return true;
+    }
+    return false;
 }
 
 int main(int argc, char* argv[]) {
     fs::path data_dir = "data";
+    fs::path results_dir = "results";
+    std::string backend_list;
+    std::string workload_list;
+    int iterations = 0;
+    size_t path_count = DEFAULT_PATHS;
 
-    // Allow custom data directory
-    if (argc > 1) {
-        data_dir = argv[1];
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--backends=", 0) == 0) {
+            backend_list = arg.substr(11);
+        } else if (arg.rfind("--workloads=", 0) == 0) {
+            workload_list = arg.substr(12);
+        } else if (arg.rfind("--iterations=", 0) == 0) {
+            iterations = std::atoi(arg.c_str() + 13);
+        } else if (arg.rfind("--paths=", 0) == 0) {
+            path_count = (size_t)std::max(1, std::atoi(arg.c_str() + 8));
+        } else if (arg.rfind("--results=", 0) == 0) {
+            results_dir = arg.substr(10);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        } else {
+            data_dir = arg;
+        }
     }
 
     if (!fs::exists(data_dir)) {
@@ -110,111 +1042,181 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Print header
-    std::cout << "simdjson Benchmark" << std::endl;
-    std::cout << std::string(60, '=') << std::endl;
-    std::cout << "Implementation: " << simdjson::get_active_implementation()->name() << std::endl;
-    std::cout << "Description: " << simdjson::get_active_implementation()->description() << std::endl;
-    std::cout << "Iterations: " << BENCH_ITERATIONS << " (warmup: " << WARMUP_ITERATIONS << ")" << std::endl;
-    std::cout << std::endl;
+    // Backends that are compiled in, load and were asked for
+    std::vector<std::unique_ptr<Backend>> backends;
+#if defined(BENCH_HAVE_SIMDJSON)
+    backends.emplace_back(new SimdjsonOndemandBackend());
+    backends.emplace_back(new SimdjsonDomBackend());
+#endif
+    {
+        auto neon = std::make_unique<NeonBackend>();
+        if (neon->ok()) backends.push_back(std::move(neon));
+        auto metal = std::make_unique<MetalBackend>();
+        if (metal->ok()) backends.push_back(std::move(metal));
+    }
+    backends.erase(std::remove_if(backends.begin(), backends.end(),
+                                  [&](const std::unique_ptr<Backend>& b) {
+                                      return !name_selected(backend_list, b->name());
+                                  }),
+                   backends.end());
+    if (backends.empty()) {
+        std::cerr << "Error: no backend available (--backends=" << backend_list << ")" << std::endl;
+        return 1;
+    }
 
-    std::cout << std::string(80, '=') << std::endl;
-    std::cout << std::left << std::setw(30) << "File"
-              << std::right << std::setw(12) << "Size"
-              << std::setw(10) << "API"
-              << std::setw(12) << "Parse (ms)"
-              << std::setw(12) << "MB/s" << std::endl;
-    std::cout << std::string(80, '=') << std::endl;
+    std::vector<Workload> workloads;
+    for (int w = 0; w < WORKLOAD_COUNT; w++) {
+        if (name_selected(workload_list, WORKLOAD_NAMES[w])) workloads.push_back((Workload)w);
+    }
+    if (workloads.empty()) {
+        std::cerr << "Error: no workload selected (--workloads=" << workload_list << ")" << std::endl;
+        return 1;
+    }
 
-    std::vector<BenchResult> results;
+    HardwareCounters counters;
 
-    // Create parsers
-    simdjson::ondemand::parser ondemand_parser;
-    simdjson::dom::parser dom_parser;
+    // Print header
+    std::cout << "Native JSON Benchmark" << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+    std::cout << "Backends:";
+    for (const auto& b : backends) std::cout << " " << b->name();
+    std::cout << std::endl << "Workloads:";
+    for (Workload w : workloads) std::cout << " " << WORKLOAD_NAMES[w];
+    std::cout << " (" << path_count << " paths per document)" << std::endl;
+#if defined(BENCH_HAVE_SIMDJSON)
+    std::cout << "simdjson: " << simdjson::get_active_implementation()->name() << std::endl;
+#endif
+    {
+        NeonContext* ctx = neon_json_init();
+        std::cout << "neon kernel: " << (ctx ? neon_json_kernel_name(ctx) : "unavailable") << std::endl;
+        neon_json_free(ctx);
+    }
+    std::cout << "Counters: " << (counters.available() ? counters.name() : "unavailable")
+              << std::endl;
+    if (iterations > 0) {
+        std::cout << "Iterations: " << iterations;
+    } else {
+        std::cout << "Iterations: " << MIN_ITERATIONS << "-" << MAX_ITERATIONS
+                  << " (" << TIME_BUDGET_NS / 1e6 << " ms budget)";
+    }
+    std::cout << " (warmup: " << WARMUP_ITERATIONS << ")" << std::endl << std::endl;
 
-    // Iterate through JSON files
+    std::cout << std::string(118, '=') << std::endl;
+    std::cout << std::left << std::setw(26) << "File"
+              << std::right << std::setw(8) << "Size"
+              << std::setw(9) << "Workload"
+              << std::setw(19) << "Backend"
+              << std::setw(11) << "Median ns"
+              << std::setw(11) << "p99 ns"
+              << std::setw(8) << "GB/s"
+              << std::setw(9) << "S1 GB/s"
+              << std::setw(9) << "S2 GB/s"
+              << std::setw(8) << "cyc/B" << std::endl;
+    std::cout << std::string(118, '=') << std::endl;
+
+    std::vector<fs::path> files;
     for (const auto& entry : fs::directory_iterator(data_dir)) {
-        if (entry.path().extension() != ".json") continue;
+        auto ext = entry.path().extension();
+        if (ext == ".json" || ext == ".ndjson") files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<BenchResult> results;
+    int mismatches = 0;
 
-        std::string filename = entry.path().filename().string();
-        size_t file_size = entry.file_size();
+    for (const auto& path : files) {
+        std::string filename = path.filename().string();
+        size_t file_size = fs::file_size(path);
 
-        // Skip files > 20MB
-        if (file_size > 20 * 1024 * 1024) {
-            std::cout << std::left << std::setw(30) << filename
+        if (file_size > MAX_FILE_SIZE) {
+            std::cout << std::left << std::setw(26) << filename
                       << "  SKIPPED (too large)" << std::endl;
             continue;
         }
 
-        // Read file
-        std::string content = read_file(entry.path());
-        simdjson::padded_string padded_content(content);
-
-        // Warmup
-        for (int i = 0; i < WARMUP_ITERATIONS; i++) {
-            auto doc = ondemand_parser.iterate(padded_content);
-            (void)doc.type();
-        }
-
-        // Benchmark On-Demand API
-        double ondemand_time = benchmark_parse(ondemand_parser, padded_content, BENCH_ITERATIONS);
-        double ondemand_throughput = (file_size / 1024.0 / 1024.0) / (ondemand_time / 1000.0);
-
-        std::string size_str;
-        if (file_size < 1024 * 1024) {
-            size_str = std::to_string(file_size / 1024) + " KB";
-        } else {
-            size_str = std::to_string(file_size / 1024 / 1024) + " MB";
+        // Map file (zero-copy, padded past EOF)
+        JsonMappedFile* mapped = json_mmap_open(path.c_str());
+        if (!mapped) {
+            std::cout << std::left << std::setw(26) << filename
+                      << "  SKIPPED (mmap failed)" << std::endl;
+            continue;
         }
+        Document doc;
+        doc.data = json_mmap_data(mapped);
+        doc.size = json_mmap_size(mapped);
+        doc.padded_size = json_mmap_mapped_length(mapped);
+        doc.ndjson = path.extension() == ".ndjson";
+        if (!doc.ndjson) derive_paths(doc, path_count);
 
-        std::cout << std::left << std::setw(30) << filename
-                  << std::right << std::setw(12) << size_str
-                  << std::setw(10) << "ondemand"
-                  << std::setw(12) << std::fixed << std::setprecision(3) << ondemand_time
-                  << std::setw(12) << std::fixed << std::setprecision(1) << ondemand_throughput
-                  << std::endl;
+        bool first = true;
+        for (Workload w : workloads) {
+            if (doc.ndjson != (w == WORKLOAD_NDJSON)) continue;
+            double reference = NAN;
+            for (const auto& backend : backends) {
+                if (!backend->supports(w)) continue;
+                BenchResult r;
+                r.backend = backend->name();
+                r.workload = WORKLOAD_NAMES[w];
+                r.file = filename;
 
-        // Benchmark DOM API (full parse)
-        double dom_time = benchmark_parse_dom(dom_parser, content, BENCH_ITERATIONS);
-        double dom_throughput = (file_size / 1024.0 / 1024.0) / (dom_time / 1000.0);
+                std::cout << std::left << std::setw(26) << (first ? filename : "")
+                          << std::right << std::setw(8) << (first ? size_string(file_size) : "")
+                          << std::setw(9) << r.workload
+                          << std::setw(19) << r.backend;
+                first = false;
 
-        std::cout << std::left << std::setw(30) << ""
-                  << std::right << std::setw(12) << ""
-                  << std::setw(10) << "dom"
-                  << std::setw(12) << std::fixed << std::setprecision(3) << dom_time
-                  << std::setw(12) << std::fixed << std::setprecision(1) << dom_throughput
-                  << std::endl;
+                if (!run_backend(*backend, w, counters, doc, iterations, r)) {
+                    std::cout << "  REJECTED" << std::endl;
+                    continue;
+                }
+                std::cout << std::setw(11) << csv_number(r.median_ns, 0)
+                          << std::setw(11) << csv_number(r.p99_ns, 0)
+                          << std::setw(8) << csv_number(r.gb_per_s, 2)
+                          << std::setw(9) << csv_number(r.stage1_gb_per_s, 2)
+                          << std::setw(9) << csv_number(r.stage2_gb_per_s, 2)
+                          << std::setw(8) << csv_number(r.cycles_per_byte, 2) << std::endl;
 
-        results.push_back({filename, file_size, dom_time, dom_throughput});
+                // The first backend's checksum is the reference for the others
+                if (std::isnan(reference)) {
+                    reference = r.checksum;
+                } else if (!checksums_agree(reference, r.checksum)) {
+                    std::cout << "  MISMATCH: checksum " << csv_number(r.checksum, 6)
+                              << ", expected " << csv_number(reference, 6) << std::endl;
+                    mismatches++;
+                }
+                results.push_back(r);
+            }
+        }
+        json_mmap_close(mapped);
 
-        std::cout << std::string(80, '-') << std::endl;
+        std::cout << std::string(118, '-') << std::endl;
     }
 
-    // Summary
+    // Summary: mean of per-file median throughput
     std::cout << std::endl;
     std::cout << std::string(60, '=') << std::endl;
-    std::cout << "SUMMARY: Average Parse Throughput (DOM API)" << std::endl;
+    std::cout << "SUMMARY: Average Throughput (median per file)" << std::endl;
     std::cout << std::string(60, '=') << std::endl;
-
-    double total_throughput = 0;
-    for (const auto& r : results) {
-        total_throughput += r.throughput_mb_s;
+    for (Workload w : workloads) {
+        for (const auto& backend : backends) {
+            double sum = 0;
+            int count = 0;
+            for (const auto& r : results) {
+                if (r.backend == backend->name() && r.workload == WORKLOAD_NAMES[w]) {
+                    sum += r.gb_per_s;
+                    count++;
+                }
+            }
+            if (count == 0) continue;
+            std::cout << "  " << std::left << std::setw(10) << WORKLOAD_NAMES[w]
+                      << std::setw(20) << backend->name()
+                      << std::fixed << std::setprecision(2) << sum / count << " GB/s" << std::endl;
+        }
     }
-    double avg_throughput = total_throughput / results.size();
-
-    std::cout << "  simdjson: " << std::fixed << std::setprecision(1)
-              << avg_throughput << " MB/s average" << std::endl;
-
-    // Save results to CSV
-    fs::create_directories("results");
-    std::ofstream csv("results/simdjson_benchmarks.csv");
-    csv << "file,file_size,parse_time_ms,throughput_mb_s" << std::endl;
-    for (const auto& r : results) {
-        csv << r.file << "," << r.file_size << ","
-            << std::fixed << std::setprecision(3) << r.parse_time_ms << ","
-            << std::fixed << std::setprecision(1) << r.throughput_mb_s << std::endl;
+    if (mismatches > 0) {
+        std::cout << std::endl << mismatches << " checksum mismatch(es)" << std::endl;
     }
-    std::cout << std::endl << "Results saved to: results/simdjson_benchmarks.csv" << std::endl;
 
-    return 0;
+    save_results(results, results_dir);
+    return mismatches > 0 ? 2 : 0;
 }
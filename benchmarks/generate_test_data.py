@@ -8,6 +8,7 @@ Creates various JSON files to test different parsing scenarios:
 - String-heavy (text content)
 - Number-heavy (sensor data)
 - Mixed realistic (typical payloads)
+- NDJSON (one record per line, for the ndjson workload)
 
 Sizes: 1KB, 10KB, 100KB, 1MB, 10MB
 """
@@ -162,6 +163,34 @@ def adjust_to_size(data: any, target_bytes: int, generator_func) -> any:
     return data
 
 
+def generate_log_record(i: int) -> dict:
+    """Generate a structured log line (with the odd escaped message)."""
+    level = random.choice(["debug", "info", "info", "info", "warn", "error"])
+    message = random_string(random.randint(20, 80))
+    if random.random() < 0.1:
+        message += ' "quoted" \\path\\to\\file\n'
+    return {
+        "ts": 1735000000000 + i * 17,
+        "level": level,
+        "service": random.choice(["api", "auth", "billing", "search"]),
+        "latency_ms": round(random.uniform(0.1, 250.0), 3),
+        "status": random.choice([200, 200, 200, 201, 404, 500]),
+        "msg": message,
+    }
+
+
+def save_ndjson(records: list, filename: str):
+    """Save records as NDJSON (one compact document per line)."""
+    filepath = DATA_DIR / filename
+    with open(filepath, 'w') as f:
+        for record in records:
+            f.write(json.dumps(record, separators=(',', ':')))
+            f.write("\n")
+
+    size = filepath.stat().st_size
+    print(f"  {filename}: {size:,} bytes ({size/1024:.1f} KB)")
+
+
 def save_json(data: any, filename: str, pretty: bool = False):
     """Save JSON to file."""
     filepath = DATA_DIR / filename
@@ -262,13 +291,19 @@ def main():
     precise_floats = [{"value": 3.141592653589793 * i} for i in range(1, 1001)]
     save_json(precise_floats, "precise_floats.json")
 
+    # 8. NDJSON (after the rest so earlier files keep their random sequence)
+    print("\n8. NDJSON (one record per line):")
+    save_ndjson([generate_small_object() for _ in range(400)], "api_records_100kb.ndjson")
+    save_ndjson([generate_log_record(i) for i in range(7000)], "logs_1mb.ndjson")
+
     print("\n" + "="*50)
     print("Test data generation complete!")
     print(f"Files saved to: {DATA_DIR}")
 
     # Print summary
-    total_size = sum(f.stat().st_size for f in DATA_DIR.glob("*.json"))
-    file_count = len(list(DATA_DIR.glob("*.json")))
+    data_files = list(DATA_DIR.glob("*.json")) + list(DATA_DIR.glob("*.ndjson"))
+    total_size = sum(f.stat().st_size for f in data_files)
+    file_count = len(data_files)
     print(f"Total: {file_count} files, {total_size/1024/1024:.1f} MB")
 
 
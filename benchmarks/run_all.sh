@@ -9,7 +9,7 @@
 # Usage:
 #   ./run_all.sh           # Run all benchmarks
 #   ./run_all.sh python    # Run only Python benchmarks
-#   ./run_all.sh simdjson  # Run only simdjson benchmarks
+#   ./run_all.sh simdjson  # Run only the native driver (simdjson, NEON, Metal)
 #   ./run_all.sh mojo      # Run only Mojo benchmarks
 
 set -e
@@ -73,10 +73,10 @@ if [ "$RUN_ALL" = true ] || [ "$RUN_PYTHON" = true ]; then
 fi
 
 # ============================================
-# simdjson (C++) Benchmark
+# Native Benchmark (simdjson, NEON library, Metal bridge)
 # ============================================
 if [ "$RUN_ALL" = true ] || [ "$RUN_SIMDJSON" = true ]; then
-    echo -e "${GREEN}[2/3] simdjson (C++) Benchmark${NC}"
+    echo -e "${GREEN}[2/3] Native (simdjson / NEON / Metal) Benchmark${NC}"
     echo "----------------------------------------"
 
     # Check if simdjson is cloned
@@ -86,9 +86,14 @@ if [ "$RUN_ALL" = true ] || [ "$RUN_SIMDJSON" = true ]; then
         git clone --depth 1 https://github.com/simdjson/simdjson.git competitors/simdjson
     fi
 
-    # Build the benchmark
-    if [ ! -f "bench_simdjson" ] || [ "bench_simdjson.cpp" -nt "bench_simdjson" ]; then
-        echo -e "${YELLOW}Building simdjson benchmark...${NC}"
+    # NEON library (also provides json_mmap_open and json_build_tape)
+    (cd ../neon && ./build.sh release > /dev/null)
+    NEON_LIB="$(ls ../neon/libneon_json.dylib ../neon/libneon_json.so 2>/dev/null | head -1)"
+
+    # Build the driver
+    if [ ! -f "bench_simdjson" ] || [ "bench_simdjson.cpp" -nt "bench_simdjson" ] || \
+       [ "$NEON_LIB" -nt "bench_simdjson" ]; then
+        echo -e "${YELLOW}Building native benchmark driver...${NC}"
 
         # Find simdjson single header
         SIMDJSON_HEADER="competitors/simdjson/singleheader/simdjson.h"
@@ -98,11 +103,19 @@ if [ "$RUN_ALL" = true ] || [ "$RUN_SIMDJSON" = true ]; then
             exit 1
         fi
 
-        # Compile with single-header
-        clang++ -O3 -std=c++17 \
+        # simdjson picks its kernel at compile time: without -march=native
+        # x86 builds get the fallback kernel, not the AVX2 / AVX-512 one
+        ARCH_FLAGS=""
+        if [ "$(uname -m)" = "x86_64" ]; then
+            ARCH_FLAGS="-march=native"
+        fi
+
+        # The Metal bridge is dlopen'ed at runtime (../metal/build_all.sh)
+        clang++ -O3 -std=c++17 $ARCH_FLAGS \
             -I competitors/simdjson/singleheader \
             competitors/simdjson/singleheader/simdjson.cpp \
             bench_simdjson.cpp \
+            -L../neon -lneon_json -Wl,-rpath,"$SCRIPT_DIR/../neon" -ldl \
             -o bench_simdjson
 
         echo "Build complete."
@@ -126,6 +139,8 @@ if [ "$RUN_ALL" = true ] || [ "$RUN_MOJO" = true ]; then
         echo "Skipping Mojo benchmarks."
     else
         mojo bench_mojo.mojo
+        # Workload rows (traverse/sum/paths/ndjson) through the Mojo API
+        (cd .. && mojo run -I . benchmarks/bench_neon.mojo)
     fi
     echo ""
 fi
@@ -138,78 +153,111 @@ echo -e "${BLUE}   Benchmark Summary${NC}"
 echo -e "${BLUE}======================================${NC}"
 echo ""
 
-# Compare results if all benchmarks ran
-if [ -f "results/python_benchmarks.csv" ] && [ -f "results/simdjson_benchmarks.csv" ]; then
+# Merge every harness into results/all_benchmarks.{csv,json}
+if ls results/*_benchmarks.csv > /dev/null 2>&1; then
     echo "Results saved to: $SCRIPT_DIR/results/"
     echo ""
 
-    # Quick summary using Python
     python3 - << 'PYSCRIPT'
 import csv
-from pathlib import Path
+import json
 from collections import defaultdict
+from pathlib import Path
 
 results_dir = Path("results")
 
-def read_csv(filename):
-    """Read CSV and return dict of file -> throughput."""
-    data = {}
+# Unified schema: same columns as SCHEMA in bench_simdjson.cpp
+SCHEMA = [
+    "harness", "backend", "workload", "file", "bytes", "iterations",
+    "checksum", "median_ns", "p99_ns", "gb_per_s", "stage1_gb_per_s", "stage2_gb_per_s",
+    "cycles_per_byte", "instructions_per_byte", "cache_misses_per_kb",
+]
+NUMERIC = SCHEMA[4:]
+
+def read_rows(filename):
     filepath = results_dir / filename
     if not filepath.exists():
-        return data
+        return []
     with open(filepath) as f:
-        reader = csv.DictReader(f)
-        for row in reader:
-            file = row.get('file', '')
-            throughput = float(row.get('throughput_mb_s', 0))
-            data[file] = throughput
-    return data
-
-# Read all results
-python_json = {}
-python_orjson = {}
-simdjson = read_csv("simdjson_benchmarks.csv")
-mojo_json = read_csv("mojo_benchmarks.csv")
-
-# Read Python results (grouped by library)
-python_file = results_dir / "python_benchmarks.csv"
-if python_file.exists():
-    with open(python_file) as f:
-        reader = csv.DictReader(f)
-        for row in reader:
-            lib = row.get('library', '')
-            file = row.get('file', '')
-            throughput = float(row.get('throughput_mb_s', 0))
-            if lib == 'json':
-                python_json[file] = throughput
-            elif lib == 'orjson':
-                python_orjson[file] = throughput
-
-# Calculate averages
-def avg(d):
-    if not d:
-        return 0
-    return sum(d.values()) / len(d)
-
-print("Average Parse Throughput (MB/s):")
+        return list(csv.DictReader(f))
+
+def legacy_row(harness, backend, row):
+    """Python / Mojo CSVs report a mean time in ms and MB/s: keep GB/s only."""
+    out = {key: "" for key in SCHEMA}
+    out.update(harness=harness, backend=backend, workload="parse",
+               file=row.get("file", ""), bytes=row.get("file_size", ""))
+    mb_s = float(row.get("throughput_mb_s", 0) or 0)
+    out["gb_per_s"] = f"{mb_s * 1024 * 1024 / 1e9:.3f}"
+    return out
+
+rows = []
+for name in ("native_benchmarks.csv", "mojo_workload_benchmarks.csv"):
+    rows += [{key: r.get(key, "") for key in SCHEMA} for r in read_rows(name)]
+rows += [legacy_row("python", r.get("library", ""), r) for r in read_rows("python_benchmarks.csv")]
+rows += [legacy_row("mojo", "mojo-json", r) for r in read_rows("mojo_benchmarks.csv")]
+
+with open(results_dir / "all_benchmarks.csv", "w", newline="") as f:
+    writer = csv.DictWriter(f, fieldnames=SCHEMA)
+    writer.writeheader()
+    writer.writerows(rows)
+
+def typed(row):
+    out = {}
+    for key in SCHEMA:
+        value = row[key]
+        if key not in NUMERIC:
+            out[key] = value
+        elif value == "":
+            out[key] = None
+        else:
+            out[key] = int(value) if key in ("bytes", "iterations") else float(value)
+    return out
+
+with open(results_dir / "all_benchmarks.json", "w") as f:
+    json.dump([typed(r) for r in rows], f, indent=1)
+
+# Average parse throughput per backend
+by_backend = defaultdict(list)
+for r in rows:
+    if r["workload"] == "parse" and r["gb_per_s"]:
+        by_backend[(r["harness"], r["backend"])].append(float(r["gb_per_s"]))
+
+def avg(values):
+    return sum(values) / len(values) if values else 0
+
+print("Average Parse Throughput (GB/s):")
 print("-" * 40)
-print(f"  simdjson (C++):      {avg(simdjson):>8.1f} MB/s")
-print(f"  orjson (Rust/Py):    {avg(python_orjson):>8.1f} MB/s")
-print(f"  mojo-json (Mojo):    {avg(mojo_json):>8.1f} MB/s")
-print(f"  json (Python):       {avg(python_json):>8.1f} MB/s")
+for (harness, backend), values in sorted(by_backend.items(), key=lambda kv: -avg(kv[1])):
+    print(f"  {backend + ' (' + harness + ')':<28} {avg(values):>7.3f} GB/s")
 
 # Speedups
-if avg(python_json) > 0:
+baseline = avg(by_backend.get(("python", "json"), []))
+if baseline > 0:
     print("")
     print("Speedup vs Python stdlib json:")
     print("-" * 40)
-    baseline = avg(python_json)
-    if avg(simdjson) > 0:
-        print(f"  simdjson:  {avg(simdjson)/baseline:>6.1f}x")
-    if avg(python_orjson) > 0:
-        print(f"  orjson:    {avg(python_orjson)/baseline:>6.1f}x")
-    if avg(mojo_json) > 0:
-        print(f"  mojo-json: {avg(mojo_json)/baseline:>6.1f}x")
+    for (harness, backend), values in sorted(by_backend.items(), key=lambda kv: -avg(kv[1])):
+        print(f"  {backend:<20} {avg(values) / baseline:>6.1f}x")
+
+# Every backend must compute the same checksum for a (workload, file)
+checksums = defaultdict(dict)
+for r in rows:
+    if r["checksum"]:
+        checksums[(r["workload"], r["file"])][r["backend"]] = float(r["checksum"])
+mismatches = [
+    (key, values) for key, values in sorted(checksums.items())
+    if max(values.values()) - min(values.values())
+    > 1e-9 * max(abs(v) for v in values.values())
+]
+if mismatches:
+    print("")
+    print("Checksum MISMATCH (backends disagree on the result):")
+    print("-" * 40)
+    for (workload, file), values in mismatches:
+        print(f"  {workload:<10} {file:<28} {values}")
+
+print("")
+print(f"Merged {len(rows)} rows into results/all_benchmarks.csv and .json")
 PYSCRIPT
 fi
 
@@ -5,9 +5,15 @@
 #
 # Outputs: json_classify.metallib
 #
+# The metallib is a build artifact (not tracked in git): the bridge looks
+# kernels up by name and silently falls back when one is missing, so the
+# build fails instead if any kernel in REQUIRED_KERNELS did not make it in.
+#
 # Kernels included:
 #   - json_classify_contiguous, json_classify_vec4, json_classify_lookup, json_classify_lookup_vec8
 #   - create_quote_bitmap, create_string_mask, extract_structural_positions, find_newlines
+#   - structural_bitmap_count, scan_chunk_counts, scan_group_sums, scatter_structural
+#   - stage1_single_pass, batch_stage1_single_pass
 
 set -e
 
@@ -45,6 +51,29 @@ echo ""
 echo "Success! Created: json_classify.metallib"
 echo ""
 
+# Kernels metal_bridge.m needs for its fast paths
+REQUIRED_KERNELS="
+    json_classify_contiguous json_classify_vec4 json_classify_lookup json_classify_lookup_vec8
+    create_quote_bitmap create_string_mask extract_structural_positions find_newlines
+    fused_structural_extract fused_structural_extract_fast
+    structural_bitmap_count scan_chunk_counts scan_group_sums scatter_structural
+    stage1_single_pass batch_stage1_single_pass
+"
+
+EXPORTED="$(strings json_classify.metallib | grep -E '^[a-z][a-z0-9_]+$' | sort -u)"
+MISSING=""
+for kernel in $REQUIRED_KERNELS; do
+    if ! grep -qx "$kernel" <<< "$EXPORTED"; then
+        MISSING="$MISSING $kernel"
+    fi
+done
+if [ -n "$MISSING" ]; then
+    echo "Error: json_classify.metallib is missing kernels:$MISSING"
+    exit 1
+fi
+
 # Show kernel functions
 echo "Kernel functions exported:"
-strings json_classify.metallib | grep -E "^(json_classify|create_|extract_|find_)[a-z_]+$" | sort -u
+for kernel in $REQUIRED_KERNELS; do
+    echo "  $kernel"
+done
@@ -544,3 +544,798 @@ constant uint8_t CHAR_LOOKUP[256] = {
         }
     }
 }
+
+
+// =============================================================================
+// Ordered Compaction (popcount -> exclusive scan -> scatter)
+// =============================================================================
+//
+// Replaces the single atomic counter of extract_structural_positions: every
+// chunk learns its output offset up front, so positions come out in
+// document order with no contention. Three dispatches:
+//
+//   1. structural_bitmap_count   one thread per 64-byte chunk: filtered
+//                                structural bitmap + popcount
+//   2. scan_chunk_counts         exclusive scan per threadgroup, one sum per group
+//   3. scan_group_sums           one threadgroup scans the group sums in place
+//   4. scatter_structural        chunk offset = local + group prefix, write bits
+//
+// Groups in 2 and 4 must be dispatched with exactly SCAN_GROUP_SIZE threads.
+
+constant uint SCAN_GROUP_SIZE = 256;
+
+/**
+ * Exclusive prefix sum across a threadgroup (simdgroup scans + one pass
+ * over the simdgroup totals). All threads of the group must call it.
+ *
+ * @param simd_totals  threadgroup scratch of at least 33 uints
+ * @param group_total  Output: sum over the whole threadgroup
+ */
+inline uint threadgroup_exclusive_sum(
+    uint value,
+    uint simd_lane,
+    uint simd_id,
+    uint simd_width,
+    uint num_simds,
+    threadgroup uint* simd_totals,
+    thread uint& group_total
+) {
+    uint prefix = simd_prefix_exclusive_sum(value);
+    if (simd_lane == simd_width - 1) {
+        simd_totals[simd_id] = prefix + value;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    if (simd_id == 0) {
+        uint total = simd_lane < num_simds ? simd_totals[simd_lane] : 0;
+        uint scanned = simd_prefix_exclusive_sum(total);
+        uint sum = simd_sum(total);
+        if (simd_lane < num_simds) {
+            simd_totals[simd_lane] = scanned;
+        }
+        if (simd_lane == 0) {
+            simd_totals[32] = sum;
+        }
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    group_total = simd_totals[32];
+    return simd_totals[simd_id] + prefix;
+}
+
+/**
+ * Filtered structural bitmap and count per 64-byte chunk.
+ *
+ * @param input            Input JSON bytes
+ * @param string_mask      In-string masks from create_string_mask
+ * @param structural_bits  Output: structural chars outside strings + quotes
+ * @param chunk_counts     Output: popcount of structural_bits
+ * @param size             Input size
+ */
+[[kernel]] void structural_bitmap_count(
+    device const uint8_t* input [[buffer(0)]],
+    device const uint64_t* string_mask [[buffer(1)]],
+    device uint64_t* structural_bits [[buffer(2)]],
+    device uint32_t* chunk_counts [[buffer(3)]],
+    constant const uint32_t& size [[buffer(4)]],
+    uint index [[thread_position_in_grid]]
+) {
+    uint64_t base = (uint64_t)index * 64;
+    if (base >= size) return;
+    uint64_t end = min(base + 64, (uint64_t)size);
+
+    uint64_t mask = string_mask[index];
+    uint64_t bits = 0;
+
+    for (uint64_t i = base; i < end; i++) {
+        uint8_t cls = CHAR_LOOKUP[input[i]];
+        if (cls == CHAR_WHITESPACE || cls == CHAR_OTHER || cls == CHAR_BACKSLASH) {
+            continue;
+        }
+
+        uint bit_pos = i - base;
+        bool in_string = (mask >> bit_pos) & 1;
+        if (cls == CHAR_QUOTE) {
+            // Same escape rule as create_quote_bitmap
+            in_string = i > 0 && input[i - 1] == '\\';
+        }
+        if (!in_string) {
+            bits |= (1UL << bit_pos);
+        }
+    }
+
+    structural_bits[index] = bits;
+    chunk_counts[index] = popcount(bits);
+}
+
+/**
+ * Exclusive scan of chunk counts within each threadgroup (in place),
+ * plus one total per threadgroup.
+ */
+[[kernel]] void scan_chunk_counts(
+    device uint32_t* chunk_counts [[buffer(0)]],
+    device uint32_t* group_sums [[buffer(1)]],
+    constant const uint32_t& num_chunks [[buffer(2)]],
+    uint index [[thread_position_in_grid]],
+    uint local_id [[thread_position_in_threadgroup]],
+    uint group_id [[threadgroup_position_in_grid]],
+    uint simd_lane [[thread_index_in_simdgroup]],
+    uint simd_id [[simdgroup_index_in_threadgroup]],
+    uint simd_width [[threads_per_simdgroup]],
+    uint num_simds [[simdgroups_per_threadgroup]]
+) {
+    threadgroup uint simd_totals[33];
+
+    // Out-of-range threads still take part in the barriers
+    uint value = index < num_chunks ? chunk_counts[index] : 0;
+    uint group_total;
+    uint offset = threadgroup_exclusive_sum(value, simd_lane, simd_id, simd_width,
+                                            num_simds, simd_totals, group_total);
+
+    if (index < num_chunks) {
+        chunk_counts[index] = offset;
+    }
+    if (local_id == 0) {
+        group_sums[group_id] = group_total;
+    }
+}
+
+/**
+ * Exclusive scan of the per-group sums (in place) by a single threadgroup,
+ * any number of groups: each thread scans a contiguous run serially.
+ *
+ * @param output_count  Output: total number of structural characters
+ */
+[[kernel]] void scan_group_sums(
+    device uint32_t* group_sums [[buffer(0)]],
+    device uint32_t* output_count [[buffer(1)]],
+    constant const uint32_t& num_groups [[buffer(2)]],
+    uint local_id [[thread_position_in_threadgroup]],
+    uint simd_lane [[thread_index_in_simdgroup]],
+    uint simd_id [[simdgroup_index_in_threadgroup]],
+    uint simd_width [[threads_per_simdgroup]],
+    uint num_simds [[simdgroups_per_threadgroup]]
+) {
+    threadgroup uint simd_totals[33];
+
+    uint per_thread = (num_groups + SCAN_GROUP_SIZE - 1) / SCAN_GROUP_SIZE;
+    uint begin = min(local_id * per_thread, num_groups);
+    uint end = min(begin + per_thread, num_groups);
+
+    uint run_total = 0;
+    for (uint i = begin; i < end; i++) {
+        run_total += group_sums[i];
+    }
+
+    uint total;
+    uint offset = threadgroup_exclusive_sum(run_total, simd_lane, simd_id, simd_width,
+                                            num_simds, simd_totals, total);
+
+    for (uint i = begin; i < end; i++) {
+        uint value = group_sums[i];
+        group_sums[i] = offset;
+        offset += value;
+    }
+
+    if (local_id == 0) {
+        output_count[0] = total;
+    }
+}
+
+/**
+ * Write each chunk's structural positions at its precomputed offset.
+ * Output is in document order.
+ */
+[[kernel]] void scatter_structural(
+    device const uint8_t* input [[buffer(0)]],
+    device const uint64_t* structural_bits [[buffer(1)]],
+    device const uint32_t* chunk_offsets [[buffer(2)]],
+    device const uint32_t* group_sums [[buffer(3)]],
+    device uint32_t* output_pos [[buffer(4)]],
+    device uint8_t* output_chars [[buffer(5)]],
+    constant const uint32_t& num_chunks [[buffer(6)]],
+    uint index [[thread_position_in_grid]]
+) {
+    if (index >= num_chunks) return;
+
+    uint64_t bits = structural_bits[index];
+    uint out = chunk_offsets[index] + group_sums[index / SCAN_GROUP_SIZE];
+    uint base = index * 64;
+
+    while (bits != 0) {
+        uint bit_pos = ctz(bits);
+        output_pos[out] = base + bit_pos;
+        output_chars[out] = input[base + bit_pos];
+        out++;
+        bits &= bits - 1;
+    }
+}
+
+
+// =============================================================================
+// Single-Pass Stage 1 (decoupled lookback, Merrill & Garland)
+// =============================================================================
+//
+// Quote bitmap, string mask and ordered compaction in ONE dispatch that
+// reads the input once. Each thread classifies one 64-byte chunk; each
+// threadgroup of LOOKBACK_GROUP_SIZE chunks publishes its aggregate in
+// group_status and then looks back at its predecessors for its carry-in.
+//
+// The output count of a group depends on whether it starts inside a
+// string, so an aggregate carries both answers:
+//
+//   bits 0-1   flag: 0 = not ready, 1 = aggregate, 2 = inclusive prefix
+//   bit  2     quote parity (aggregate) / ends inside a string (inclusive)
+//   aggregate: bits 3-16 count if entered outside a string,
+//              bits 17-30 count if entered inside one
+//   inclusive: bits 3-31 structural count through this group
+//
+// A group holds at most 128 * 64 = 8192 structurals, so 14 bits suffice;
+// the inclusive count limits a dispatch to inputs below 512 MB
+// (METAL_SINGLE_PASS_MAX_SIZE in metal_bridge.m).
+//
+// Group ids come from an atomic ticket rather than threadgroup_position_in_grid,
+// so a group only ever waits on groups that have already started.
+//
+// Escapes follow the full odd-backslash-run rule, unlike the previous-byte
+// check of create_quote_bitmap. A run may start many chunks earlier, so a
+// chunk does not look back at the input: it is classified for both escape
+// entry states, and its escape function (exit state for each entry state)
+// is scanned across the group and resolved between groups by a second
+// lookback on escape_status, before the string carry:
+//
+//   bits 0-1   flag (as above)
+//   aggregate: bits 2-3 escape function of the group
+//   inclusive: bit 2 group ends after an unescaped backslash
+//
+// Every input byte is read exactly once, whatever the backslash runs.
+
+constant uint LOOKBACK_GROUP_SIZE = 128;
+
+constant uint LOOKBACK_NOT_READY = 0;
+constant uint LOOKBACK_AGGREGATE = 1;
+constant uint LOOKBACK_INCLUSIVE = 2;
+
+// Two-state function: bit x = exit state when entered in state x
+constant uint STATE_FN_IDENTITY = 2;
+
+// `first` followed by `second`
+inline uint state_fn_then(uint first, uint second) {
+    return ((second >> (first & 1)) & 1) | (((second >> ((first >> 1) & 1)) & 1) << 1);
+}
+
+/**
+ * Escape state entering each chunk of the group.
+ *
+ * Scans the chunks' escape functions, resolves the group's carry-in by
+ * lookback on escape_status and applies it. Lookback stops early once the
+ * window is constant (any byte other than a backslash fixes the state).
+ * All threads of the group must call it.
+ *
+ * @param escape_fn  This chunk's escape function (identity if out of range)
+ * @param scan       threadgroup scratch of LOOKBACK_GROUP_SIZE uints
+ * @param carry      threadgroup scratch for the group's carry-in
+ * @return 1 if the chunk starts right after an unescaped backslash
+ */
+inline uint group_escape_carry(
+    uint escape_fn,
+    uint local_id,
+    uint group_id,
+    device atomic_uint* escape_status,
+    threadgroup uint* scan,
+    threadgroup uint* carry
+) {
+    scan[local_id] = escape_fn;
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    for (uint offset = 1; offset < LOOKBACK_GROUP_SIZE; offset <<= 1) {
+        uint combined = scan[local_id];
+        if (local_id >= offset) {
+            combined = state_fn_then(scan[local_id - offset], combined);
+        }
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+        scan[local_id] = combined;
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+    }
+
+    uint before = local_id > 0 ? scan[local_id - 1] : STATE_FN_IDENTITY;
+
+    if (local_id == 0) {
+        uint group_fn = scan[LOOKBACK_GROUP_SIZE - 1];
+        uint carry_in = 0;
+
+        if (group_id > 0) {
+            atomic_store_explicit(&escape_status[group_id],
+                                  LOOKBACK_AGGREGATE | (group_fn << 2),
+                                  memory_order_relaxed);
+
+            // Composition of groups j..group_id-1
+            uint window = STATE_FN_IDENTITY;
+
+            for (uint j = group_id - 1;; j--) {
+                uint status;
+                do {
+                    status = atomic_load_explicit(&escape_status[j], memory_order_relaxed);
+                } while ((status & 3) == LOOKBACK_NOT_READY);
+
+                if ((status & 3) == LOOKBACK_INCLUSIVE) {
+                    carry_in = (window >> ((status >> 2) & 1)) & 1;
+                    break;
+                }
+
+                window = state_fn_then((status >> 2) & 3, window);
+                if ((window & 1) == (window >> 1)) {
+                    carry_in = window & 1;
+                    break;
+                }
+            }
+        }
+
+        atomic_store_explicit(&escape_status[group_id],
+                              LOOKBACK_INCLUSIVE | (((group_fn >> carry_in) & 1) << 2),
+                              memory_order_relaxed);
+        carry[0] = carry_in;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    return (before >> carry[0]) & 1;
+}
+
+/**
+ * Quotes and structural candidates of one chunk for a given escape entry
+ * state (string state is applied later by the caller).
+ *
+ * @return Escape state after the chunk
+ */
+inline uint classify_chunk_escaped(
+    thread const uint8_t* bytes,
+    uint n,
+    uint escaped,
+    thread uint64_t& quotes,
+    thread uint64_t& structurals
+) {
+    quotes = 0;
+    structurals = 0;
+    for (uint i = 0; i < n; i++) {
+        uint8_t ch = bytes[i];
+        uint64_t bit = 1UL << i;
+
+        if (escaped) {
+            escaped = 0;
+        } else if (ch == '\\') {
+            escaped = 1;
+        } else if (ch == '"') {
+            quotes |= bit;
+        } else {
+            uint8_t cls = CHAR_LOOKUP[ch];
+            if (cls != CHAR_WHITESPACE && cls != CHAR_OTHER) {
+                structurals |= bit;
+            }
+        }
+    }
+    return escaped;
+}
+
+inline uint64_t prefix_xor64(uint64_t mask) {
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+}
+
+/**
+ * Single-dispatch GPU Stage 1. Positions are written in document order.
+ *
+ * group_ticket, group_status and escape_status must be zero before the
+ * dispatch (the bridge clears them with a blit in the same command
+ * buffer). Dispatch ceil(num_chunks / LOOKBACK_GROUP_SIZE) groups of
+ * exactly LOOKBACK_GROUP_SIZE threads.
+ *
+ * @param input          Input JSON bytes
+ * @param output_pos     Output: structural positions
+ * @param output_chars   Output: structural characters
+ * @param output_count   Output: total count (written by the last group)
+ * @param group_ticket   Dynamic group id counter
+ * @param group_status   One string status word per group (see above)
+ * @param size           Input size (< 512 MB)
+ * @param escape_status  One escape status word per group (see above)
+ */
+[[kernel]] void stage1_single_pass(
+    device const uint8_t* input [[buffer(0)]],
+    device uint32_t* output_pos [[buffer(1)]],
+    device uint8_t* output_chars [[buffer(2)]],
+    device uint32_t* output_count [[buffer(3)]],
+    device atomic_uint* group_ticket [[buffer(4)]],
+    device atomic_uint* group_status [[buffer(5)]],
+    constant const uint32_t& size [[buffer(6)]],
+    device atomic_uint* escape_status [[buffer(7)]],
+    uint local_id [[thread_position_in_threadgroup]],
+    uint simd_lane [[thread_index_in_simdgroup]],
+    uint simd_id [[simdgroup_index_in_threadgroup]],
+    uint simd_width [[threads_per_simdgroup]],
+    uint num_simds [[simdgroups_per_threadgroup]]
+) {
+    threadgroup uint shared_group_id;
+    threadgroup uint shared_carry_in;     // 1 if the group starts inside a string
+    threadgroup uint shared_base;         // Structurals before this group
+    threadgroup uint parity_totals[33];
+    threadgroup uint count0_totals[33];
+    threadgroup uint count1_totals[33];
+    threadgroup uint escape_scan[LOOKBACK_GROUP_SIZE];
+    threadgroup uint shared_escape_in;
+
+    if (local_id == 0) {
+        shared_group_id = atomic_fetch_add_explicit(group_ticket, 1, memory_order_relaxed);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    uint group_id = shared_group_id;
+    uint num_chunks = (size + 63) / 64;
+    uint num_groups = (num_chunks + LOOKBACK_GROUP_SIZE - 1) / LOOKBACK_GROUP_SIZE;
+    uint chunk = group_id * LOOKBACK_GROUP_SIZE + local_id;
+    uint64_t base = (uint64_t)chunk * 64;
+
+    // =========================================================================
+    // Phase 1: Classify this chunk for both escape entry states, then pick
+    // one once the escape carry is known (out-of-range: empty masks)
+    // =========================================================================
+    uint8_t bytes[64];
+    uint64_t quotes0 = 0, structurals0 = 0;
+    uint64_t quotes1 = 0, structurals1 = 0;
+    uint escape_fn = STATE_FN_IDENTITY;
+
+    if (base < size) {
+        uint n = (uint)min((uint64_t)64, (uint64_t)size - base);
+        for (uint i = 0; i < n; i++) {
+            bytes[i] = input[base + i];
+        }
+        uint exit0 = classify_chunk_escaped(bytes, n, 0, quotes0, structurals0);
+        uint exit1 = classify_chunk_escaped(bytes, n, 1, quotes1, structurals1);
+        escape_fn = exit0 | (exit1 << 1);
+    }
+
+    uint escaped_in = group_escape_carry(escape_fn, local_id, group_id, escape_status,
+                                         escape_scan, &shared_escape_in);
+    uint64_t quotes = escaped_in ? quotes1 : quotes0;
+    uint64_t structurals = escaped_in ? structurals1 : structurals0;
+
+    // In-chunk string mask, assuming the chunk starts outside a string
+    uint64_t in_string = prefix_xor64(quotes);
+    uint64_t bits_out = (structurals & ~in_string) | quotes;
+    uint64_t bits_in = (structurals & in_string) | quotes;
+    uint parity = popcount(quotes) & 1;
+
+    // =========================================================================
+    // Phase 2: Scan within the group for both carry-in hypotheses
+    // =========================================================================
+    uint parity_total;
+    uint local_parity = threadgroup_exclusive_sum(parity, simd_lane, simd_id, simd_width,
+                                                  num_simds, parity_totals, parity_total) & 1;
+
+    // Counts if the GROUP starts outside (0) / inside (1) a string
+    uint count0 = popcount(local_parity ? bits_in : bits_out);
+    uint count1 = popcount(local_parity ? bits_out : bits_in);
+
+    uint total0, total1;
+    uint offset0 = threadgroup_exclusive_sum(count0, simd_lane, simd_id, simd_width,
+                                             num_simds, count0_totals, total0);
+    uint offset1 = threadgroup_exclusive_sum(count1, simd_lane, simd_id, simd_width,
+                                             num_simds, count1_totals, total1);
+    parity_total &= 1;
+
+    // =========================================================================
+    // Phase 3: Publish aggregate, look back, publish inclusive prefix
+    // =========================================================================
+    if (local_id == 0) {
+        uint carry_in = 0;
+        uint exclusive = 0;
+
+        if (group_id > 0) {
+            uint aggregate = LOOKBACK_AGGREGATE | (parity_total << 2) |
+                             (total0 << 3) | (total1 << 17);
+            atomic_store_explicit(&group_status[group_id], aggregate, memory_order_relaxed);
+
+            // Window (j..group_id-1): parity and counts for both carry-ins
+            uint window_parity = 0;
+            uint window0 = 0;
+            uint window1 = 0;
+
+            for (uint j = group_id - 1;; j--) {
+                uint status;
+                do {
+                    status = atomic_load_explicit(&group_status[j], memory_order_relaxed);
+                } while ((status & 3) == LOOKBACK_NOT_READY);
+
+                uint p = (status >> 2) & 1;
+                if ((status & 3) == LOOKBACK_INCLUSIVE) {
+                    carry_in = p ^ window_parity;
+                    exclusive = (status >> 3) + (p ? window1 : window0);
+                    break;
+                }
+
+                // Prepend group j to the window
+                uint a0 = (status >> 3) & 0x3FFF;
+                uint a1 = (status >> 17) & 0x3FFF;
+                uint next0 = a0 + (p ? window1 : window0);
+                uint next1 = a1 + (p ? window0 : window1);
+                window0 = next0;
+                window1 = next1;
+                window_parity ^= p;
+            }
+        }
+
+        uint inclusive = exclusive + (carry_in ? total1 : total0);
+        uint ends_in_string = carry_in ^ parity_total;
+        atomic_store_explicit(&group_status[group_id],
+                              LOOKBACK_INCLUSIVE | (ends_in_string << 2) | (inclusive << 3),
+                              memory_order_relaxed);
+
+        if (group_id == num_groups - 1) {
+            output_count[0] = inclusive;
+        }
+
+        shared_carry_in = carry_in;
+        shared_base = exclusive;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    // =========================================================================
+    // Phase 4: Scatter in document order
+    // =========================================================================
+    uint carry_in = shared_carry_in;
+    uint out = shared_base + (carry_in ? offset1 : offset0);
+    uint64_t bits = (carry_in ^ local_parity) ? bits_in : bits_out;
+
+    while (bits != 0) {
+        uint bit_pos = ctz(bits);
+        output_pos[out] = (uint32_t)(base + bit_pos);
+        output_chars[out] = bytes[bit_pos];
+        out++;
+        bits &= bits - 1;
+    }
+}
+
+
+// =============================================================================
+// NDJSON Batch Stage 1 (single pass, quote state reset per record)
+// =============================================================================
+//
+// Same decoupled lookback as stage1_single_pass, but a raw '\n' (which can
+// never occur inside a valid JSON string) resets the string and escape
+// state. A chunk is then a function of its carry-in rather than a parity
+// flip, so every scan element is a CarryFn: the exit state and structural
+// count for each of the two possible entry states. CarryFns compose, which
+// is all a scan needs. The escape carry is resolved first, exactly as in
+// stage1_single_pass (group_escape_carry), so the input is read once.
+//
+//   bits 0-1   flag (as above)
+//   aggregate: bit 2 exit state if entered outside a string,
+//              bit 3 exit state if entered inside one,
+//              bits 4-17 / 18-31 counts for the two entry states
+//   inclusive: bit 2 ends inside a string, bits 3-31 structural count
+
+struct CarryFn {
+    uint ends;    // bit x: exit state when entered in state x
+    uint count0;  // Structurals when entered outside a string
+    uint count1;  // Structurals when entered inside a string
+};
+
+constant CarryFn CARRY_FN_IDENTITY = {2, 0, 0};
+
+// `first` followed by `second`
+inline CarryFn carry_fn_then(CarryFn first, CarryFn second) {
+    uint mid0 = first.ends & 1;
+    uint mid1 = (first.ends >> 1) & 1;
+
+    CarryFn result;
+    result.ends = state_fn_then(first.ends, second.ends);
+    result.count0 = first.count0 + (mid0 ? second.count1 : second.count0);
+    result.count1 = first.count1 + (mid1 ? second.count1 : second.count0);
+    return result;
+}
+
+/**
+ * Structural bits and exit string states of one chunk for both string
+ * entry states, given its escape entry state.
+ *
+ * @return Escape state after the chunk
+ */
+inline uint classify_record_chunk(
+    thread const uint8_t* bytes,
+    uint n,
+    uint escaped,
+    thread uint64_t& bits0,
+    thread uint64_t& bits1,
+    thread uint& state0,
+    thread uint& state1
+) {
+    bits0 = 0;
+    bits1 = 0;
+    state0 = 0;
+    state1 = 1;
+    for (uint i = 0; i < n; i++) {
+        uint8_t ch = bytes[i];
+        uint64_t bit = 1UL << i;
+
+        if (ch == '\n') {
+            // Record boundary
+            state0 = 0;
+            state1 = 0;
+            escaped = 0;
+        } else if (escaped) {
+            escaped = 0;
+        } else if (ch == '\\') {
+            escaped = 1;
+        } else if (ch == '"') {
+            bits0 |= bit;
+            bits1 |= bit;
+            state0 ^= 1;
+            state1 ^= 1;
+        } else {
+            uint8_t cls = CHAR_LOOKUP[ch];
+            if (cls != CHAR_WHITESPACE && cls != CHAR_OTHER) {
+                if (!state0) bits0 |= bit;
+                if (!state1) bits1 |= bit;
+            }
+        }
+    }
+    return escaped;
+}
+
+/**
+ * Single-dispatch Stage 1 over a whole NDJSON buffer. Output is in document
+ * order; per-record ranges are cut from it by line offset on the host.
+ *
+ * Buffers and dispatch shape as for stage1_single_pass.
+ */
+[[kernel]] void batch_stage1_single_pass(
+    device const uint8_t* input [[buffer(0)]],
+    device uint32_t* output_pos [[buffer(1)]],
+    device uint8_t* output_chars [[buffer(2)]],
+    device uint32_t* output_count [[buffer(3)]],
+    device atomic_uint* group_ticket [[buffer(4)]],
+    device atomic_uint* group_status [[buffer(5)]],
+    constant const uint32_t& size [[buffer(6)]],
+    device atomic_uint* escape_status [[buffer(7)]],
+    uint local_id [[thread_position_in_threadgroup]]
+) {
+    threadgroup uint shared_group_id;
+    threadgroup uint shared_carry_in;
+    threadgroup uint shared_base;
+    threadgroup CarryFn scan[LOOKBACK_GROUP_SIZE];
+    threadgroup uint escape_scan[LOOKBACK_GROUP_SIZE];
+    threadgroup uint shared_escape_in;
+
+    if (local_id == 0) {
+        shared_group_id = atomic_fetch_add_explicit(group_ticket, 1, memory_order_relaxed);
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    uint group_id = shared_group_id;
+    uint num_chunks = (size + 63) / 64;
+    uint num_groups = (num_chunks + LOOKBACK_GROUP_SIZE - 1) / LOOKBACK_GROUP_SIZE;
+    uint64_t base = (uint64_t)(group_id * LOOKBACK_GROUP_SIZE + local_id) * 64;
+
+    // =========================================================================
+    // Phase 1: Classify for both escape and both string entry states, then
+    // pick the escape variant once its carry is known (out-of-range: identity)
+    // =========================================================================
+    uint8_t bytes[64];
+    uint64_t bits0_e[2] = {0, 0};
+    uint64_t bits1_e[2] = {0, 0};
+    uint state0_e[2] = {0, 0};
+    uint state1_e[2] = {1, 1};
+    uint escape_fn = STATE_FN_IDENTITY;
+
+    if (base < size) {
+        uint n = (uint)min((uint64_t)64, (uint64_t)size - base);
+        for (uint i = 0; i < n; i++) {
+            bytes[i] = input[base + i];
+        }
+        uint exit0 = classify_record_chunk(bytes, n, 0, bits0_e[0], bits1_e[0],
+                                           state0_e[0], state1_e[0]);
+        uint exit1 = classify_record_chunk(bytes, n, 1, bits0_e[1], bits1_e[1],
+                                           state0_e[1], state1_e[1]);
+        escape_fn = exit0 | (exit1 << 1);
+    }
+
+    uint escaped_in = group_escape_carry(escape_fn, local_id, group_id, escape_status,
+                                         escape_scan, &shared_escape_in);
+    uint64_t bits0 = bits0_e[escaped_in];
+    uint64_t bits1 = bits1_e[escaped_in];
+    uint state0 = state0_e[escaped_in];
+    uint state1 = state1_e[escaped_in];
+
+    CarryFn mine;
+    mine.ends = state0 | (state1 << 1);
+    mine.count0 = popcount(bits0);
+    mine.count1 = popcount(bits1);
+
+    // =========================================================================
+    // Phase 2: Inclusive scan of CarryFns within the group (Hillis-Steele)
+    // =========================================================================
+    scan[local_id] = mine;
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    for (uint offset = 1; offset < LOOKBACK_GROUP_SIZE; offset <<= 1) {
+        CarryFn combined = scan[local_id];
+        if (local_id >= offset) {
+            combined = carry_fn_then(scan[local_id - offset], combined);
+        }
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+        scan[local_id] = combined;
+        threadgroup_barrier(mem_flags::mem_threadgroup);
+    }
+
+    CarryFn before = local_id > 0 ? scan[local_id - 1] : CARRY_FN_IDENTITY;
+    CarryFn group = scan[LOOKBACK_GROUP_SIZE - 1];
+
+    // =========================================================================
+    // Phase 3: Publish aggregate, look back, publish inclusive prefix
+    // =========================================================================
+    if (local_id == 0) {
+        uint carry_in = 0;
+        uint exclusive = 0;
+
+        if (group_id > 0) {
+            uint aggregate = LOOKBACK_AGGREGATE | (group.ends << 2) |
+                             (group.count0 << 4) | (group.count1 << 18);
+            atomic_store_explicit(&group_status[group_id], aggregate, memory_order_relaxed);
+
+            // Composition of groups j..group_id-1
+            CarryFn window = CARRY_FN_IDENTITY;
+
+            for (uint j = group_id - 1;; j--) {
+                uint status;
+                do {
+                    status = atomic_load_explicit(&group_status[j], memory_order_relaxed);
+                } while ((status & 3) == LOOKBACK_NOT_READY);
+
+                if ((status & 3) == LOOKBACK_INCLUSIVE) {
+                    uint entry = (status >> 2) & 1;
+                    carry_in = (window.ends >> entry) & 1;
+                    exclusive = (status >> 3) + (entry ? window.count1 : window.count0);
+                    break;
+                }
+
+                CarryFn predecessor;
+                predecessor.ends = (status >> 2) & 3;
+                predecessor.count0 = (status >> 4) & 0x3FFF;
+                predecessor.count1 = (status >> 18) & 0x3FFF;
+                window = carry_fn_then(predecessor, window);
+            }
+        }
+
+        uint inclusive = exclusive + (carry_in ? group.count1 : group.count0);
+        uint ends_in_string = (group.ends >> carry_in) & 1;
+        atomic_store_explicit(&group_status[group_id],
+                              LOOKBACK_INCLUSIVE | (ends_in_string << 2) | (inclusive << 3),
+                              memory_order_relaxed);
+
+        if (group_id == num_groups - 1) {
+            output_count[0] = inclusive;
+        }
+
+        shared_carry_in = carry_in;
+        shared_base = exclusive;
+    }
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+
+    // =========================================================================
+    // Phase 4: Scatter in document order
+    // =========================================================================
+    uint carry_in = shared_carry_in;
+    uint out = shared_base + (carry_in ? before.count1 : before.count0);
+    uint64_t bits = ((before.ends >> carry_in) & 1) ? bits1 : bits0;
+
+    while (bits != 0) {
+        uint bit_pos = ctz(bits);
+        output_pos[out] = (uint32_t)(base + bit_pos);
+        output_chars[out] = bytes[bit_pos];
+        out++;
+        bits &= bits - 1;
+    }
+}
@@ -9,6 +9,7 @@
 #define METAL_BRIDGE_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -178,6 +179,22 @@ int metal_json_find_newlines(MetalContext* ctx,
  *
  * More efficient than calling individual functions due to single command buffer.
  *
+ * When the metallib provides the ordered compaction kernels
+ * (structural_bitmap_count, scan_chunk_counts, scan_group_sums,
+ * scatter_structural), step 3 is a per-chunk popcount, an exclusive scan
+ * and a scatter, so output_pos is in document order. Older metallibs fall
+ * back to the atomic append, whose order is unspecified: callers must
+ * sort, or check metal_json_has_ordered_stage1 first. build_metallib.sh
+ * fails if these kernels are missing from json_classify.metallib.
+ *
+ * With stage1_single_pass available, inputs below 512 MB run as one
+ * dispatch instead: quote parity and output offsets propagate between
+ * threadgroups by decoupled lookback, and the input is read once. This
+ * path also resolves escapes by full backslash-run parity; the multi-pass
+ * path only checks the byte before a quote, so a string ending in an
+ * escaped backslash ("a\\") is misread. See metal_json_has_exact_stage1;
+ * build_metallib.sh fails if stage1_single_pass is missing.
+ *
  * @param ctx Context
  * @param input Input JSON bytes
  * @param size Input size
@@ -193,6 +210,235 @@ int metal_json_full_stage1(MetalContext* ctx,
                            uint8_t* output_chars,
                            uint32_t* output_count);
 
+/**
+ * Check if metal_json_full_stage1 on `size` bytes returns positions in
+ * document order (single-pass kernel or ordered compaction loaded).
+ *
+ * @return 1 if ordered, 0 if the atomic append (unordered) would run
+ */
+int metal_json_has_ordered_stage1(MetalContext* ctx, uint32_t size);
+
+/**
+ * Check if metal_json_full_stage1 on `size` bytes runs the single-pass
+ * kernel: ordered output with full escape handling, i.e. the same index
+ * as neon_json_find_structural. Only then can the positions feed
+ * json_build_tape directly.
+ *
+ * @return 1 if exact, 0 otherwise
+ */
+int metal_json_has_exact_stage1(MetalContext* ctx, uint32_t size);
+
+/**
+ * Full GPU Stage 1 without host-side copies.
+ *
+ * Like metal_json_full_stage1, but output_pos / output_chars receive
+ * pointers into the context's shared result buffers (valid until the next
+ * call on ctx). If input comes from metal_json_input_buffer or a registered
+ * region, the input is not copied either.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int metal_json_full_stage1_borrowed(MetalContext* ctx,
+                                    const uint8_t* input,
+                                    uint32_t size,
+                                    const uint32_t** output_pos,
+                                    const uint8_t** output_chars,
+                                    uint32_t* output_count);
+
+// =============================================================================
+// NDJSON Batch Stage 1
+// =============================================================================
+
+/**
+ * Check if the batch Stage 1 kernel (batch_stage1_single_pass) is available.
+ * Always true for a metallib from build_metallib.sh, which fails without it.
+ *
+ * @param ctx Context
+ * @return 1 if available, 0 otherwise
+ */
+int metal_json_has_batch_stage1(MetalContext* ctx);
+
+/**
+ * GPU Stage 1 over all records of an NDJSON buffer in one dispatch.
+ *
+ * String and escape state reset at every '\n', so each record is indexed
+ * exactly as if it were parsed alone. Positions are absolute offsets into
+ * `input`, in document order, in one flat array; record i owns entries
+ * [record_offsets[i], record_offsets[i] + record_counts[i]).
+ *
+ * Meant for many small records, where one dispatch per record would be
+ * dominated by launch overhead. Input must be below 512 MB.
+ *
+ * @param ctx Context
+ * @param input NDJSON bytes
+ * @param size Input size
+ * @param line_offsets n_lines (start, end) byte pairs, sorted, non-overlapping
+ *                     (e.g. from find_line_boundaries in src/ndjson.mojo)
+ * @param n_lines Number of records
+ * @param output_pos Output: borrowed pointer to positions (valid until the
+ *                   next call on ctx)
+ * @param output_chars Output: borrowed pointer to characters
+ * @param record_offsets Output: first entry of each record (n_lines)
+ * @param record_counts Output: entries per record (n_lines)
+ * @param output_count Output: total number of structurals
+ * @return 0 on success, -1 on failure or if the kernel is unavailable
+ */
+int metal_json_batch_stage1(MetalContext* ctx,
+                            const uint8_t* input,
+                            uint32_t size,
+                            const uint32_t* line_offsets,
+                            uint32_t n_lines,
+                            const uint32_t** output_pos,
+                            const uint8_t** output_chars,
+                            uint32_t* record_offsets,
+                            uint32_t* record_counts,
+                            uint32_t* output_count);
+
+// =============================================================================
+// Zero-Copy Input (Apple unified memory)
+// =============================================================================
+
+/**
+ * Pointer to the context's shared (CPU + GPU visible) input buffer, grown
+ * to at least `size` bytes. Read or build the document directly into it,
+ * then pass the same pointer to any Stage 1 call - no memcpy happens.
+ * Invalidated by a later call with a larger size.
+ *
+ * @return Buffer pointer, or NULL on failure
+ */
+uint8_t* metal_json_input_buffer(MetalContext* ctx, uint32_t size);
+
+/**
+ * Register caller-owned memory (e.g. an mmap'd file) once for zero-copy GPU
+ * access via newBufferWithBytesNoCopy. host_ptr and length must be
+ * page-aligned; the memory must stay mapped until unregistered. Inputs that
+ * fall inside the region (at 16-byte aligned offsets) are bound in place.
+ * Replaces any previous registration.
+ *
+ * @return 0 on success, -1 on failure (e.g. unaligned)
+ */
+int metal_json_register_input(MetalContext* ctx, const void* host_ptr, size_t length);
+
+/**
+ * Drop the registered region. The memory remains owned by the caller.
+ */
+void metal_json_unregister_input(MetalContext* ctx);
+
+// =============================================================================
+// Async Stage 1 (pipelined with CPU Stage 2)
+// =============================================================================
+
+// Returned by metal_json_stage1_submit when every ring slot is unclaimed
+#define METAL_JSON_RING_FULL (-2)
+
+/**
+ * Submit full GPU Stage 1 and return immediately.
+ *
+ * The context keeps a ring of 3 buffer sets, so up to 3 documents can be
+ * in flight; a completion handler marks each one done. Typical loop, with
+ * document N+1 on the GPU while the CPU runs Stage 2 on document N:
+ *
+ *   t0 = metal_json_stage1_submit(ctx, doc[0], len[0]);
+ *   for (n = 0; n < count; n++) {
+ *       if (n + 1 < count) t1 = metal_json_stage1_submit(ctx, doc[n+1], len[n+1]);
+ *       metal_json_stage1_wait(ctx, t0, &pos, &chars, &num);
+ *       stage2(doc[n], pos, chars, num);
+ *       t0 = t1;
+ *   }
+ *
+ * The input is copied into the slot (unless it lies in a registered
+ * no-copy region), so the caller may reuse its buffer right away.
+ *
+ * @return Ticket (> 0), METAL_JSON_RING_FULL if 3 tickets are unclaimed,
+ *         or -1 on failure
+ */
+int64_t metal_json_stage1_submit(MetalContext* ctx, const uint8_t* input, uint32_t size);
+
+/**
+ * Non-blocking completion check.
+ * @return 1 if done, 0 if still running, -1 for an unknown/claimed ticket
+ */
+int metal_json_stage1_poll(MetalContext* ctx, int64_t ticket);
+
+/**
+ * Block until a ticket's GPU work finishes and claim its results.
+ *
+ * output_pos / output_chars point into the ticket's ring slot and stay
+ * valid until that slot is reused by the submit of ticket + 3.
+ * Each ticket can be waited on once.
+ *
+ * @return 0 on success, -1 on failure or unknown ticket
+ */
+int metal_json_stage1_wait(MetalContext* ctx,
+                           int64_t ticket,
+                           const uint32_t** output_pos,
+                           const uint8_t** output_chars,
+                           uint32_t* output_count);
+
+// =============================================================================
+// Stage Statistics
+// =============================================================================
+
+/**
+ * Counters accumulated while stats are enabled. Same layout as
+ * JsonCtxStats in neon_json.h, so one exporter reads both backends; the
+ * CPU-only fields (escape_blocks, classify_ns, extract_ns) stay 0.
+ *
+ * Recorded by metal_json_full_stage1 (and _borrowed), metal_json_batch_stage1,
+ * metal_json_fused_extract and metal_json_stage1_wait. GPU times come from
+ * the command buffer's GPUStartTime / GPUEndTime, in ns of the host clock
+ * those use. total_ns is the host's wall time from input binding to the
+ * end of the wait, so total_ns - gpu_ns is the dispatch overhead; async
+ * jobs overlap with the caller and only add GPU time.
+ */
+typedef struct {
+    uint64_t calls;          // Command buffers recorded
+    uint64_t bytes;          // Input bytes submitted
+    uint64_t structurals;    // Structural positions produced
+    uint64_t escape_blocks;  // Always 0 (CPU only)
+    uint64_t classify_ns;    // Always 0 (CPU only)
+    uint64_t extract_ns;     // Always 0 (CPU only)
+    uint64_t total_ns;       // Host wall time of the synchronous calls
+    uint64_t gpu_ns;         // Sum of GPUEndTime - GPUStartTime
+    uint64_t gpu_start_ns;   // GPUStartTime of the last command buffer
+    uint64_t gpu_end_ns;     // GPUEndTime of the last command buffer
+} MetalJsonStats;
+
+/**
+ * Turn stats recording on or off (off after metal_json_init). Disabled,
+ * a call pays one branch; enabled, two clock reads and two property reads
+ * on the finished command buffer.
+ *
+ * @return 0 on success, -1 for a NULL context
+ */
+int metal_json_enable_stats(MetalContext* ctx, int enabled);
+
+/**
+ * Copy the counters accumulated since init or the last reset.
+ * @return 0 on success, -1 for a NULL argument
+ */
+int metal_json_get_stats(MetalContext* ctx, MetalJsonStats* stats);
+
+// Zero the counters (recording stays on or off)
+void metal_json_reset_stats(MetalContext* ctx);
+
+// =============================================================================
+// Calibration
+// =============================================================================
+
+/**
+ * Measure metal_json_full_stage1 on 4 KB / 64 KB / 1 MB synthetic documents
+ * and fit time = overhead + size / throughput.
+ *
+ * Feed the result to json_select_backend via
+ * json_calibration_set(JSON_BACKEND_METAL, ...) from neon_json.h.
+ *
+ * @param mb_per_s Output: streaming throughput in MB/s
+ * @param overhead_ns Output: fixed per-call cost (dispatch + wait)
+ * @return 0 on success, -1 on failure
+ */
+int metal_json_calibrate(MetalContext* ctx, double* mb_per_s, double* overhead_ns);
+
 #ifdef __cplusplus
 }
 #endif
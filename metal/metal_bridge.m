@@ -14,8 +14,41 @@
 
 #import <Metal/Metal.h>
 #import <Foundation/Foundation.h>
+#include "metal_bridge.h"
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Buffer sets in the async Stage 1 ring (metal_json_stage1_submit / wait)
+#define METAL_STAGE1_RING 3
+
+enum {
+    STAGE1_SLOT_FREE = 0,     // Available for the next submit
+    STAGE1_SLOT_IN_FLIGHT,    // Committed, results pending or not yet claimed
+};
+
+// One in-flight Stage 1 job with its own buffers
+typedef struct {
+    id<MTLBuffer> input_buffer;
+    id<MTLBuffer> quote_bits_buffer;
+    id<MTLBuffer> quote_carry_buffer;
+    id<MTLBuffer> structural_pos_buffer;
+    id<MTLBuffer> structural_char_buffer;
+    id<MTLBuffer> atomic_counter_buffer;
+    uint32_t buffer_size;
+
+    dispatch_semaphore_t done;   // Signalled by the completion handler
+    int completed;               // Set (atomically) by the completion handler
+    int failed;
+    int state;
+    uint64_t ticket;
+
+    uint32_t input_size;         // Bytes submitted (stats)
+    double gpu_start_time;       // GPUStartTime / GPUEndTime, set by the
+    double gpu_end_time;         // completion handler when stats are on
+} MetalStage1Slot;
 
 // Opaque context structure
 typedef struct MetalContext {
@@ -35,6 +68,16 @@ typedef struct MetalContext {
     id<MTLComputePipelineState> pipeline_extract_structural;
     id<MTLComputePipelineState> pipeline_find_newlines;
 
+    // Ordered compaction (replaces the atomic append when available)
+    id<MTLComputePipelineState> pipeline_structural_bitmap;
+    id<MTLComputePipelineState> pipeline_scan_chunks;
+    id<MTLComputePipelineState> pipeline_scan_groups;
+    id<MTLComputePipelineState> pipeline_scatter_structural;
+
+    // Single-dispatch Stage 1 (decoupled lookback)
+    id<MTLComputePipelineState> pipeline_single_pass;
+    id<MTLComputePipelineState> pipeline_batch_single_pass;
+
     // Reusable buffers (for repeated calls with same size)
     id<MTLBuffer> input_buffer;
     id<MTLBuffer> output_buffer;
@@ -47,6 +90,31 @@ typedef struct MetalContext {
     id<MTLBuffer> structural_char_buffer; // Output characters
     id<MTLBuffer> atomic_counter_buffer;  // Atomic counter
     uint32_t gpjson_buffer_size;
+
+    // Ordered compaction scratch (shared by all ring slots: command buffers
+    // on one queue run in order)
+    id<MTLBuffer> structural_bits_buffer; // Filtered bitmap per chunk
+    id<MTLBuffer> chunk_offsets_buffer;   // Count -> exclusive offset per chunk
+    id<MTLBuffer> group_sums_buffer;      // Sum -> exclusive offset per group
+    uint32_t ordered_buffer_chunks;
+
+    // Lookback scratch: [0] group ticket, then per-group string status and
+    // per-group escape status (lookback_buffer_groups words each)
+    id<MTLBuffer> lookback_buffer;
+    uint32_t lookback_buffer_groups;
+
+    // Zero-copy input: caller memory wrapped with newBufferWithBytesNoCopy
+    id<MTLBuffer> registered_buffer;
+    const uint8_t* registered_base;
+    size_t registered_length;
+
+    // Async Stage 1 ring
+    MetalStage1Slot ring[METAL_STAGE1_RING];
+    uint64_t next_ticket;
+
+    // Opt-in counters (metal_json_enable_stats / metal_json_get_stats)
+    int stats_enabled;
+    MetalJsonStats stats;
 } MetalContext;
 
 /**
@@ -157,6 +225,38 @@ MetalContext* metal_json_init(const char* metallib_path) {
             ctx->pipeline_find_newlines = [ctx->device newComputePipelineStateWithFunction:func error:&error];
         }
 
+        // Ordered compaction kernels (optional - atomic append otherwise)
+        func = [ctx->library newFunctionWithName:@"structural_bitmap_count"];
+        if (func) {
+            ctx->pipeline_structural_bitmap = [ctx->device newComputePipelineStateWithFunction:func error:&error];
+        }
+
+        func = [ctx->library newFunctionWithName:@"scan_chunk_counts"];
+        if (func) {
+            ctx->pipeline_scan_chunks = [ctx->device newComputePipelineStateWithFunction:func error:&error];
+        }
+
+        func = [ctx->library newFunctionWithName:@"scan_group_sums"];
+        if (func) {
+            ctx->pipeline_scan_groups = [ctx->device newComputePipelineStateWithFunction:func error:&error];
+        }
+
+        func = [ctx->library newFunctionWithName:@"scatter_structural"];
+        if (func) {
+            ctx->pipeline_scatter_structural = [ctx->device newComputePipelineStateWithFunction:func error:&error];
+        }
+
+        // Single-pass Stage 1 kernel (optional - multi-pass otherwise)
+        func = [ctx->library newFunctionWithName:@"stage1_single_pass"];
+        if (func) {
+            ctx->pipeline_single_pass = [ctx->device newComputePipelineStateWithFunction:func error:&error];
+        }
+
+        func = [ctx->library newFunctionWithName:@"batch_stage1_single_pass"];
+        if (func) {
+            ctx->pipeline_batch_single_pass = [ctx->device newComputePipelineStateWithFunction:func error:&error];
+        }
+
         return ctx;
     }
 }
@@ -180,6 +280,43 @@ static void ensure_buffers(MetalContext* ctx, uint32_t size) {
     ctx->buffer_size = alloc_size;
 }
 
+/**
+ * Bind `input` for a dispatch without copying it when it already lives in
+ * GPU-visible memory: either the registered no-copy buffer or the context's
+ * own shared input buffer (see metal_json_input_buffer). Anything else is
+ * copied into input_buffer as before.
+ *
+ * @param offset Output: byte offset of input within the returned buffer
+ */
+static id<MTLBuffer> bind_input(MetalContext* ctx,
+                                const uint8_t* input,
+                                uint32_t size,
+                                NSUInteger* offset) {
+    // Buffer offsets stay 16-byte aligned; unaligned views fall back to a copy
+    if (ctx->registered_buffer &&
+        input >= ctx->registered_base &&
+        (size_t)(input - ctx->registered_base) + size <= ctx->registered_length &&
+        ((uintptr_t)(input - ctx->registered_base) & 15) == 0) {
+        *offset = (NSUInteger)(input - ctx->registered_base);
+        return ctx->registered_buffer;
+    }
+
+    if (ctx->input_buffer) {
+        const uint8_t* base = ctx->input_buffer.contents;
+        if (input >= base &&
+            (size_t)(input - base) + size <= ctx->buffer_size &&
+            ((uintptr_t)(input - base) & 15) == 0) {
+            *offset = (NSUInteger)(input - base);
+            return ctx->input_buffer;
+        }
+    }
+
+    ensure_buffers(ctx, size);
+    memcpy(ctx->input_buffer.contents, input, size);
+    *offset = 0;
+    return ctx->input_buffer;
+}
+
 /**
  * Classify JSON characters using GPU.
  *
@@ -218,15 +355,16 @@ int metal_json_classify(MetalContext* ctx,
 
         ensure_buffers(ctx, size);
 
-        // Copy input to GPU buffer
-        memcpy(ctx->input_buffer.contents, input, size);
+        // Bind input in place when it is GPU-visible, else copy to the GPU buffer
+        NSUInteger input_offset = 0;
+        id<MTLBuffer> input_buffer = bind_input(ctx, input, size, &input_offset);
 
         // Create command buffer
         id<MTLCommandBuffer> commandBuffer = [ctx->queue commandBuffer];
         id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
 
         [encoder setComputePipelineState:pipeline];
-        [encoder setBuffer:ctx->input_buffer offset:0 atIndex:0];
+        [encoder setBuffer:input_buffer offset:input_offset atIndex:0];
         [encoder setBuffer:ctx->output_buffer offset:0 atIndex:1];
         [encoder setBytes:&size length:sizeof(size) atIndex:2];
 
@@ -307,13 +445,14 @@ int metal_json_classify_variant(MetalContext* ctx,
         }
 
         ensure_buffers(ctx, size);
-        memcpy(ctx->input_buffer.contents, input, size);
+        NSUInteger input_offset = 0;
+        id<MTLBuffer> input_buffer = bind_input(ctx, input, size, &input_offset);
 
         id<MTLCommandBuffer> commandBuffer = [ctx->queue commandBuffer];
         id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
 
         [encoder setComputePipelineState:pipeline];
-        [encoder setBuffer:ctx->input_buffer offset:0 atIndex:0];
+        [encoder setBuffer:input_buffer offset:input_offset atIndex:0];
         [encoder setBuffer:ctx->output_buffer offset:0 atIndex:1];
         [encoder setBytes:&size length:sizeof(size) atIndex:2];
 
@@ -342,6 +481,14 @@ int metal_json_classify_variant(MetalContext* ctx,
  */
 void metal_json_free(MetalContext* ctx) {
     if (ctx) {
+        // Completion handlers write into the ring - wait for them first
+        for (int i = 0; i < METAL_STAGE1_RING; i++) {
+            MetalStage1Slot* slot = &ctx->ring[i];
+            if (slot->state == STAGE1_SLOT_IN_FLIGHT &&
+                !__atomic_load_n(&slot->completed, __ATOMIC_ACQUIRE)) {
+                dispatch_semaphore_wait(slot->done, DISPATCH_TIME_FOREVER);
+            }
+        }
         // ARC will handle release of Obj-C objects
         free(ctx);
     }
@@ -367,6 +514,64 @@ int metal_json_is_available(void) {
     }
 }
 
+// =============================================================================
+// Stage Statistics
+// =============================================================================
+
+static uint64_t stats_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Start of a recorded call: the clock is only read with stats enabled
+static inline uint64_t stats_begin(MetalContext* ctx) {
+    return ctx->stats_enabled ? stats_clock_ns() : 0;
+}
+
+/**
+ * Charge one finished command buffer to the context's counters.
+ *
+ * @param host_start stats_begin() of a synchronous call, 0 for async jobs
+ *                   (their wall time overlaps with the caller's work)
+ */
+static void stats_record(MetalContext* ctx,
+                         CFTimeInterval gpu_start,
+                         CFTimeInterval gpu_end,
+                         uint32_t bytes,
+                         uint32_t structurals,
+                         uint64_t host_start) {
+    if (!ctx->stats_enabled) return;
+
+    ctx->stats.calls++;
+    ctx->stats.bytes += bytes;
+    ctx->stats.structurals += structurals;
+    if (host_start) {
+        ctx->stats.total_ns += stats_clock_ns() - host_start;
+    }
+    if (gpu_end > gpu_start) {
+        ctx->stats.gpu_start_ns = (uint64_t)(gpu_start * 1e9);
+        ctx->stats.gpu_end_ns = (uint64_t)(gpu_end * 1e9);
+        ctx->stats.gpu_ns += ctx->stats.gpu_end_ns - ctx->stats.gpu_start_ns;
+    }
+}
+
+int metal_json_enable_stats(MetalContext* ctx, int enabled) {
+    if (!ctx) return -1;
+    ctx->stats_enabled = enabled != 0;
+    return 0;
+}
+
+int metal_json_get_stats(MetalContext* ctx, MetalJsonStats* stats) {
+    if (!ctx || !stats) return -1;
+    *stats = ctx->stats;
+    return 0;
+}
+
+void metal_json_reset_stats(MetalContext* ctx) {
+    if (ctx) memset(&ctx->stats, 0, sizeof(ctx->stats));
+}
+
 // =============================================================================
 // GpJSON-Inspired Full Stage 1 Pipeline
 // =============================================================================
@@ -427,18 +632,18 @@ int metal_json_create_quote_bitmap(MetalContext* ctx,
             return -1;
         }
 
-        ensure_buffers(ctx, size);
         ensure_gpjson_buffers(ctx, size);
 
         uint32_t num_chunks = (size + 63) / 64;
 
-        memcpy(ctx->input_buffer.contents, input, size);
+        NSUInteger input_offset = 0;
+        id<MTLBuffer> input_buffer = bind_input(ctx, input, size, &input_offset);
 
         id<MTLCommandBuffer> commandBuffer = [ctx->queue commandBuffer];
         id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
 
         [encoder setComputePipelineState:ctx->pipeline_quote_bitmap];
-        [encoder setBuffer:ctx->input_buffer offset:0 atIndex:0];
+        [encoder setBuffer:input_buffer offset:input_offset atIndex:0];
         [encoder setBuffer:ctx->quote_bits_buffer offset:0 atIndex:1];
         [encoder setBuffer:ctx->quote_carry_buffer offset:0 atIndex:2];
         [encoder setBytes:&size length:sizeof(size) atIndex:3];
@@ -538,12 +743,12 @@ int metal_json_extract_structural(MetalContext* ctx,
             return -1;
         }
 
-        ensure_buffers(ctx, size);
         ensure_gpjson_buffers(ctx, size);
 
         uint32_t num_chunks = (size + 63) / 64;
 
-        memcpy(ctx->input_buffer.contents, input, size);
+        NSUInteger input_offset = 0;
+        id<MTLBuffer> input_buffer = bind_input(ctx, input, size, &input_offset);
         memcpy(ctx->quote_bits_buffer.contents, string_mask, num_chunks * sizeof(uint64_t));
 
         // Reset atomic counter
@@ -554,7 +759,7 @@ int metal_json_extract_structural(MetalContext* ctx,
         id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
 
         [encoder setComputePipelineState:ctx->pipeline_extract_structural];
-        [encoder setBuffer:ctx->input_buffer offset:0 atIndex:0];
+        [encoder setBuffer:input_buffer offset:input_offset atIndex:0];
         [encoder setBuffer:ctx->quote_bits_buffer offset:0 atIndex:1];
         [encoder setBuffer:ctx->structural_pos_buffer offset:0 atIndex:2];
         [encoder setBuffer:ctx->structural_char_buffer offset:0 atIndex:3];
@@ -603,18 +808,18 @@ int metal_json_find_newlines(MetalContext* ctx,
             return -1;
         }
 
-        ensure_buffers(ctx, size);
         ensure_gpjson_buffers(ctx, size);
 
         uint32_t num_chunks = (size + 63) / 64;
 
-        memcpy(ctx->input_buffer.contents, input, size);
+        NSUInteger input_offset = 0;
+        id<MTLBuffer> input_buffer = bind_input(ctx, input, size, &input_offset);
 
         id<MTLCommandBuffer> commandBuffer = [ctx->queue commandBuffer];
         id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
 
         [encoder setComputePipelineState:ctx->pipeline_find_newlines];
-        [encoder setBuffer:ctx->input_buffer offset:0 atIndex:0];
+        [encoder setBuffer:input_buffer offset:input_offset atIndex:0];
         [encoder setBuffer:ctx->quote_bits_buffer offset:0 atIndex:1];  // Reuse for newlines
         [encoder setBytes:&size length:sizeof(size) atIndex:2];
 
@@ -638,6 +843,313 @@ int metal_json_find_newlines(MetalContext* ctx,
     }
 }
 
+/**
+ * Check if GpJSON pipeline is available.
+ */
+int metal_json_has_gpjson_pipeline(MetalContext* ctx) {
+    if (!ctx) return 0;
+    return (ctx->pipeline_quote_bitmap &&
+            ctx->pipeline_string_mask &&
+            ctx->pipeline_extract_structural) ? 1 : 0;
+}
+
+// Threads per group for the scan kernels (SCAN_GROUP_SIZE in json_classify.metal)
+#define METAL_SCAN_GROUP_SIZE 256
+
+static int has_ordered_compaction(MetalContext* ctx) {
+    return ctx->pipeline_structural_bitmap && ctx->pipeline_scan_chunks &&
+           ctx->pipeline_scan_groups && ctx->pipeline_scatter_structural &&
+           ctx->pipeline_scan_chunks.maxTotalThreadsPerThreadgroup >= METAL_SCAN_GROUP_SIZE &&
+           ctx->pipeline_scan_groups.maxTotalThreadsPerThreadgroup >= METAL_SCAN_GROUP_SIZE;
+}
+
+static void ensure_ordered_buffers(MetalContext* ctx, uint32_t num_chunks) {
+    if (ctx->ordered_buffer_chunks >= num_chunks) {
+        return;
+    }
+
+    // Round up to 1024 chunks (64KB of input)
+    uint32_t alloc_chunks = ((num_chunks + 1023) / 1024) * 1024;
+    uint32_t num_groups = alloc_chunks / METAL_SCAN_GROUP_SIZE;
+
+    ctx->structural_bits_buffer = [ctx->device newBufferWithLength:alloc_chunks * sizeof(uint64_t)
+                                                           options:MTLResourceStorageModePrivate];
+    ctx->chunk_offsets_buffer = [ctx->device newBufferWithLength:alloc_chunks * sizeof(uint32_t)
+                                                         options:MTLResourceStorageModePrivate];
+    ctx->group_sums_buffer = [ctx->device newBufferWithLength:num_groups * sizeof(uint32_t)
+                                                      options:MTLResourceStorageModePrivate];
+    ctx->ordered_buffer_chunks = alloc_chunks;
+}
+
+/**
+ * Compact `string_mask`-filtered structurals into document order:
+ * per-chunk popcount, exclusive scan (threadgroup + device-wide), scatter.
+ */
+static void encode_ordered_compaction(MetalContext* ctx,
+                                      id<MTLCommandBuffer> commandBuffer,
+                                      id<MTLBuffer> input,
+                                      NSUInteger input_offset,
+                                      uint32_t size,
+                                      id<MTLBuffer> string_mask,
+                                      id<MTLBuffer> structural_pos,
+                                      id<MTLBuffer> structural_char,
+                                      id<MTLBuffer> output_count) {
+    uint32_t num_chunks = (size + 63) / 64;
+    uint32_t num_groups = (num_chunks + METAL_SCAN_GROUP_SIZE - 1) / METAL_SCAN_GROUP_SIZE;
+    ensure_ordered_buffers(ctx, num_chunks);
+
+    // Bitmap + popcount per chunk
+    {
+        id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+        [encoder setComputePipelineState:ctx->pipeline_structural_bitmap];
+        [encoder setBuffer:input offset:input_offset atIndex:0];
+        [encoder setBuffer:string_mask offset:0 atIndex:1];
+        [encoder setBuffer:ctx->structural_bits_buffer offset:0 atIndex:2];
+        [encoder setBuffer:ctx->chunk_offsets_buffer offset:0 atIndex:3];
+        [encoder setBytes:&size length:sizeof(size) atIndex:4];
+
+        NSUInteger tpg = MIN(ctx->pipeline_structural_bitmap.maxTotalThreadsPerThreadgroup, num_chunks);
+        [encoder dispatchThreadgroups:MTLSizeMake((num_chunks + tpg - 1) / tpg, 1, 1)
+                threadsPerThreadgroup:MTLSizeMake(tpg, 1, 1)];
+        [encoder endEncoding];
+    }
+
+    // Exclusive scan within each group of METAL_SCAN_GROUP_SIZE chunks
+    {
+        id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+        [encoder setComputePipelineState:ctx->pipeline_scan_chunks];
+        [encoder setBuffer:ctx->chunk_offsets_buffer offset:0 atIndex:0];
+        [encoder setBuffer:ctx->group_sums_buffer offset:0 atIndex:1];
+        [encoder setBytes:&num_chunks length:sizeof(num_chunks) atIndex:2];
+        [encoder dispatchThreadgroups:MTLSizeMake(num_groups, 1, 1)
+                threadsPerThreadgroup:MTLSizeMake(METAL_SCAN_GROUP_SIZE, 1, 1)];
+        [encoder endEncoding];
+    }
+
+    // Device-wide scan of the group sums (single threadgroup) + total count
+    {
+        id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+        [encoder setComputePipelineState:ctx->pipeline_scan_groups];
+        [encoder setBuffer:ctx->group_sums_buffer offset:0 atIndex:0];
+        [encoder setBuffer:output_count offset:0 atIndex:1];
+        [encoder setBytes:&num_groups length:sizeof(num_groups) atIndex:2];
+        [encoder dispatchThreadgroups:MTLSizeMake(1, 1, 1)
+                threadsPerThreadgroup:MTLSizeMake(METAL_SCAN_GROUP_SIZE, 1, 1)];
+        [encoder endEncoding];
+    }
+
+    // Scatter at the precomputed offsets
+    {
+        id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+        [encoder setComputePipelineState:ctx->pipeline_scatter_structural];
+        [encoder setBuffer:input offset:input_offset atIndex:0];
+        [encoder setBuffer:ctx->structural_bits_buffer offset:0 atIndex:1];
+        [encoder setBuffer:ctx->chunk_offsets_buffer offset:0 atIndex:2];
+        [encoder setBuffer:ctx->group_sums_buffer offset:0 atIndex:3];
+        [encoder setBuffer:structural_pos offset:0 atIndex:4];
+        [encoder setBuffer:structural_char offset:0 atIndex:5];
+        [encoder setBytes:&num_chunks length:sizeof(num_chunks) atIndex:6];
+
+        NSUInteger tpg = MIN(ctx->pipeline_scatter_structural.maxTotalThreadsPerThreadgroup, num_chunks);
+        [encoder dispatchThreadgroups:MTLSizeMake((num_chunks + tpg - 1) / tpg, 1, 1)
+                threadsPerThreadgroup:MTLSizeMake(tpg, 1, 1)];
+        [encoder endEncoding];
+    }
+}
+
+// Threads (= 64-byte chunks) per group for stage1_single_pass
+#define METAL_LOOKBACK_GROUP_SIZE 128
+
+// Inclusive counts are packed into 29 bits of the lookback status word
+#define METAL_SINGLE_PASS_MAX_SIZE (1u << 29)
+
+static int has_single_pass(MetalContext* ctx, uint32_t size) {
+    return ctx->pipeline_single_pass &&
+           ctx->pipeline_single_pass.maxTotalThreadsPerThreadgroup >= METAL_LOOKBACK_GROUP_SIZE &&
+           size > 0 && size < METAL_SINGLE_PASS_MAX_SIZE;
+}
+
+int metal_json_has_ordered_stage1(MetalContext* ctx, uint32_t size) {
+    return metal_json_has_gpjson_pipeline(ctx) &&
+           (has_single_pass(ctx, size) || has_ordered_compaction(ctx));
+}
+
+int metal_json_has_exact_stage1(MetalContext* ctx, uint32_t size) {
+    return metal_json_has_gpjson_pipeline(ctx) && has_single_pass(ctx, size);
+}
+
+/**
+ * Encode Stage 1 as one dispatch of a lookback kernel (stage1_single_pass
+ * or batch_stage1_single_pass): the input is read once, escape and string
+ * carries and output offsets resolved by decoupled lookback.
+ */
+static void encode_single_pass(MetalContext* ctx,
+                               id<MTLComputePipelineState> pipeline,
+                               id<MTLCommandBuffer> commandBuffer,
+                               id<MTLBuffer> input,
+                               NSUInteger input_offset,
+                               uint32_t size,
+                               id<MTLBuffer> structural_pos,
+                               id<MTLBuffer> structural_char,
+                               id<MTLBuffer> output_count) {
+    uint32_t num_chunks = (size + 63) / 64;
+    uint32_t num_groups = (num_chunks + METAL_LOOKBACK_GROUP_SIZE - 1) / METAL_LOOKBACK_GROUP_SIZE;
+
+    if (ctx->lookback_buffer_groups < num_groups) {
+        uint32_t alloc_groups = ((num_groups + 255) / 256) * 256;
+        ctx->lookback_buffer = [ctx->device newBufferWithLength:(2 * alloc_groups + 1) * sizeof(uint32_t)
+                                                        options:MTLResourceStorageModePrivate];
+        ctx->lookback_buffer_groups = alloc_groups;
+    }
+
+    // Clear ticket + status words on the GPU timeline (slots share the buffer)
+    NSUInteger escape_offset = (ctx->lookback_buffer_groups + 1) * sizeof(uint32_t);
+    {
+        id<MTLBlitCommandEncoder> blit = [commandBuffer blitCommandEncoder];
+        [blit fillBuffer:ctx->lookback_buffer
+                   range:NSMakeRange(0, (num_groups + 1) * sizeof(uint32_t))
+                   value:0];
+        [blit fillBuffer:ctx->lookback_buffer
+                   range:NSMakeRange(escape_offset, num_groups * sizeof(uint32_t))
+                   value:0];
+        [blit endEncoding];
+    }
+
+    id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+    [encoder setComputePipelineState:pipeline];
+    [encoder setBuffer:input offset:input_offset atIndex:0];
+    [encoder setBuffer:structural_pos offset:0 atIndex:1];
+    [encoder setBuffer:structural_char offset:0 atIndex:2];
+    [encoder setBuffer:output_count offset:0 atIndex:3];
+    [encoder setBuffer:ctx->lookback_buffer offset:0 atIndex:4];
+    [encoder setBuffer:ctx->lookback_buffer offset:sizeof(uint32_t) atIndex:5];
+    [encoder setBytes:&size length:sizeof(size) atIndex:6];
+    [encoder setBuffer:ctx->lookback_buffer offset:escape_offset atIndex:7];
+    [encoder dispatchThreadgroups:MTLSizeMake(num_groups, 1, 1)
+            threadsPerThreadgroup:MTLSizeMake(METAL_LOOKBACK_GROUP_SIZE, 1, 1)];
+    [encoder endEncoding];
+}
+
+/**
+ * Encode the three GpJSON passes into `commandBuffer`, reading `input` at
+ * `input_offset` and writing into the given result buffers.
+ *
+ * With stage1_single_pass in the metallib (and input below 512 MB) this is
+ * a single dispatch instead. Otherwise pass 3 uses ordered compaction when
+ * available, so positions come out in document order, else the atomic
+ * append.
+ */
+static void encode_full_stage1(MetalContext* ctx,
+                               id<MTLCommandBuffer> commandBuffer,
+                               id<MTLBuffer> input,
+                               NSUInteger input_offset,
+                               uint32_t size,
+                               id<MTLBuffer> quote_bits,
+                               id<MTLBuffer> quote_carry,
+                               id<MTLBuffer> structural_pos,
+                               id<MTLBuffer> structural_char,
+                               id<MTLBuffer> atomic_counter) {
+    if (has_single_pass(ctx, size)) {
+        encode_single_pass(ctx, ctx->pipeline_single_pass, commandBuffer,
+                           input, input_offset, size,
+                           structural_pos, structural_char, atomic_counter);
+        return;
+    }
+
+    uint32_t num_chunks = (size + 63) / 64;
+
+    // Pass 1: Create quote bitmap
+    {
+        id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+        [encoder setComputePipelineState:ctx->pipeline_quote_bitmap];
+        [encoder setBuffer:input offset:input_offset atIndex:0];
+        [encoder setBuffer:quote_bits offset:0 atIndex:1];
+        [encoder setBuffer:quote_carry offset:0 atIndex:2];
+        [encoder setBytes:&size length:sizeof(size) atIndex:3];
+
+        NSUInteger tpg = MIN(ctx->pipeline_quote_bitmap.maxTotalThreadsPerThreadgroup, num_chunks);
+        [encoder dispatchThreadgroups:MTLSizeMake((num_chunks + tpg - 1) / tpg, 1, 1)
+                threadsPerThreadgroup:MTLSizeMake(tpg, 1, 1)];
+        [encoder endEncoding];
+    }
+
+    // Pass 2: Create string mask (depends on pass 1)
+    {
+        id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+        [encoder setComputePipelineState:ctx->pipeline_string_mask];
+        [encoder setBuffer:quote_bits offset:0 atIndex:0];
+        [encoder setBuffer:quote_carry offset:0 atIndex:1];
+        [encoder setBytes:&num_chunks length:sizeof(num_chunks) atIndex:2];
+
+        NSUInteger tpg = MIN(ctx->pipeline_string_mask.maxTotalThreadsPerThreadgroup, num_chunks);
+        [encoder dispatchThreadgroups:MTLSizeMake((num_chunks + tpg - 1) / tpg, 1, 1)
+                threadsPerThreadgroup:MTLSizeMake(tpg, 1, 1)];
+        [encoder endEncoding];
+    }
+
+    // Pass 3: Extract structural positions (depends on pass 2)
+    if (has_ordered_compaction(ctx)) {
+        encode_ordered_compaction(ctx, commandBuffer, input, input_offset, size,
+                                  quote_bits, structural_pos, structural_char,
+                                  atomic_counter);
+    } else {
+        // Reset atomic counter
+        *(uint32_t*)atomic_counter.contents = 0;
+
+        id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+        [encoder setComputePipelineState:ctx->pipeline_extract_structural];
+        [encoder setBuffer:input offset:input_offset atIndex:0];
+        [encoder setBuffer:quote_bits offset:0 atIndex:1];
+        [encoder setBuffer:structural_pos offset:0 atIndex:2];
+        [encoder setBuffer:structural_char offset:0 atIndex:3];
+        [encoder setBuffer:atomic_counter offset:0 atIndex:4];
+        [encoder setBytes:&size length:sizeof(size) atIndex:5];
+
+        NSUInteger tpg = MIN(ctx->pipeline_extract_structural.maxTotalThreadsPerThreadgroup, (NSUInteger)size);
+        [encoder dispatchThreadgroups:MTLSizeMake((size + tpg - 1) / tpg, 1, 1)
+                threadsPerThreadgroup:MTLSizeMake(tpg, 1, 1)];
+        [encoder endEncoding];
+    }
+}
+
+/**
+ * Run the three GpJSON passes synchronously; results stay in the context's
+ * structural_pos / structural_char / atomic_counter buffers.
+ */
+static int run_full_stage1(MetalContext* ctx, const uint8_t* input, uint32_t size) {
+    // Check all required pipelines are available
+    if (!metal_json_has_gpjson_pipeline(ctx)) {
+        return -1;
+    }
+
+    uint64_t host_start = stats_begin(ctx);
+    ensure_gpjson_buffers(ctx, size);
+
+    // Bind input in place when it is GPU-visible, else copy once
+    NSUInteger input_offset = 0;
+    id<MTLBuffer> input_buffer = bind_input(ctx, input, size, &input_offset);
+
+    // Create command buffer for all passes
+    id<MTLCommandBuffer> commandBuffer = [ctx->queue commandBuffer];
+    encode_full_stage1(ctx, commandBuffer, input_buffer, input_offset, size,
+                       ctx->quote_bits_buffer, ctx->quote_carry_buffer,
+                       ctx->structural_pos_buffer, ctx->structural_char_buffer,
+                       ctx->atomic_counter_buffer);
+
+    [commandBuffer commit];
+    [commandBuffer waitUntilCompleted];
+
+    if (commandBuffer.error) {
+        fprintf(stderr, "metal_json_full_stage1: GPU execution failed: %s\n",
+                commandBuffer.error.localizedDescription.UTF8String);
+        return -1;
+    }
+
+    stats_record(ctx, commandBuffer.GPUStartTime, commandBuffer.GPUEndTime, size,
+                 *(const uint32_t*)ctx->atomic_counter_buffer.contents, host_start);
+    return 0;
+}
+
 /**
  * Full GPU Stage 1: Run the complete GpJSON pipeline.
  *
@@ -665,102 +1177,345 @@ int metal_json_full_stage1(MetalContext* ctx,
             return -1;
         }
 
-        // Check all required pipelines are available
-        if (!ctx->pipeline_quote_bitmap ||
-            !ctx->pipeline_string_mask ||
-            !ctx->pipeline_extract_structural) {
+        if (run_full_stage1(ctx, input, size) != 0) {
             return -1;
         }
 
-        ensure_buffers(ctx, size);
-        ensure_gpjson_buffers(ctx, size);
+        // Copy results back
+        memcpy(output_count, ctx->atomic_counter_buffer.contents, sizeof(uint32_t));
+        if (*output_count > 0) {
+            memcpy(output_pos, ctx->structural_pos_buffer.contents, *output_count * sizeof(uint32_t));
+            memcpy(output_chars, ctx->structural_char_buffer.contents, *output_count);
+        }
 
-        uint32_t num_chunks = (size + 63) / 64;
+        return 0;
+    }
+}
 
-        // Copy input once
-        memcpy(ctx->input_buffer.contents, input, size);
+/**
+ * Full GPU Stage 1 without host-side copies.
+ *
+ * Same pipeline as metal_json_full_stage1, but results are returned as
+ * pointers into the context's shared result buffers instead of being copied
+ * out. Combined with metal_json_input_buffer or metal_json_register_input
+ * for the input, no bytes are copied on the host at all.
+ *
+ * @param output_pos Output: borrowed pointer to positions
+ * @param output_chars Output: borrowed pointer to characters
+ * @param output_count Output: Number found
+ * @return 0 on success, -1 on failure
+ */
+int metal_json_full_stage1_borrowed(MetalContext* ctx,
+                                    const uint8_t* input,
+                                    uint32_t size,
+                                    const uint32_t** output_pos,
+                                    const uint8_t** output_chars,
+                                    uint32_t* output_count) {
+    @autoreleasepool {
+        if (!ctx || !input || size == 0 || !output_pos || !output_chars || !output_count) {
+            return -1;
+        }
 
-        // Create command buffer for all passes
-        id<MTLCommandBuffer> commandBuffer = [ctx->queue commandBuffer];
+        if (run_full_stage1(ctx, input, size) != 0) {
+            return -1;
+        }
+
+        *output_count = *(const uint32_t*)ctx->atomic_counter_buffer.contents;
+        *output_pos = ctx->structural_pos_buffer.contents;
+        *output_chars = ctx->structural_char_buffer.contents;
+        return 0;
+    }
+}
+
+// =============================================================================
+// NDJSON Batch Stage 1
+// =============================================================================
+
+int metal_json_has_batch_stage1(MetalContext* ctx) {
+    return ctx && ctx->pipeline_batch_single_pass &&
+           ctx->pipeline_batch_single_pass.maxTotalThreadsPerThreadgroup >= METAL_LOOKBACK_GROUP_SIZE;
+}
 
-        // Pass 1: Create quote bitmap
-        {
-            id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
-            [encoder setComputePipelineState:ctx->pipeline_quote_bitmap];
-            [encoder setBuffer:ctx->input_buffer offset:0 atIndex:0];
-            [encoder setBuffer:ctx->quote_bits_buffer offset:0 atIndex:1];
-            [encoder setBuffer:ctx->quote_carry_buffer offset:0 atIndex:2];
-            [encoder setBytes:&size length:sizeof(size) atIndex:3];
-
-            NSUInteger tpg = MIN(ctx->pipeline_quote_bitmap.maxTotalThreadsPerThreadgroup, num_chunks);
-            [encoder dispatchThreadgroups:MTLSizeMake((num_chunks + tpg - 1) / tpg, 1, 1)
-                    threadsPerThreadgroup:MTLSizeMake(tpg, 1, 1)];
-            [encoder endEncoding];
-        }
-
-        // Pass 2: Create string mask (depends on pass 1)
-        {
-            id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
-            [encoder setComputePipelineState:ctx->pipeline_string_mask];
-            [encoder setBuffer:ctx->quote_bits_buffer offset:0 atIndex:0];
-            [encoder setBuffer:ctx->quote_carry_buffer offset:0 atIndex:1];
-            [encoder setBytes:&num_chunks length:sizeof(num_chunks) atIndex:2];
-
-            NSUInteger tpg = MIN(ctx->pipeline_string_mask.maxTotalThreadsPerThreadgroup, num_chunks);
-            [encoder dispatchThreadgroups:MTLSizeMake((num_chunks + tpg - 1) / tpg, 1, 1)
-                    threadsPerThreadgroup:MTLSizeMake(tpg, 1, 1)];
-            [encoder endEncoding];
-        }
-
-        // Pass 3: Extract structural positions (depends on pass 2)
-        {
-            // Reset atomic counter
-            uint32_t zero = 0;
-            memcpy(ctx->atomic_counter_buffer.contents, &zero, sizeof(zero));
-
-            id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
-            [encoder setComputePipelineState:ctx->pipeline_extract_structural];
-            [encoder setBuffer:ctx->input_buffer offset:0 atIndex:0];
-            [encoder setBuffer:ctx->quote_bits_buffer offset:0 atIndex:1];
-            [encoder setBuffer:ctx->structural_pos_buffer offset:0 atIndex:2];
-            [encoder setBuffer:ctx->structural_char_buffer offset:0 atIndex:3];
-            [encoder setBuffer:ctx->atomic_counter_buffer offset:0 atIndex:4];
-            [encoder setBytes:&size length:sizeof(size) atIndex:5];
-
-            NSUInteger tpg = MIN(ctx->pipeline_extract_structural.maxTotalThreadsPerThreadgroup, (NSUInteger)size);
-            [encoder dispatchThreadgroups:MTLSizeMake((size + tpg - 1) / tpg, 1, 1)
-                    threadsPerThreadgroup:MTLSizeMake(tpg, 1, 1)];
-            [encoder endEncoding];
+/**
+ * Stage 1 over every record of an NDJSON buffer in one dispatch.
+ *
+ * The kernel resets string state at each '\n', so each record is indexed
+ * as if on its own. Record ranges are then cut from the document-ordered
+ * output with one linear merge against line_offsets.
+ */
+int metal_json_batch_stage1(MetalContext* ctx,
+                            const uint8_t* input,
+                            uint32_t size,
+                            const uint32_t* line_offsets,
+                            uint32_t n_lines,
+                            const uint32_t** output_pos,
+                            const uint8_t** output_chars,
+                            uint32_t* record_offsets,
+                            uint32_t* record_counts,
+                            uint32_t* output_count) {
+    @autoreleasepool {
+        if (!ctx || !input || size == 0 || !output_pos || !output_chars || !output_count) {
+            return -1;
         }
+        if (n_lines > 0 && (!line_offsets || !record_offsets || !record_counts)) {
+            return -1;
+        }
+        if (!metal_json_has_batch_stage1(ctx) || size >= METAL_SINGLE_PASS_MAX_SIZE) {
+            return -1;
+        }
+
+        uint64_t host_start = stats_begin(ctx);
+        ensure_gpjson_buffers(ctx, size);
+
+        NSUInteger input_offset = 0;
+        id<MTLBuffer> input_buffer = bind_input(ctx, input, size, &input_offset);
+
+        id<MTLCommandBuffer> commandBuffer = [ctx->queue commandBuffer];
+        encode_single_pass(ctx, ctx->pipeline_batch_single_pass, commandBuffer,
+                           input_buffer, input_offset, size,
+                           ctx->structural_pos_buffer, ctx->structural_char_buffer,
+                           ctx->atomic_counter_buffer);
 
         [commandBuffer commit];
         [commandBuffer waitUntilCompleted];
 
         if (commandBuffer.error) {
-            fprintf(stderr, "metal_json_full_stage1: GPU execution failed: %s\n",
+            fprintf(stderr, "metal_json_batch_stage1: GPU execution failed: %s\n",
                     commandBuffer.error.localizedDescription.UTF8String);
             return -1;
         }
 
-        // Copy results back
-        memcpy(output_count, ctx->atomic_counter_buffer.contents, sizeof(uint32_t));
-        if (*output_count > 0) {
-            memcpy(output_pos, ctx->structural_pos_buffer.contents, *output_count * sizeof(uint32_t));
-            memcpy(output_chars, ctx->structural_char_buffer.contents, *output_count);
+        const uint32_t* positions = ctx->structural_pos_buffer.contents;
+        uint32_t count = *(const uint32_t*)ctx->atomic_counter_buffer.contents;
+        stats_record(ctx, commandBuffer.GPUStartTime, commandBuffer.GPUEndTime, size,
+                     count, host_start);
+
+        // Lines are sorted and disjoint: one pass over the positions
+        uint32_t k = 0;
+        for (uint32_t i = 0; i < n_lines; i++) {
+            uint32_t start = line_offsets[2 * i];
+            uint32_t end = line_offsets[2 * i + 1];
+
+            while (k < count && positions[k] < start) k++;
+            record_offsets[i] = k;
+            while (k < count && positions[k] < end) k++;
+            record_counts[i] = k - record_offsets[i];
         }
 
+        *output_pos = positions;
+        *output_chars = ctx->structural_char_buffer.contents;
+        *output_count = count;
         return 0;
     }
 }
 
+// =============================================================================
+// Zero-Copy Input
+// =============================================================================
+
 /**
- * Check if GpJSON pipeline is available.
+ * Get a pointer into the context's shared input buffer, sized for `size`
+ * bytes, so callers can read a file straight into GPU-visible memory.
  */
-int metal_json_has_gpjson_pipeline(MetalContext* ctx) {
-    if (!ctx) return 0;
-    return (ctx->pipeline_quote_bitmap &&
-            ctx->pipeline_string_mask &&
-            ctx->pipeline_extract_structural) ? 1 : 0;
+uint8_t* metal_json_input_buffer(MetalContext* ctx, uint32_t size) {
+    if (!ctx || size == 0) return NULL;
+    ensure_buffers(ctx, size);
+    return ctx->input_buffer.contents;
+}
+
+/**
+ * Register caller-owned memory for zero-copy GPU access.
+ */
+int metal_json_register_input(MetalContext* ctx, const void* host_ptr, size_t length) {
+    @autoreleasepool {
+        if (!ctx || !host_ptr || length == 0) {
+            return -1;
+        }
+
+        // newBufferWithBytesNoCopy requires page-aligned address and length
+        size_t page = (size_t)getpagesize();
+        if (((uintptr_t)host_ptr % page) != 0 || (length % page) != 0) {
+            return -1;
+        }
+
+        id<MTLBuffer> buffer = [ctx->device newBufferWithBytesNoCopy:(void*)host_ptr
+                                                              length:length
+                                                             options:MTLResourceStorageModeShared
+                                                         deallocator:nil];
+        if (!buffer) {
+            return -1;
+        }
+
+        ctx->registered_buffer = buffer;
+        ctx->registered_base = host_ptr;
+        ctx->registered_length = length;
+        return 0;
+    }
+}
+
+/**
+ * Drop the registered no-copy buffer (the memory itself stays the caller's).
+ */
+void metal_json_unregister_input(MetalContext* ctx) {
+    if (!ctx) return;
+    ctx->registered_buffer = nil;
+    ctx->registered_base = NULL;
+    ctx->registered_length = 0;
+}
+
+// =============================================================================
+// Async Stage 1 (double / triple buffered)
+// =============================================================================
+
+/**
+ * Ensure a ring slot's buffers fit `size` bytes (same layout as the GpJSON
+ * buffers, 64KB rounded).
+ */
+static int ensure_slot_buffers(MetalContext* ctx, MetalStage1Slot* slot, uint32_t size) {
+    if (slot->buffer_size >= size && slot->input_buffer) {
+        return 0;
+    }
+
+    uint32_t alloc_size = ((size + 65535) / 65536) * 65536;
+    uint32_t num_chunks = alloc_size / 64;
+    MTLResourceOptions shared = MTLResourceStorageModeShared;
+
+    slot->input_buffer = [ctx->device newBufferWithLength:alloc_size options:shared];
+    slot->quote_bits_buffer = [ctx->device newBufferWithLength:num_chunks * sizeof(uint64_t) options:shared];
+    slot->quote_carry_buffer = [ctx->device newBufferWithLength:num_chunks options:shared];
+    slot->structural_pos_buffer = [ctx->device newBufferWithLength:alloc_size * sizeof(uint32_t) options:shared];
+    slot->structural_char_buffer = [ctx->device newBufferWithLength:alloc_size options:shared];
+    slot->atomic_counter_buffer = [ctx->device newBufferWithLength:sizeof(uint32_t) options:shared];
+
+    if (!slot->input_buffer || !slot->quote_bits_buffer || !slot->quote_carry_buffer ||
+        !slot->structural_pos_buffer || !slot->structural_char_buffer ||
+        !slot->atomic_counter_buffer) {
+        slot->buffer_size = 0;
+        return -1;
+    }
+
+    slot->buffer_size = alloc_size;
+    return 0;
+}
+
+/**
+ * Submit full GPU Stage 1 without waiting for it.
+ */
+int64_t metal_json_stage1_submit(MetalContext* ctx, const uint8_t* input, uint32_t size) {
+    @autoreleasepool {
+        if (!ctx || !input || size == 0 || !metal_json_has_gpjson_pipeline(ctx)) {
+            return -1;
+        }
+
+        uint64_t ticket = ++ctx->next_ticket;
+        MetalStage1Slot* slot = &ctx->ring[ticket % METAL_STAGE1_RING];
+
+        // The previous occupant has not been claimed with stage1_wait yet
+        if (slot->state != STAGE1_SLOT_FREE) {
+            ctx->next_ticket--;
+            return METAL_JSON_RING_FULL;
+        }
+
+        if (ensure_slot_buffers(ctx, slot, size) != 0) {
+            ctx->next_ticket--;
+            return -1;
+        }
+        if (!slot->done) {
+            slot->done = dispatch_semaphore_create(0);
+        }
+
+        // Registered (no-copy) memory is bound in place; anything else is
+        // copied into this slot so the caller may reuse its buffer at once
+        id<MTLBuffer> input_buffer = slot->input_buffer;
+        NSUInteger input_offset = 0;
+        if (ctx->registered_buffer &&
+            input >= ctx->registered_base &&
+            (size_t)(input - ctx->registered_base) + size <= ctx->registered_length &&
+            ((uintptr_t)(input - ctx->registered_base) & 15) == 0) {
+            input_buffer = ctx->registered_buffer;
+            input_offset = (NSUInteger)(input - ctx->registered_base);
+        } else {
+            memcpy(slot->input_buffer.contents, input, size);
+        }
+
+        slot->ticket = ticket;
+        slot->completed = 0;
+        slot->failed = 0;
+        slot->state = STAGE1_SLOT_IN_FLIGHT;
+        slot->input_size = size;
+        slot->gpu_start_time = 0;
+        slot->gpu_end_time = 0;
+
+        id<MTLCommandBuffer> commandBuffer = [ctx->queue commandBuffer];
+        encode_full_stage1(ctx, commandBuffer, input_buffer, input_offset, size,
+                           slot->quote_bits_buffer, slot->quote_carry_buffer,
+                           slot->structural_pos_buffer, slot->structural_char_buffer,
+                           slot->atomic_counter_buffer);
+
+        dispatch_semaphore_t done = slot->done;
+        int record_times = ctx->stats_enabled;
+        [commandBuffer addCompletedHandler:^(id<MTLCommandBuffer> cb) {
+            slot->failed = cb.error != nil;
+            if (record_times) {
+                slot->gpu_start_time = cb.GPUStartTime;
+                slot->gpu_end_time = cb.GPUEndTime;
+            }
+            __atomic_store_n(&slot->completed, 1, __ATOMIC_RELEASE);
+            dispatch_semaphore_signal(done);
+        }];
+        [commandBuffer commit];
+
+        return (int64_t)ticket;
+    }
+}
+
+/**
+ * Check whether a submitted Stage 1 job has finished.
+ */
+int metal_json_stage1_poll(MetalContext* ctx, int64_t ticket) {
+    if (!ctx || ticket <= 0) return -1;
+
+    MetalStage1Slot* slot = &ctx->ring[(uint64_t)ticket % METAL_STAGE1_RING];
+    if (slot->state != STAGE1_SLOT_IN_FLIGHT || slot->ticket != (uint64_t)ticket) {
+        return -1;
+    }
+    return __atomic_load_n(&slot->completed, __ATOMIC_ACQUIRE) ? 1 : 0;
+}
+
+/**
+ * Wait for a submitted Stage 1 job and claim its results.
+ */
+int metal_json_stage1_wait(MetalContext* ctx,
+                           int64_t ticket,
+                           const uint32_t** output_pos,
+                           const uint8_t** output_chars,
+                           uint32_t* output_count) {
+    if (!ctx || ticket <= 0 || !output_pos || !output_chars || !output_count) {
+        return -1;
+    }
+
+    MetalStage1Slot* slot = &ctx->ring[(uint64_t)ticket % METAL_STAGE1_RING];
+    if (slot->state != STAGE1_SLOT_IN_FLIGHT || slot->ticket != (uint64_t)ticket) {
+        return -1;
+    }
+
+    // Each completion signals once: consume it even if poll saw it first
+    dispatch_semaphore_wait(slot->done, DISPATCH_TIME_FOREVER);
+    slot->state = STAGE1_SLOT_FREE;
+
+    if (slot->failed) {
+        fprintf(stderr, "metal_json_stage1_wait: GPU execution failed\n");
+        return -1;
+    }
+
+    *output_count = *(const uint32_t*)slot->atomic_counter_buffer.contents;
+    *output_pos = slot->structural_pos_buffer.contents;
+    *output_chars = slot->structural_char_buffer.contents;
+
+    // The semaphore orders the handler's writes before these reads
+    stats_record(ctx, slot->gpu_start_time, slot->gpu_end_time, slot->input_size,
+                 *output_count, 0);
+    return 0;
 }
 
 // =============================================================================
@@ -809,13 +1564,14 @@ int metal_json_fused_extract(MetalContext* ctx,
             }
         }
 
-        ensure_buffers(ctx, size);
+        uint64_t host_start = stats_begin(ctx);
         ensure_gpjson_buffers(ctx, size);
 
         uint32_t num_chunks = (size + 63) / 64;
 
-        // Copy input
-        memcpy(ctx->input_buffer.contents, input, size);
+        // Bind input in place when it is GPU-visible, else copy once
+        NSUInteger input_offset = 0;
+        id<MTLBuffer> input_buffer = bind_input(ctx, input, size, &input_offset);
 
         // Reset atomic counter
         uint32_t zero = 0;
@@ -825,7 +1581,7 @@ int metal_json_fused_extract(MetalContext* ctx,
         id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
 
         [encoder setComputePipelineState:fused_pipeline];
-        [encoder setBuffer:ctx->input_buffer offset:0 atIndex:0];
+        [encoder setBuffer:input_buffer offset:input_offset atIndex:0];
         [encoder setBuffer:ctx->structural_pos_buffer offset:0 atIndex:1];
         [encoder setBuffer:ctx->structural_char_buffer offset:0 atIndex:2];
         [encoder setBuffer:ctx->atomic_counter_buffer offset:0 atIndex:3];
@@ -856,6 +1612,8 @@ int metal_json_fused_extract(MetalContext* ctx,
             memcpy(output_chars, ctx->structural_char_buffer.contents, *output_count);
         }
 
+        stats_record(ctx, commandBuffer.GPUStartTime, commandBuffer.GPUEndTime, size,
+                     *output_count, host_start);
         return 0;
     }
 }
@@ -868,3 +1626,113 @@ int metal_json_has_fused_kernel(MetalContext* ctx) {
     id<MTLFunction> func = [ctx->library newFunctionWithName:@"fused_structural_extract"];
     return func != nil;
 }
+
+
+// =============================================================================
+// Calibration
+// =============================================================================
+
+// Same synthetic sizes as neon_json_calibrate, fewer runs (GPU calls are slower)
+static const uint32_t METAL_CALIBRATION_SIZES[] = { 4 * 1024, 64 * 1024, 1024 * 1024 };
+#define METAL_NUM_CALIBRATION_SIZES 3
+#define METAL_CALIBRATION_MIN_RUNS 5
+#define METAL_CALIBRATION_MAX_RUNS 64
+
+static double calibration_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_samples(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Time metal_json_full_stage1 and fit overhead + size / throughput.
+ */
+int metal_json_calibrate(MetalContext* ctx, double* mb_per_s, double* overhead_ns) {
+    if (!ctx || !mb_per_s || !overhead_ns || !metal_json_has_gpjson_pipeline(ctx)) {
+        return -1;
+    }
+
+    uint32_t max_size = METAL_CALIBRATION_SIZES[METAL_NUM_CALIBRATION_SIZES - 1];
+    uint8_t* input = malloc(max_size);
+    uint32_t* positions = malloc(max_size * sizeof(uint32_t));
+    uint8_t* characters = malloc(max_size);
+    if (!input || !positions || !characters) {
+        free(input);
+        free(positions);
+        free(characters);
+        return -1;
+    }
+
+    static const char pattern[] = "{\"id\": 12345, \"name\": \"value\\\"q\\\"\", \"tags\": [1, 2, 3]}, ";
+    for (uint32_t n = 0; n < max_size;) {
+        uint32_t k = sizeof(pattern) - 1;
+        if (k > max_size - n) k = max_size - n;
+        memcpy(input + n, pattern, k);
+        n += k;
+    }
+
+    double sizes[METAL_NUM_CALIBRATION_SIZES];
+    double times[METAL_NUM_CALIBRATION_SIZES];
+    double samples[METAL_CALIBRATION_MAX_RUNS];
+    int status = 0;
+
+    for (int i = 0; i < METAL_NUM_CALIBRATION_SIZES && status == 0; i++) {
+        uint32_t size = METAL_CALIBRATION_SIZES[i];
+        uint32_t runs = (8 * 1024 * 1024) / size;
+        if (runs < METAL_CALIBRATION_MIN_RUNS) runs = METAL_CALIBRATION_MIN_RUNS;
+        if (runs > METAL_CALIBRATION_MAX_RUNS) runs = METAL_CALIBRATION_MAX_RUNS;
+
+        // Warm-up: pipelines, buffer growth
+        uint32_t count;
+        status = metal_json_full_stage1(ctx, input, size, positions, characters, &count);
+
+        for (uint32_t r = 0; r < runs && status == 0; r++) {
+            double start = calibration_now_ns();
+            status = metal_json_full_stage1(ctx, input, size, positions, characters, &count);
+            samples[r] = calibration_now_ns() - start;
+        }
+
+        qsort(samples, runs, sizeof(double), compare_samples);
+        sizes[i] = (double)size;
+        times[i] = samples[runs / 2];
+    }
+
+    free(input);
+    free(positions);
+    free(characters);
+    if (status != 0) {
+        return -1;
+    }
+
+    // Least-squares fit (as in neon_json_calibrate.c)
+    double mean_x = 0, mean_y = 0;
+    for (int i = 0; i < METAL_NUM_CALIBRATION_SIZES; i++) {
+        mean_x += sizes[i];
+        mean_y += times[i];
+    }
+    mean_x /= METAL_NUM_CALIBRATION_SIZES;
+    mean_y /= METAL_NUM_CALIBRATION_SIZES;
+
+    double sxx = 0, sxy = 0;
+    for (int i = 0; i < METAL_NUM_CALIBRATION_SIZES; i++) {
+        sxx += (sizes[i] - mean_x) * (sizes[i] - mean_x);
+        sxy += (sizes[i] - mean_x) * (times[i] - mean_y);
+    }
+
+    double ns_per_byte = sxx > 0 ? sxy / sxx : 0;
+    double overhead = mean_y - ns_per_byte * mean_x;
+    if (ns_per_byte <= 0) {
+        ns_per_byte = times[METAL_NUM_CALIBRATION_SIZES - 1] / sizes[METAL_NUM_CALIBRATION_SIZES - 1];
+        overhead = 0;
+    }
+
+    *mb_per_s = 1e3 / ns_per_byte;
+    *overhead_ns = overhead < 0 ? 0 : overhead;
+    return 0;
+}
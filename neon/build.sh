@@ -1,9 +1,23 @@
 #!/bin/bash
 # Build script for NEON SIMD JSON library
 #
-# Usage: ./build.sh [clean|debug|release]
+# Usage: ./build.sh [clean|debug|release|bench]
 #
-# Produces: libneon_json.dylib
+# Produces: libneon_json.dylib (macOS) or libneon_json.so (Linux)
+#
+# ARM64 builds the NEON kernel; x86-64 builds the AVX2 / AVX-512 kernels
+# (neon_json_x86.c), picked at runtime via CPUID.
+#
+# neon_json_pool.c holds the worker pool for neon_json_find_structural_parallel;
+# neon_json_calibrate.c the backend calibration behind json_select_backend;
+# neon_json_number.c json_parse_numbers_batch (with the neon_json_pow5.c table);
+# neon_json_string.c json_unescape_string; neon_json_mmap.c json_mmap_open;
+# neon_json_tape.c json_build_tape; neon_json_query.c json_query_paths;
+# neon_json_ndjson.c json_ndjson_prefilter; neon_json_ndjson_parallel.c the
+# work-stealing NDJSON parser (json_ndjson_open); neon_json_write.c the tape
+# serializer (json_write_tape).
+#
+# "bench" builds the ARM64 movemask microbenchmark (bench_movemask).
 
 set -e
 
@@ -14,19 +28,36 @@ cd "$SCRIPT_DIR"
 BUILD_TYPE="${1:-release}"
 
 # Compiler settings
-CC="clang"
-CFLAGS_COMMON="-Wall -Wextra -Wpedantic -fPIC -shared"
-CFLAGS_COMMON="$CFLAGS_COMMON -march=armv8-a+simd+crypto"  # Enable NEON + crypto for vmull_p64
+CC="${CC:-clang}"
+CFLAGS_COMMON="-Wall -Wextra -Wpedantic -pthread"
+SOURCES="neon_json.c neon_json_pool.c neon_json_calibrate.c neon_json_number.c neon_json_pow5.c neon_json_string.c neon_json_mmap.c neon_json_tape.c neon_json_query.c neon_json_ndjson.c neon_json_ndjson_parallel.c neon_json_write.c"
+HAVE_NEON=0
 
 # Architecture-specific flags
-if [[ $(uname -m) == "arm64" ]]; then
-    CFLAGS_COMMON="$CFLAGS_COMMON -arch arm64"
+case "$(uname -m)" in
+    arm64|aarch64)
+        CFLAGS_COMMON="$CFLAGS_COMMON -march=armv8-a+simd+crypto"  # Enable NEON + crypto for vmull_p64
+        HAVE_NEON=1
+        if [[ $(uname -s) == "Darwin" ]]; then
+            CFLAGS_COMMON="$CFLAGS_COMMON -arch arm64"
+        fi
+        ;;
+    x86_64|amd64)
+        # No -mavx2: kernels use target attributes + CPUID dispatch
+        SOURCES="$SOURCES neon_json_x86.c"
+        ;;
+esac
+
+if [[ $(uname -s) == "Darwin" ]]; then
+    LIB_NAME="libneon_json.dylib"
+else
+    LIB_NAME="libneon_json.so"
 fi
 
 case "$BUILD_TYPE" in
     clean)
         echo "Cleaning build artifacts..."
-        rm -f libneon_json.dylib libneon_json.a *.o
+        rm -f libneon_json.dylib libneon_json.so libneon_json.a bench_movemask *.o
         echo "Done."
         exit 0
         ;;
@@ -38,38 +69,49 @@ case "$BUILD_TYPE" in
         CFLAGS="$CFLAGS_COMMON -O3 -DNDEBUG -flto"
         echo "Building release configuration..."
         ;;
+    bench)
+        if [[ "$HAVE_NEON" != "1" ]]; then
+            echo "bench_movemask is NEON-only (ARM64)"
+            exit 1
+        fi
+        echo "Building movemask microbenchmark..."
+        $CC $CFLAGS_COMMON -O3 -DNDEBUG -o bench_movemask bench_movemask.c $SOURCES
+        echo "Output: $(pwd)/bench_movemask"
+        echo "Run: ./bench_movemask [file.json] [--ghz 3.2]"
+        exit 0
+        ;;
     *)
         echo "Unknown build type: $BUILD_TYPE"
-        echo "Usage: $0 [clean|debug|release]"
+        echo "Usage: $0 [clean|debug|release|bench]"
         exit 1
         ;;
 esac
 
 # Build shared library
-echo "Compiling neon_json.c..."
-$CC $CFLAGS \
-    -o libneon_json.dylib \
-    neon_json.c
+echo "Compiling $SOURCES..."
+$CC $CFLAGS -fPIC -shared \
+    -o "$LIB_NAME" \
+    $SOURCES
 
 # Verify the build
-if [[ -f "libneon_json.dylib" ]]; then
+if [[ -f "$LIB_NAME" ]]; then
     echo ""
     echo "Build successful!"
-    echo "Output: $(pwd)/libneon_json.dylib"
+    echo "Output: $(pwd)/$LIB_NAME"
     echo ""
 
     # Show library info
     echo "Library info:"
-    file libneon_json.dylib
+    file "$LIB_NAME"
     echo ""
 
     # Show exported symbols
     echo "Exported symbols:"
-    nm -g libneon_json.dylib | grep " T " | head -10
+    nm -g "$LIB_NAME" | grep " T " | head -20
     echo ""
 
     # Show size
-    ls -lh libneon_json.dylib
+    ls -lh "$LIB_NAME"
 else
     echo "Build failed!"
     exit 1
@@ -5,78 +5,294 @@
  * Processes 64 bytes at a time (4x 16-byte vectors).
  *
  * Key techniques:
- * - vceqq_u8: 16-byte parallel comparison
- * - vpaddq_u8: Convert 128-bit mask to 16-bit (ARM's PMOVMSKB workaround)
+ * - vqtbl1q_u8: Low/high nibble table lookup classifies 16 bytes at once
+ * - vpaddq_u8: Fused 4-vector reduction to a 64-bit mask (ARM's PMOVMSKB workaround)
  * - vmull_p64: Carry-less multiply for prefix-XOR (string tracking)
+ *
+ * The portable Stage 1 driver (carries, tail handling, position extraction)
+ * lives here as well. On x86-64 it runs the AVX2 / AVX-512 kernels from
+ * neon_json_x86.c instead, selected at runtime via CPUID.
  */
 
 #include "neon_json.h"
-#include <arm_neon.h>
+#include "neon_json_internal.h"
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NEON_JSON_HAVE_NEON 1
+#endif
+
+/* Blocks classified per kernel call (8 KB of input, 1 KB of bitmaps on the stack) */
+#define STAGE1_BATCH_BLOCKS 128
+
+/* Input shape sniff: all-whitespace blocks among the first SHAPE_SNIFF_BYTES
+ * pick the whitespace-skipping kernel when at least 1 in SHAPE_PRETTY_RATIO
+ * of them are; shorter inputs are not worth sniffing */
+#define SHAPE_SNIFF_BYTES   4096
+#define SHAPE_SNIFF_MIN_LEN (4 * SHAPE_SNIFF_BYTES)
+#define SHAPE_PRETTY_RATIO  8
+
+/* Smallest segment worth a thread in neon_json_find_structural_parallel */
+#define PARALLEL_MIN_SEGMENT (256 * 1024)
+#define PARALLEL_MAX_THREADS 64
+
+/* Per-thread slice of a parallel Stage 1 run (buffers reused across calls) */
+typedef struct {
+    size_t start;                 /* Segment byte range [start, end) */
+    size_t end;
+    JsonStage1State entry;        /* Carry state entering the segment */
+    uint64_t exit_in_string;      /* prev_in_string after the segment */
+    uint64_t escape_blocks;       /* Backslash blocks in the last run of the segment */
+    uint32_t* positions;          /* Segment-local output (absolute positions) */
+    uint8_t* characters;
+    size_t capacity;
+    size_t count;                 /* Structurals found (may exceed capacity) */
+    size_t out_offset;            /* Exclusive prefix sum of counts */
+} ParallelSegment;
 
 /* Context for reusable buffers */
 struct NeonContext {
-    uint64_t* quote_bits;      /* Quote position bitmaps */
-    uint64_t* string_mask;     /* In-string mask */
-    size_t buffer_capacity;    /* Allocated capacity in chunks */
+    /* Owned output arena (neon_json_find_structural_arena): one 64-byte
+     * aligned block holding the positions, then the characters */
+    void* arena;
+    uint32_t* arena_positions;
+    uint8_t* arena_characters;
+    size_t arena_capacity;     /* Entries */
+
+    JsonStage1Kernel kernel;   /* Stage 1 kernel selected at init */
+    JsonStage1Kernel pretty_kernel;  /* Same ISA, skipping all-whitespace blocks */
+    const char* kernel_name;   /* "neon", "avx512", "avx2" or "scalar" */
+    JsonStage1ValidateKernel validate_kernel;  /* neon_json_find_structural_validated */
+
+    /* Resumable Stage 1 (neon_json_stage1_begin / feed / finish) */
+    JsonStage1State stream_state;   /* Quote parity + odd-backslash carry */
+    uint64_t stream_offset;         /* Absolute offset of stream_pending[0] */
+    uint8_t stream_pending[64];     /* Partial block carried between feeds */
+    size_t stream_pending_len;
+    int stream_active;
+
+    /* Parallel Stage 1 (neon_json_find_structural_parallel) */
+    JsonThreadPool* pool;           /* Created on first use, grown on demand */
+    ParallelSegment* segments;
+    size_t num_segments;            /* Allocated segment slots */
+
+    /* Open-container stack for neon_json_build_skip_index */
+    uint32_t* skip_stack;
+    size_t skip_stack_capacity;
+
+    /* Opt-in counters (json_ctx_enable_stats / json_ctx_get_stats) */
+    int stats_enabled;
+    JsonCtxStats stats;
 };
 
+static void scalar_stage1_blocks(const uint8_t* input, size_t num_blocks,
+                                 JsonStage1State* state, uint64_t* structurals);
+static void scalar_stage1_pretty_blocks(const uint8_t* input, size_t num_blocks,
+                                        JsonStage1State* state, uint64_t* structurals);
+static uint32_t scalar_stage1_validate_blocks(const uint8_t* input, size_t num_blocks,
+                                              JsonStage1State* state, JsonUtf8State* utf8,
+                                              uint64_t* structurals);
+#ifdef NEON_JSON_HAVE_NEON
+static void neon_stage1_blocks(const uint8_t* input, size_t num_blocks,
+                               JsonStage1State* state, uint64_t* structurals);
+static void neon_stage1_pretty_blocks(const uint8_t* input, size_t num_blocks,
+                                      JsonStage1State* state, uint64_t* structurals);
+static uint32_t neon_stage1_validate_blocks(const uint8_t* input, size_t num_blocks,
+                                            JsonStage1State* state, JsonUtf8State* utf8,
+                                            uint64_t* structurals);
+#endif
+
+/* Pick the fastest kernel for this CPU */
+static JsonStage1Kernel select_kernel(const char** name) {
+#if defined(NEON_JSON_HAVE_NEON)
+    *name = "neon";
+    return neon_stage1_blocks;
+#else
+#if defined(__x86_64__) || defined(_M_X64)
+    JsonStage1Kernel kernel = json_x86_select_kernel(name);
+    if (kernel) return kernel;
+#endif
+    *name = "scalar";
+    return scalar_stage1_blocks;
+#endif
+}
+
+/* Whitespace-skipping variant of select_kernel's pick */
+static JsonStage1Kernel select_pretty_kernel(void) {
+#if defined(NEON_JSON_HAVE_NEON)
+    return neon_stage1_pretty_blocks;
+#else
+#if defined(__x86_64__) || defined(_M_X64)
+    JsonStage1Kernel kernel = json_x86_select_pretty_kernel();
+    if (kernel) return kernel;
+#endif
+    return scalar_stage1_pretty_blocks;
+#endif
+}
+
+/* Validating kernel for this CPU (AVX-512 machines use the AVX2 one) */
+static JsonStage1ValidateKernel select_validate_kernel(void) {
+#if defined(NEON_JSON_HAVE_NEON)
+    return neon_stage1_validate_blocks;
+#else
+#if defined(__x86_64__) || defined(_M_X64)
+    JsonStage1ValidateKernel kernel = json_x86_select_validate_kernel();
+    if (kernel) return kernel;
+#endif
+    return scalar_stage1_validate_blocks;
+#endif
+}
+
 NeonContext* neon_json_init(void) {
     NeonContext* ctx = calloc(1, sizeof(NeonContext));
+    if (!ctx) return NULL;
+    ctx->kernel = select_kernel(&ctx->kernel_name);
+    ctx->pretty_kernel = select_pretty_kernel();
+    ctx->validate_kernel = select_validate_kernel();
     return ctx;
 }
 
+JsonStage1Kernel json_ctx_kernel(NeonContext* ctx) {
+    return ctx->kernel;
+}
+
+void json_ctx_force_scalar(NeonContext* ctx) {
+    ctx->kernel = scalar_stage1_blocks;
+    ctx->pretty_kernel = scalar_stage1_pretty_blocks;
+    ctx->kernel_name = "scalar";
+    ctx->validate_kernel = scalar_stage1_validate_blocks;
+}
+
 void neon_json_free(NeonContext* ctx) {
     if (ctx) {
-        free(ctx->quote_bits);
-        free(ctx->string_mask);
+        free(ctx->arena);
+        json_pool_destroy(ctx->pool);
+        for (size_t i = 0; i < ctx->num_segments; i++) {
+            free(ctx->segments[i].positions);
+            free(ctx->segments[i].characters);
+        }
+        free(ctx->segments);
+        free(ctx->skip_stack);
         free(ctx);
     }
 }
 
-/* Ensure buffers are allocated for given input size */
-static void ensure_buffers(NeonContext* ctx, size_t input_len) {
-    size_t num_chunks = (input_len + 63) / 64;
-    if (ctx->buffer_capacity >= num_chunks) return;
+/* Grow the output arena to hold `entries` structurals; returns 0 on success */
+static int ensure_arena(NeonContext* ctx, size_t entries) {
+    if (ctx->arena_capacity >= entries) return 0;
+
+    /* Geometric growth so a stream of slightly larger documents settles fast */
+    size_t capacity = ctx->arena_capacity * 2;
+    if (capacity < entries) capacity = entries;
+    capacity = (capacity + 63) / 64 * 64;
 
-    free(ctx->quote_bits);
-    free(ctx->string_mask);
+    void* arena = NULL;
+    if (posix_memalign(&arena, 64, capacity * sizeof(uint32_t) + capacity) != 0) {
+        return -1;
+    }
 
-    ctx->quote_bits = malloc(num_chunks * sizeof(uint64_t));
-    ctx->string_mask = malloc(num_chunks * sizeof(uint64_t));
-    ctx->buffer_capacity = num_chunks;
+    free(ctx->arena);
+    ctx->arena = arena;
+    ctx->arena_positions = arena;
+    ctx->arena_characters = (uint8_t*)arena + capacity * sizeof(uint32_t);
+    ctx->arena_capacity = capacity;
+    return 0;
 }
 
+/* =============================================================================
+ * NEON Kernel
+ * ============================================================================= */
+
+#ifdef NEON_JSON_HAVE_NEON
+
+/* Bit weights for movemask: byte i of each 8-byte half -> bit i */
+static const uint8_t MOVEMASK_BITS[16] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+};
+
 /**
- * Convert 16-byte comparison result to 16-bit bitmask.
+ * Convert four 16-byte comparison results to one 64-bit bitmask.
  * ARM doesn't have PMOVMSKB, so we use pairwise addition.
  *
- * Input: uint8x16_t with 0xFF or 0x00 per byte
- * Output: 16-bit mask where bit i = 1 if byte i was 0xFF
+ * All four vectors of a chunk are reduced together: after AND-ing with
+ * the bit weights, each vpaddq_u8 halves the bytes per vector while
+ * merging two vectors, so 64 bytes collapse into 8 in 4 adds (instead of
+ * 3 adds + a table load per 16-byte vector).
+ *
+ * Input: v0..v3 with 0xFF or 0x00 per byte (bytes 0-15, 16-31, ...)
+ * Output: 64-bit mask where bit i = 1 if byte i was 0xFF
  */
-static inline uint64_t neon_movemask_16(uint8x16_t v) {
-    /* Shift each byte to get high bit into position */
-    static const uint8_t shift_vals[16] = {
-        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
-        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
-    };
-    uint8x16_t shift_mask = vld1q_u8(shift_vals);
+static inline uint64_t neon_movemask_64(
+    uint8x16_t v0,
+    uint8x16_t v1,
+    uint8x16_t v2,
+    uint8x16_t v3,
+    uint8x16_t bit_mask
+) {
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(v0, bit_mask), vandq_u8(v1, bit_mask));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(v2, bit_mask), vandq_u8(v3, bit_mask));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
 
-    /* AND with shift mask to get bit positions */
-    uint8x16_t masked = vandq_u8(v, shift_mask);
+/*
+ * Nibble-table character classes (simdjson-style vqtbl1q_u8 lookup).
+ *
+ * class(c) = LO_TABLE[c & 0xF] & HI_TABLE[c >> 4]. Each class bit is a
+ * product of a low-nibble set and a high-nibble set, so the AND is exact:
+ *
+ *   COMMA      ','           hi {2}     lo {C}
+ *   COLON      ':'           hi {3}     lo {A}
+ *   BRACKET    '[' ']' '{' '}'  hi {5,7}   lo {B,D}
+ *   SPACE      ' '           hi {2}     lo {0}
+ *   WS_CTRL    '\t' '\n' '\r' hi {0}     lo {9,A,D}
+ *   QUOTE      '"'           hi {2}     lo {2}
+ *   BACKSLASH  '\\'          hi {5}     lo {C}
+ *
+ * The classes are disjoint, so every byte has at most one bit set.
+ * Bytes >= 0x80 hit HI_TABLE[8..F] = 0 and classify as "other".
+ */
+#define CLS_COMMA      0x01
+#define CLS_COLON      0x02
+#define CLS_BRACKET    0x04
+#define CLS_SPACE      0x08
+#define CLS_WS_CTRL    0x10
+#define CLS_QUOTE      0x20
+#define CLS_BACKSLASH  0x40
+#define CLS_OP         (CLS_COMMA | CLS_COLON | CLS_BRACKET)
 
-    /* Pairwise add to combine bytes into 2 uint64s */
-    uint8x16_t paired = vpaddq_u8(masked, masked);
-    paired = vpaddq_u8(paired, paired);
-    paired = vpaddq_u8(paired, paired);
+static const uint8_t CLS_LO_TABLE[16] = {
+    /* 0 */ CLS_SPACE, 0, CLS_QUOTE, 0, 0, 0, 0, 0,
+    /* 8 */ 0, CLS_WS_CTRL, CLS_COLON | CLS_WS_CTRL, CLS_BRACKET,
+    /* C */ CLS_COMMA | CLS_BACKSLASH, CLS_BRACKET | CLS_WS_CTRL, 0, 0
+};
 
-    /* Extract lower 16 bits */
-    return vgetq_lane_u16(vreinterpretq_u16_u8(paired), 0);
+static const uint8_t CLS_HI_TABLE[16] = {
+    /* 0 */ CLS_WS_CTRL, 0, CLS_COMMA | CLS_SPACE | CLS_QUOTE, CLS_COLON,
+    /* 4 */ 0, CLS_BRACKET | CLS_BACKSLASH, 0, CLS_BRACKET,
+    /* 8 */ 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* Classify 16 bytes into CLS_* bits: 2 lookups + AND + shift/mask */
+static inline uint8x16_t neon_classify_16(
+    uint8x16_t chunk,
+    uint8x16_t lo_table,
+    uint8x16_t hi_table
+) {
+    uint8x16_t lo = vandq_u8(chunk, vdupq_n_u8(0x0F));
+    uint8x16_t hi = vshrq_n_u8(chunk, 4);
+    return vandq_u8(vqtbl1q_u8(lo_table, lo), vqtbl1q_u8(hi_table, hi));
 }
 
 /**
  * Process 64 bytes and return structural/quote/backslash bitmasks.
+ * The structural mask covers { } [ ] : , only - quotes are reported separately.
  */
 static inline void classify_chunk_64(
     const uint8_t* input,
@@ -84,51 +300,73 @@ static inline void classify_chunk_64(
     uint64_t* quote_out,
     uint64_t* backslash_out
 ) {
-    uint64_t structural = 0;
-    uint64_t quotes = 0;
-    uint64_t backslashes = 0;
-
-    /* Constant vectors for comparison */
-    uint8x16_t v_quote = vdupq_n_u8('"');
-    uint8x16_t v_backslash = vdupq_n_u8('\\');
-    uint8x16_t v_brace_open = vdupq_n_u8('{');
-    uint8x16_t v_brace_close = vdupq_n_u8('}');
-    uint8x16_t v_bracket_open = vdupq_n_u8('[');
-    uint8x16_t v_bracket_close = vdupq_n_u8(']');
-    uint8x16_t v_colon = vdupq_n_u8(':');
-    uint8x16_t v_comma = vdupq_n_u8(',');
-
-    /* Process 4x 16-byte chunks */
-    for (int i = 0; i < 4; i++) {
-        uint8x16_t chunk = vld1q_u8(input + i * 16);
-
-        /* Character comparisons - each returns 0xFF or 0x00 per byte */
-        uint8x16_t is_quote = vceqq_u8(chunk, v_quote);
-        uint8x16_t is_backslash = vceqq_u8(chunk, v_backslash);
-        uint8x16_t is_brace_o = vceqq_u8(chunk, v_brace_open);
-        uint8x16_t is_brace_c = vceqq_u8(chunk, v_brace_close);
-        uint8x16_t is_brack_o = vceqq_u8(chunk, v_bracket_open);
-        uint8x16_t is_brack_c = vceqq_u8(chunk, v_bracket_close);
-        uint8x16_t is_colon = vceqq_u8(chunk, v_colon);
-        uint8x16_t is_comma = vceqq_u8(chunk, v_comma);
-
-        /* Combine structural characters */
-        uint8x16_t struct_mask = vorrq_u8(is_brace_o, is_brace_c);
-        struct_mask = vorrq_u8(struct_mask, is_brack_o);
-        struct_mask = vorrq_u8(struct_mask, is_brack_c);
-        struct_mask = vorrq_u8(struct_mask, is_colon);
-        struct_mask = vorrq_u8(struct_mask, is_comma);
-        struct_mask = vorrq_u8(struct_mask, is_quote);
-
-        /* Convert to bitmasks and place in correct position */
-        structural |= (uint64_t)neon_movemask_16(struct_mask) << (i * 16);
-        quotes |= (uint64_t)neon_movemask_16(is_quote) << (i * 16);
-        backslashes |= (uint64_t)neon_movemask_16(is_backslash) << (i * 16);
-    }
-
-    *structural_out = structural;
-    *quote_out = quotes;
-    *backslash_out = backslashes;
+    uint8x16_t lo_table = vld1q_u8(CLS_LO_TABLE);
+    uint8x16_t hi_table = vld1q_u8(CLS_HI_TABLE);
+    uint8x16_t bit_mask = vld1q_u8(MOVEMASK_BITS);
+    uint8x16_t v_op = vdupq_n_u8(CLS_OP);
+    uint8x16_t v_quote = vdupq_n_u8(CLS_QUOTE);
+    uint8x16_t v_backslash = vdupq_n_u8(CLS_BACKSLASH);
+
+    /* Classify 4x 16-byte chunks */
+    uint8x16_t c0 = neon_classify_16(vld1q_u8(input), lo_table, hi_table);
+    uint8x16_t c1 = neon_classify_16(vld1q_u8(input + 16), lo_table, hi_table);
+    uint8x16_t c2 = neon_classify_16(vld1q_u8(input + 32), lo_table, hi_table);
+    uint8x16_t c3 = neon_classify_16(vld1q_u8(input + 48), lo_table, hi_table);
+
+    /* vtstq_u8 yields 0xFF where any class bit matches; one fused movemask per class */
+    *structural_out = neon_movemask_64(vtstq_u8(c0, v_op), vtstq_u8(c1, v_op),
+                                       vtstq_u8(c2, v_op), vtstq_u8(c3, v_op), bit_mask);
+    *quote_out = neon_movemask_64(vtstq_u8(c0, v_quote), vtstq_u8(c1, v_quote),
+                                  vtstq_u8(c2, v_quote), vtstq_u8(c3, v_quote), bit_mask);
+    *backslash_out = neon_movemask_64(vtstq_u8(c0, v_backslash), vtstq_u8(c1, v_backslash),
+                                      vtstq_u8(c2, v_backslash), vtstq_u8(c3, v_backslash),
+                                      bit_mask);
+}
+
+/**
+ * Per-byte classification codes (NEON_CHAR_*) for 16 bytes.
+ *
+ * The class byte is one-hot, so vclzq_u8 turns it into a small index
+ * (8 = no class) that a second table maps to the code. Brackets share one
+ * class and are split using bit 5 ('{' vs '[') and bit 1 ('{' vs '}').
+ */
+static inline uint8x16_t neon_classify_codes_16(
+    uint8x16_t chunk,
+    uint8x16_t lo_table,
+    uint8x16_t hi_table
+) {
+    static const uint8_t CODE_BY_CLZ[16] = {
+        /* bit 7 */ NEON_CHAR_OTHER,
+        /* bit 6 */ NEON_CHAR_BACKSLASH,
+        /* bit 5 */ NEON_CHAR_QUOTE,
+        /* bit 4 */ NEON_CHAR_WHITESPACE,
+        /* bit 3 */ NEON_CHAR_WHITESPACE,
+        /* bit 2 */ NEON_CHAR_OTHER,  /* brackets, resolved below */
+        /* bit 1 */ NEON_CHAR_COLON,
+        /* bit 0 */ NEON_CHAR_COMMA,
+        /* none  */ NEON_CHAR_OTHER,
+        NEON_CHAR_OTHER, NEON_CHAR_OTHER, NEON_CHAR_OTHER, NEON_CHAR_OTHER,
+        NEON_CHAR_OTHER, NEON_CHAR_OTHER, NEON_CHAR_OTHER
+    };
+    /* Indexed by ((c >> 4) & 2) | ((c >> 1) & 1): ']' '[' '}' '{' */
+    static const uint8_t BRACKET_CODES[16] = {
+        NEON_CHAR_BRACKET_CLOSE, NEON_CHAR_BRACKET_OPEN,
+        NEON_CHAR_BRACE_CLOSE, NEON_CHAR_BRACE_OPEN,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    };
+
+    uint8x16_t lo = vandq_u8(chunk, vdupq_n_u8(0x0F));
+    uint8x16_t hi = vshrq_n_u8(chunk, 4);
+    uint8x16_t cls = vandq_u8(vqtbl1q_u8(lo_table, lo), vqtbl1q_u8(hi_table, hi));
+
+    uint8x16_t codes = vqtbl1q_u8(vld1q_u8(CODE_BY_CLZ), vclzq_u8(cls));
+
+    uint8x16_t bracket_idx = vorrq_u8(vandq_u8(hi, vdupq_n_u8(2)),
+                                      vandq_u8(vshrq_n_u8(chunk, 1), vdupq_n_u8(1)));
+    uint8x16_t bracket_codes = vqtbl1q_u8(vld1q_u8(BRACKET_CODES), bracket_idx);
+    uint8x16_t is_bracket = vtstq_u8(cls, vdupq_n_u8(CLS_BRACKET));
+
+    return vbslq_u8(is_bracket, bracket_codes, codes);
 }
 
 /**
@@ -149,46 +387,408 @@ static inline uint64_t prefix_xor(uint64_t mask) {
     return (uint64_t)result;
 }
 
+/* Whitespace by low nibble: a byte is whitespace iff it equals its entry */
+static const uint8_t WS_TABLE[16] = {
+    ' ', 0, 0, 0, 0, 0, 0, 0, 0, '\t', '\n', 0, 0, '\r', 0, 0
+};
+
+/* 64 bytes all whitespace: 4 lookups + compares, AND-reduced to one vminvq_u8 */
+static inline int neon_is_whitespace_64(const uint8_t* input, uint8x16_t ws_table) {
+    uint8x16_t low_nibble = vdupq_n_u8(0x0F);
+    uint8x16_t v0 = vld1q_u8(input);
+    uint8x16_t v1 = vld1q_u8(input + 16);
+    uint8x16_t v2 = vld1q_u8(input + 32);
+    uint8x16_t v3 = vld1q_u8(input + 48);
+
+    uint8x16_t ws01 = vandq_u8(vceqq_u8(v0, vqtbl1q_u8(ws_table, vandq_u8(v0, low_nibble))),
+                               vceqq_u8(v1, vqtbl1q_u8(ws_table, vandq_u8(v1, low_nibble))));
+    uint8x16_t ws23 = vandq_u8(vceqq_u8(v2, vqtbl1q_u8(ws_table, vandq_u8(v2, low_nibble))),
+                               vceqq_u8(v3, vqtbl1q_u8(ws_table, vandq_u8(v3, low_nibble))));
+    return vminvq_u8(vandq_u8(ws01, ws23)) == 0xFF;
+}
+
+JSON_KERNEL_BODY void neon_stage1_body(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    uint64_t* structurals,
+    const int skip_whitespace
+) {
+    uint8x16_t ws_table = vld1q_u8(WS_TABLE);
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        uint64_t structural, quotes, backslashes;
+
+        if (skip_whitespace && neon_is_whitespace_64(input + b * 64, ws_table)) {
+            structurals[b] = json_skip_whitespace_block(state);
+            continue;
+        }
+
+        classify_chunk_64(input + b * 64, &structural, &quotes, &backslashes);
+
+        /* Drop escaped quotes (quotes preceded by odd backslash runs) */
+        uint64_t escaped = json_find_escaped(backslashes, state);
+        quotes &= ~escaped;
+
+        structurals[b] = json_finish_block(state, structural, quotes, escaped,
+                                           prefix_xor(quotes));
+    }
+}
+
+static void neon_stage1_blocks(const uint8_t* input, size_t num_blocks,
+                               JsonStage1State* state, uint64_t* structurals) {
+    neon_stage1_body(input, num_blocks, state, structurals, 0);
+}
+
+static void neon_stage1_pretty_blocks(const uint8_t* input, size_t num_blocks,
+                                      JsonStage1State* state, uint64_t* structurals) {
+    neon_stage1_body(input, num_blocks, state, structurals, 1);
+}
+
+/* Last-3-byte thresholds: a block ending in one of these is mid-sequence */
+static const uint8_t UTF8_INCOMPLETE_MAX[16] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+};
+
 /**
- * Find positions where odd-length backslash sequences end.
- * These are the backslashes that actually escape the next character.
- *
- * Algorithm (from simdjson):
- * 1. Find starts of backslash sequences
- * 2. Find lengths by counting consecutive backslashes
- * 3. Odd-length sequences escape the following character
+ * UTF-8 lookup check for 16 bytes (simdjson): three nibble lookups over
+ * (prev1, input) find every bad 2-byte pair, and the saturating subtracts
+ * mark where a 3- or 4-byte lead requires a 2nd/3rd continuation.
+ * Non-zero bytes in the result are errors.
  */
-static inline uint64_t find_odd_backslash_sequences(uint64_t backslashes) {
-    if (backslashes == 0) return 0;
-
-    /* Find sequence starts (backslash not preceded by backslash) */
-    uint64_t starts = backslashes & ~(backslashes << 1);
-
-    /* For each sequence, determine if odd or even length */
-    /* This is the key insight: we can use arithmetic on the bits */
-
-    /* Simplified approach: check if quote follows odd number of backslashes */
-    /* Full simdjson uses a more complex carry-based approach */
-
-    /* For now, use a reasonable approximation:
-     * A backslash escapes if there's an odd number preceding a position */
-    uint64_t odd_ends = 0;
-    uint64_t seq = backslashes;
-    while (seq) {
-        int pos = __builtin_ctzll(seq);
-        int count = 0;
-        uint64_t temp = seq >> pos;
-        while (temp & 1) {
-            count++;
-            temp >>= 1;
+static inline uint8x16_t neon_utf8_check_16(uint8x16_t input, uint8x16_t prev) {
+    uint8x16_t prev1 = vextq_u8(prev, input, 15);
+    uint8x16_t prev2 = vextq_u8(prev, input, 14);
+    uint8x16_t prev3 = vextq_u8(prev, input, 13);
+
+    uint8x16_t byte_1_high = vqtbl1q_u8(vld1q_u8(JSON_UTF8_BYTE_1_HIGH), vshrq_n_u8(prev1, 4));
+    uint8x16_t byte_1_low = vqtbl1q_u8(vld1q_u8(JSON_UTF8_BYTE_1_LOW),
+                                       vandq_u8(prev1, vdupq_n_u8(0x0F)));
+    uint8x16_t byte_2_high = vqtbl1q_u8(vld1q_u8(JSON_UTF8_BYTE_2_HIGH), vshrq_n_u8(input, 4));
+    uint8x16_t special = vandq_u8(vandq_u8(byte_1_high, byte_1_low), byte_2_high);
+
+    uint8x16_t is_third = vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80));
+    uint8x16_t is_fourth = vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80));
+    uint8x16_t must23_80 = vandq_u8(vorrq_u8(is_third, is_fourth), vdupq_n_u8(0x80));
+
+    return veorq_u8(must23_80, special);
+}
+
+static uint32_t neon_stage1_validate_blocks(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    JsonUtf8State* utf8,
+    uint64_t* structurals
+) {
+    const uint8x16_t bit_mask = vld1q_u8(MOVEMASK_BITS);
+    const uint8x16_t incomplete_max = vld1q_u8(UTF8_INCOMPLETE_MAX);
+    const uint8x16_t v_control = vdupq_n_u8(0x20);
+
+    uint8x16_t prev = vld1q_u8(utf8->prev_block);
+    uint8x16_t incomplete = vld1q_u8(utf8->prev_incomplete);
+    uint8x16_t utf8_error = vdupq_n_u8(0);
+    uint64_t control = 0;
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        const uint8_t* block = input + b * 64;
+        uint64_t structural, quotes, backslashes;
+        classify_chunk_64(block, &structural, &quotes, &backslashes);
+
+        uint8x16_t v0 = vld1q_u8(block);
+        uint8x16_t v1 = vld1q_u8(block + 16);
+        uint8x16_t v2 = vld1q_u8(block + 32);
+        uint8x16_t v3 = vld1q_u8(block + 48);
+
+        if (vmaxvq_u8(vorrq_u8(vorrq_u8(v0, v1), vorrq_u8(v2, v3))) < 0x80) {
+            /* ASCII block: only a sequence left open by the previous one fails */
+            utf8_error = vorrq_u8(utf8_error, incomplete);
+            prev = vdupq_n_u8(0);
+            incomplete = vdupq_n_u8(0);
+        } else {
+            utf8_error = vorrq_u8(utf8_error, neon_utf8_check_16(v0, prev));
+            utf8_error = vorrq_u8(utf8_error, neon_utf8_check_16(v1, v0));
+            utf8_error = vorrq_u8(utf8_error, neon_utf8_check_16(v2, v1));
+            utf8_error = vorrq_u8(utf8_error, neon_utf8_check_16(v3, v2));
+            incomplete = vqsubq_u8(v3, incomplete_max);
+            prev = v3;
+        }
+
+        uint64_t controls = neon_movemask_64(vcltq_u8(v0, v_control), vcltq_u8(v1, v_control),
+                                             vcltq_u8(v2, v_control), vcltq_u8(v3, v_control),
+                                             bit_mask);
+
+        uint64_t escaped = json_find_escaped(backslashes, state);
+        quotes &= ~escaped;
+        uint64_t quote_xor = prefix_xor(quotes);
+
+        control |= controls & json_string_mask(state, quote_xor);
+        structurals[b] = json_finish_block(state, structural, quotes, escaped, quote_xor);
+    }
+
+    vst1q_u8(utf8->prev_block, prev);
+    vst1q_u8(utf8->prev_incomplete, incomplete);
+
+    return (vmaxvq_u8(utf8_error) ? NEON_JSON_INVALID_UTF8 : 0) |
+           (control ? NEON_JSON_INVALID_CONTROL : 0);
+}
+
+#endif /* NEON_JSON_HAVE_NEON */
+
+/* =============================================================================
+ * Scalar Kernel (portable fallback)
+ * ============================================================================= */
+
+/* 64 bytes all whitespace; exits at the first other byte */
+static inline int scalar_is_whitespace_64(const uint8_t* block) {
+    for (int j = 0; j < 64; j++) {
+        uint8_t ch = block[j];
+        if (ch != ' ' && ch != '\n' && ch != '\r' && ch != '\t') return 0;
+    }
+    return 1;
+}
+
+JSON_KERNEL_BODY void scalar_stage1_body(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    uint64_t* structurals,
+    const int skip_whitespace
+) {
+    for (size_t b = 0; b < num_blocks; b++) {
+        const uint8_t* block = input + b * 64;
+        uint64_t structural = 0, quotes = 0, backslashes = 0;
+
+        if (skip_whitespace && scalar_is_whitespace_64(block)) {
+            structurals[b] = json_skip_whitespace_block(state);
+            continue;
         }
-        if (count & 1) {
-            /* Odd-length sequence - the last backslash escapes next char */
-            odd_ends |= (1ULL << (pos + count - 1));
+
+        for (int j = 0; j < 64; j++) {
+            uint8_t ch = block[j];
+            uint64_t bit = 1ULL << j;
+            if (ch == '"') quotes |= bit;
+            else if (ch == '\\') backslashes |= bit;
+            else if (ch == '{' || ch == '}' || ch == '[' || ch == ']' ||
+                     ch == ':' || ch == ',') structural |= bit;
         }
-        seq &= seq - (1ULL << (pos + count - 1));
+
+        uint64_t escaped = json_find_escaped(backslashes, state);
+        quotes &= ~escaped;
+
+        structurals[b] = json_finish_block(state, structural, quotes, escaped,
+                                           json_prefix_xor_scalar(quotes));
     }
-    return odd_ends;
+}
+
+static void scalar_stage1_blocks(const uint8_t* input, size_t num_blocks,
+                                 JsonStage1State* state, uint64_t* structurals) {
+    scalar_stage1_body(input, num_blocks, state, structurals, 0);
+}
+
+static void scalar_stage1_pretty_blocks(const uint8_t* input, size_t num_blocks,
+                                        JsonStage1State* state, uint64_t* structurals) {
+    scalar_stage1_body(input, num_blocks, state, structurals, 1);
+}
+
+static uint32_t scalar_stage1_validate_blocks(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    JsonUtf8State* utf8,
+    uint64_t* structurals
+) {
+    uint8_t prev3 = utf8->prev_block[13];
+    uint8_t prev2 = utf8->prev_block[14];
+    uint8_t prev1 = utf8->prev_block[15];
+    uint8_t incomplete = 0;
+    for (int j = 0; j < 16; j++) incomplete |= utf8->prev_incomplete[j];
+
+    uint8_t utf8_error = 0;
+    uint64_t control = 0;
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        const uint8_t* block = input + b * 64;
+        uint64_t structural = 0, quotes = 0, backslashes = 0, controls = 0;
+        uint8_t high = 0;
+
+        for (int j = 0; j < 64; j++) {
+            uint8_t ch = block[j];
+            uint64_t bit = 1ULL << j;
+            high |= ch;
+            if (ch < 0x20) controls |= bit;
+            else if (ch == '"') quotes |= bit;
+            else if (ch == '\\') backslashes |= bit;
+            else if (ch == '{' || ch == '}' || ch == '[' || ch == ']' ||
+                     ch == ':' || ch == ',') structural |= bit;
+        }
+
+        if (high < 0x80) {
+            utf8_error |= incomplete;
+            prev3 = prev2 = prev1 = 0;
+            incomplete = 0;
+        } else {
+            for (int j = 0; j < 64; j++) {
+                utf8_error |= json_utf8_check_byte(prev3, prev2, prev1, block[j]);
+                prev3 = prev2;
+                prev2 = prev1;
+                prev1 = block[j];
+            }
+            incomplete = (prev1 >= 0xC0 || prev2 >= 0xE0 || prev3 >= 0xF0);
+        }
+
+        uint64_t escaped = json_find_escaped(backslashes, state);
+        quotes &= ~escaped;
+        uint64_t quote_xor = json_prefix_xor_scalar(quotes);
+
+        control |= controls & json_string_mask(state, quote_xor);
+        structurals[b] = json_finish_block(state, structural, quotes, escaped, quote_xor);
+    }
+
+    memset(utf8, 0, sizeof(*utf8));
+    utf8->prev_block[13] = prev3;
+    utf8->prev_block[14] = prev2;
+    utf8->prev_block[15] = prev1;
+    utf8->prev_incomplete[15] = incomplete;
+
+    return (utf8_error ? NEON_JSON_INVALID_UTF8 : 0) |
+           (control ? NEON_JSON_INVALID_CONTROL : 0);
+}
+
+/* =============================================================================
+ * Stage 1 Statistics
+ * ============================================================================= */
+
+static uint64_t stats_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Several threads may record into one context at once (json_ndjson_open's
+ * workers share it), so the flag and every counter are accessed with
+ * relaxed atomics: each field stays exact, the struct is not a snapshot.
+ */
+static inline int stats_on(const NeonContext* ctx) {
+    return __atomic_load_n(&ctx->stats_enabled, __ATOMIC_RELAXED);
+}
+
+static inline void stats_add(uint64_t* counter, uint64_t value) {
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+/* Start of a recorded call: the clock is only read with stats enabled */
+static inline uint64_t stats_begin(const NeonContext* ctx) {
+    return stats_on(ctx) ? stats_clock_ns() : 0;
+}
+
+/* Charge the time since *mark to one phase and restart the mark there */
+static inline void stats_lap(NeonContext* ctx, uint64_t* mark, uint64_t* phase) {
+    if (stats_on(ctx)) {
+        uint64_t now = stats_clock_ns();
+        stats_add(phase, now - *mark);
+        *mark = now;
+    }
+}
+
+/* Close a recorded call; moves the state's escape count into the stats */
+static void stats_end(NeonContext* ctx, uint64_t start, size_t bytes,
+                      uint64_t structurals, JsonStage1State* state) {
+    if (stats_on(ctx)) {
+        stats_add(&ctx->stats.calls, 1);
+        stats_add(&ctx->stats.bytes, bytes);
+        stats_add(&ctx->stats.structurals, structurals);
+        stats_add(&ctx->stats.escape_blocks, state->escape_blocks);
+        stats_add(&ctx->stats.total_ns, stats_clock_ns() - start);
+    }
+    state->escape_blocks = 0;
+}
+
+int json_ctx_enable_stats(NeonContext* ctx, int enabled) {
+    if (!ctx) return NEON_JSON_ERR_INVALID;
+    __atomic_store_n(&ctx->stats_enabled, enabled != 0, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/* JsonCtxStats is JSON_CTX_STATS_FIELDS uint64_t words (see neon_json.h) */
+int json_ctx_get_stats(NeonContext* ctx, JsonCtxStats* stats) {
+    if (!ctx || !stats) return NEON_JSON_ERR_INVALID;
+    const uint64_t* src = (const uint64_t*)&ctx->stats;
+    uint64_t* dst = (uint64_t*)stats;
+    for (size_t i = 0; i < JSON_CTX_STATS_FIELDS; i++) {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+void json_ctx_reset_stats(NeonContext* ctx) {
+    if (!ctx) return;
+    uint64_t* counters = (uint64_t*)&ctx->stats;
+    for (size_t i = 0; i < JSON_CTX_STATS_FIELDS; i++) {
+        __atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+/* =============================================================================
+ * Stage 1 Driver
+ * ============================================================================= */
+
+/* Emit positions for one block bitmap; returns the new count */
+static inline size_t emit_block(
+    const uint8_t* input,
+    size_t base,
+    uint64_t filtered,
+    uint32_t* positions,
+    uint8_t* characters,
+    size_t count,
+    size_t max_output
+) {
+    while (filtered && count < max_output) {
+        int pos = __builtin_ctzll(filtered);
+        positions[count] = (uint32_t)(base + pos);
+        characters[count] = input[base + pos];
+        count++;
+        filtered &= filtered - 1;  /* Clear lowest bit */
+    }
+    return count;
+}
+
+/* Sampled blank-block test for the sniff: every 8th byte and the last */
+static inline int sniff_block_blank(const uint8_t* block) {
+    for (int j = 0; j <= 64; j += 8) {
+        uint8_t ch = block[j < 64 ? j : 63];
+        if (ch != ' ' && ch != '\n' && ch != '\r' && ch != '\t') return 0;
+    }
+    return 1;
+}
+
+int neon_json_sniff_shape(const uint8_t* input, size_t input_len) {
+    if (!input) return NEON_JSON_SHAPE_MINIFIED;
+
+    /* Only a guess - the kernel tests every byte - so a sample per block will do */
+    size_t blocks = (input_len < SHAPE_SNIFF_BYTES ? input_len : SHAPE_SNIFF_BYTES) / 64;
+    size_t whitespace = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        whitespace += (size_t)sniff_block_blank(input + b * 64);
+    }
+
+    return blocks > 0 && whitespace * SHAPE_PRETTY_RATIO >= blocks
+               ? NEON_JSON_SHAPE_PRETTY
+               : NEON_JSON_SHAPE_MINIFIED;
+}
+
+/* Kernel for an input shape; NULL if the shape is not a NEON_JSON_SHAPE_* */
+static JsonStage1Kernel shape_kernel(const NeonContext* ctx, const uint8_t* input,
+                                     size_t input_len, int shape) {
+    if (shape == NEON_JSON_SHAPE_AUTO) {
+        shape = input_len >= SHAPE_SNIFF_MIN_LEN ? neon_json_sniff_shape(input, input_len)
+                                                 : NEON_JSON_SHAPE_MINIFIED;
+    }
+    if (shape == NEON_JSON_SHAPE_MINIFIED) return ctx->kernel;
+    if (shape == NEON_JSON_SHAPE_PRETTY) return ctx->pretty_kernel;
+    return NULL;
 }
 
 int64_t neon_json_find_structural(
@@ -198,82 +798,1016 @@ int64_t neon_json_find_structural(
     uint32_t* positions,
     uint8_t* characters,
     size_t max_output
+) {
+    return neon_json_find_structural_shaped(ctx, input, input_len, positions, characters,
+                                            max_output, NEON_JSON_SHAPE_AUTO);
+}
+
+int64_t neon_json_find_structural_shaped(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint32_t* positions,
+    uint8_t* characters,
+    size_t max_output,
+    int shape
 ) {
     if (!ctx || !input || input_len == 0 || !positions || !characters) {
         return -1;
     }
 
-    ensure_buffers(ctx, input_len);
+    /* Positions would wrap - use neon_json_find_structural64 */
+    if ((uint64_t)input_len > UINT32_MAX) {
+        return NEON_JSON_ERR_TOO_LARGE;
+    }
 
     size_t count = 0;
-    uint64_t prev_string_state = 0;  /* 0 = outside string, 1 = inside */
+    JsonStage1State state = {0, 0, 0};
+    uint64_t structurals[STAGE1_BATCH_BLOCKS];
+    uint64_t start = stats_begin(ctx);
+    uint64_t mark = start;
 
-    /* Process 64 bytes at a time */
-    size_t i = 0;
-    for (; i + 64 <= input_len && count < max_output; i += 64) {
-        uint64_t structural, quotes, backslashes;
-        classify_chunk_64(input + i, &structural, &quotes, &backslashes);
+    JsonStage1Kernel kernel = shape_kernel(ctx, input, input_len, shape);
+    if (!kernel) return NEON_JSON_ERR_INVALID;
 
-        /* Find escaped quotes (quotes preceded by odd backslash sequences) */
-        uint64_t odd_bs = find_odd_backslash_sequences(backslashes);
-        uint64_t escaped_quotes = quotes & (odd_bs << 1);
-        uint64_t unescaped_quotes = quotes & ~escaped_quotes;
+    /* Process whole 64-byte blocks in batches */
+    size_t full_blocks = input_len / 64;
+    size_t block = 0;
+    while (block < full_blocks && count < max_output) {
+        size_t n = full_blocks - block;
+        if (n > STAGE1_BATCH_BLOCKS) n = STAGE1_BATCH_BLOCKS;
 
-        /* Compute string mask via prefix XOR */
-        uint64_t string_mask = prefix_xor(unescaped_quotes);
+        kernel(input + block * 64, n, &state, structurals);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
 
-        /* Apply carry from previous chunk */
-        if (prev_string_state) {
-            string_mask = ~string_mask;
+        for (size_t b = 0; b < n; b++) {
+            count = emit_block(input, (block + b) * 64, structurals[b],
+                               positions, characters, count, max_output);
         }
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+        block += n;
+    }
+
+    /* Remaining bytes: run the kernel on a space-padded copy of the tail */
+    size_t tail = input_len - full_blocks * 64;
+    if (tail > 0 && count < max_output) {
+        uint8_t padded[64];
+        memset(padded, ' ', sizeof(padded));
+        memcpy(padded, input + full_blocks * 64, tail);
 
-        /* Update carry for next chunk (parity of unescaped quotes) */
-        prev_string_state = __builtin_parityll(unescaped_quotes);
+        kernel(padded, 1, &state, structurals);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+        count = emit_block(input, full_blocks * 64, structurals[0],
+                           positions, characters, count, max_output);
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+    }
 
-        /* Filter: structural chars outside strings, plus all quotes */
-        uint64_t filtered = (structural & ~string_mask) | unescaped_quotes;
+    stats_end(ctx, start, input_len, count, &state);
+    return (int64_t)count;
+}
 
-        /* Extract positions */
-        while (filtered && count < max_output) {
-            int pos = __builtin_ctzll(filtered);
-            positions[count] = (uint32_t)(i + pos);
-            characters[count] = input[i + pos];
-            count++;
-            filtered &= filtered - 1;  /* Clear lowest bit */
-        }
+int64_t neon_json_find_structural_arena(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len
+) {
+    if ((uint64_t)input_len > UINT32_MAX) {
+        return NEON_JSON_ERR_TOO_LARGE;
     }
 
-    /* Handle remaining bytes (scalar fallback) */
-    int in_string = prev_string_state;
-    int prev_backslash = 0;
-    for (; i < input_len && count < max_output; i++) {
-        uint8_t ch = input[i];
+    /* Worst case is one structural per byte, so the arena never truncates */
+    if (!ctx || !input || input_len == 0 || ensure_arena(ctx, input_len) != 0) {
+        return -1;
+    }
 
-        if (ch == '\\' && !prev_backslash) {
-            prev_backslash = 1;
-            continue;
+    return neon_json_find_structural(ctx, input, input_len,
+                                     ctx->arena_positions,
+                                     ctx->arena_characters,
+                                     ctx->arena_capacity);
+}
+
+const uint32_t* neon_json_arena_positions(NeonContext* ctx) {
+    return ctx ? ctx->arena_positions : NULL;
+}
+
+const uint8_t* neon_json_arena_characters(NeonContext* ctx) {
+    return ctx ? ctx->arena_characters : NULL;
+}
+
+/* =============================================================================
+ * Validating Stage 1
+ * ============================================================================= */
+
+/* Length of the well-formed UTF-8 sequence at input[i], or 0 if it is invalid */
+static size_t utf8_sequence_length(const uint8_t* input, size_t input_len, size_t i) {
+    uint8_t lead = input[i];
+    if (lead < 0x80) return 1;
+
+    size_t n;
+    uint8_t lo = 0x80, hi = 0xBF;  /* Range of the first continuation */
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        n = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        n = 3;
+        if (lead == 0xE0) lo = 0xA0;       /* Overlong */
+        else if (lead == 0xED) hi = 0x9F;  /* Surrogates */
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        n = 4;
+        if (lead == 0xF0) lo = 0x90;       /* Overlong */
+        else if (lead == 0xF4) hi = 0x8F;  /* Above U+10FFFF */
+    } else {
+        return 0;
+    }
+
+    if (n > input_len - i) return 0;
+    if (input[i + 1] < lo || input[i + 1] > hi) return 0;
+    for (size_t k = 2; k < n; k++) {
+        if ((input[i + k] & 0xC0) != 0x80) return 0;
+    }
+    return n;
+}
+
+/**
+ * Find the first invalid byte of a batch the kernel flagged.
+ *
+ * Control characters are re-derived byte by byte from the carry state the
+ * kernel started the batch with. UTF-8 decoding starts up to 3 bytes early
+ * (skipping continuations whose lead was already checked), since the
+ * kernel flags a bad sequence at the byte where it breaks, which can be
+ * past a batch boundary. Runs only on failure, so it is kept simple.
+ *
+ * @return Offset of the first error, or `end` if none was found
+ */
+static uint64_t locate_invalid(
+    const uint8_t* input,
+    size_t input_len,
+    size_t begin,
+    size_t end,
+    JsonStage1State entry
+) {
+    uint64_t first = end;
+
+    size_t i = begin >= 3 ? begin - 3 : 0;
+    while (i < begin && (input[i] & 0xC0) == 0x80) i++;
+    while (i < end) {
+        size_t n = utf8_sequence_length(input, input_len, i);
+        if (n == 0) {
+            first = i;
+            break;
         }
+        i += n;
+    }
 
-        if (ch == '"' && !prev_backslash) {
-            positions[count] = (uint32_t)i;
-            characters[count] = ch;
-            count++;
+    int in_string = entry.prev_in_string != 0;
+    int escaped = entry.prev_escaped != 0;
+    for (size_t j = begin; j < first; j++) {
+        uint8_t ch = input[j];
+        if (in_string && ch < 0x20) return j;
+        if (escaped) {
+            escaped = 0;
+        } else if (ch == '\\') {
+            escaped = 1;
+        } else if (ch == '"') {
             in_string = !in_string;
-        } else if (!in_string && !prev_backslash) {
-            if (ch == '{' || ch == '}' || ch == '[' || ch == ']' ||
-                ch == ':' || ch == ',') {
-                positions[count] = (uint32_t)i;
-                characters[count] = ch;
-                count++;
+        }
+    }
+    return first;
+}
+
+int64_t neon_json_find_structural_validated(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint32_t* positions,
+    uint8_t* characters,
+    size_t max_output,
+    uint32_t* errors,
+    uint64_t* error_offset
+) {
+    if (!ctx || !input || input_len == 0 || !positions || !characters || !errors) {
+        return -1;
+    }
+
+    if ((uint64_t)input_len > UINT32_MAX) {
+        return NEON_JSON_ERR_TOO_LARGE;
+    }
+
+    size_t count = 0;
+    uint32_t found = 0;
+    uint64_t first_error = input_len;
+    JsonStage1State state = {0, 0, 0};
+    JsonUtf8State utf8;
+    memset(&utf8, 0, sizeof(utf8));
+    uint64_t structurals[STAGE1_BATCH_BLOCKS];
+    uint64_t start = stats_begin(ctx);
+    uint64_t mark = start;
+
+    /* Unlike neon_json_find_structural, keep going once the output is full:
+     * the verdict has to cover every byte */
+    size_t full_blocks = input_len / 64;
+    size_t block = 0;
+    size_t batch_begin = 0;
+    JsonStage1State batch_entry = state;
+    while (block < full_blocks) {
+        size_t n = full_blocks - block;
+        if (n > STAGE1_BATCH_BLOCKS) n = STAGE1_BATCH_BLOCKS;
+
+        batch_begin = block * 64;
+        batch_entry = state;
+        uint32_t batch_errors = ctx->validate_kernel(input + batch_begin, n, &state, &utf8,
+                                                     structurals);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+        if (batch_errors) {
+            if (!found) {
+                first_error = locate_invalid(input, input_len, batch_begin,
+                                             batch_begin + n * 64, batch_entry);
+            }
+            found |= batch_errors;
+        }
+
+        for (size_t b = 0; b < n && count < max_output; b++) {
+            count = emit_block(input, (block + b) * 64, structurals[b],
+                               positions, characters, count, max_output);
+        }
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+        block += n;
+    }
+
+    size_t tail = input_len - full_blocks * 64;
+    if (tail > 0) {
+        uint8_t padded[64];
+        memset(padded, ' ', sizeof(padded));
+        memcpy(padded, input + full_blocks * 64, tail);
+
+        batch_begin = full_blocks * 64;
+        batch_entry = state;
+        uint32_t batch_errors = ctx->validate_kernel(padded, 1, &state, &utf8, structurals);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+        if (batch_errors) {
+            if (!found) {
+                first_error = locate_invalid(input, input_len, batch_begin, input_len,
+                                             batch_entry);
             }
+            found |= batch_errors;
         }
+        count = emit_block(input, full_blocks * 64, structurals[0],
+                           positions, characters, count, max_output);
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+    }
 
-        prev_backslash = 0;
+    /* A sequence cut off by the end of the input (the padded tail already
+     * turns this into a missing continuation) */
+    uint8_t incomplete = 0;
+    for (int j = 0; j < 16; j++) incomplete |= utf8.prev_incomplete[j];
+    if (incomplete) {
+        if (!found) {
+            first_error = locate_invalid(input, input_len, batch_begin, input_len, batch_entry);
+        }
+        found |= NEON_JSON_INVALID_UTF8;
     }
 
+    stats_end(ctx, start, input_len, count, &state);
+    *errors = found;
+    if (error_offset) *error_offset = first_error;
     return (int64_t)count;
 }
 
+/* =============================================================================
+ * Resumable (Streaming) Stage 1
+ * ============================================================================= */
+
+/* Emit absolute 64-bit positions for one block bitmap; returns the new count */
+static inline size_t emit_block_u64(
+    const uint8_t* src,
+    size_t base,
+    uint64_t abs_base,
+    uint64_t filtered,
+    uint64_t* positions,
+    uint8_t* characters,
+    size_t count
+) {
+    while (filtered) {
+        int pos = __builtin_ctzll(filtered);
+        positions[count] = abs_base + base + pos;
+        characters[count] = src[base + pos];
+        count++;
+        filtered &= filtered - 1;
+    }
+    return count;
+}
+
+/* Capped variant: writes at most max_output entries, returns the running total */
+static inline size_t emit_block_u64_capped(
+    const uint8_t* src,
+    size_t base,
+    uint64_t filtered,
+    uint64_t* positions,
+    uint8_t* characters,
+    size_t total,
+    size_t max_output
+) {
+    size_t n = (size_t)__builtin_popcountll(filtered);
+    if (total + n <= max_output) {
+        return emit_block_u64(src, base, 0, filtered, positions, characters, total);
+    }
+
+    size_t count = total;
+    while (filtered && count < max_output) {
+        int pos = __builtin_ctzll(filtered);
+        positions[count] = base + pos;
+        characters[count] = src[base + pos];
+        count++;
+        filtered &= filtered - 1;
+    }
+    return total + n;
+}
+
+int64_t neon_json_find_structural64(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint64_t* positions,
+    uint8_t* characters,
+    size_t max_output,
+    uint64_t* needed
+) {
+    if (!ctx || !input || input_len == 0 || !positions || !characters) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    size_t total = 0;
+    JsonStage1State state = {0, 0, 0};
+    uint64_t structurals[STAGE1_BATCH_BLOCKS];
+    uint64_t start = stats_begin(ctx);
+    uint64_t mark = start;
+
+    /*
+     * Keep classifying after the buffer fills: counting the rest is just a
+     * popcount per block, and gives the caller the exact size to retry with.
+     */
+    size_t full_blocks = input_len / 64;
+    size_t block = 0;
+    while (block < full_blocks) {
+        size_t n = full_blocks - block;
+        if (n > STAGE1_BATCH_BLOCKS) n = STAGE1_BATCH_BLOCKS;
+
+        ctx->kernel(input + block * 64, n, &state, structurals);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+
+        for (size_t b = 0; b < n; b++) {
+            total = emit_block_u64_capped(input, (block + b) * 64, structurals[b],
+                                          positions, characters, total, max_output);
+        }
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+        block += n;
+    }
+
+    size_t tail = input_len - full_blocks * 64;
+    if (tail > 0) {
+        uint8_t padded[64];
+        memset(padded, ' ', sizeof(padded));
+        memcpy(padded, input + full_blocks * 64, tail);
+
+        ctx->kernel(padded, 1, &state, structurals);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+        total = emit_block_u64_capped(input, full_blocks * 64, structurals[0],
+                                      positions, characters, total, max_output);
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+    }
+
+    stats_end(ctx, start, input_len, total, &state);
+    if (needed) *needed = total;
+    if (total > max_output) {
+        return NEON_JSON_ERR_OUTPUT_FULL;
+    }
+    return (int64_t)total;
+}
+
+/* =============================================================================
+ * Compact Index Output
+ * ============================================================================= */
+
+int64_t neon_json_find_structural_bitmap(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint64_t* bitmaps,
+    size_t max_words
+) {
+    if (!ctx || !input || input_len == 0 || !bitmaps) {
+        return NEON_JSON_ERR_INVALID;
+    }
+    if (max_words < NEON_JSON_BITMAP_WORDS(input_len)) {
+        return NEON_JSON_ERR_OUTPUT_FULL;
+    }
+
+    JsonStage1State state = {0, 0, 0};
+    uint64_t count = 0;
+    uint64_t start = stats_begin(ctx);
+    uint64_t mark = start;
+
+    /* The kernel output already is the index: classify straight into it */
+    size_t full_blocks = input_len / 64;
+    for (size_t block = 0; block < full_blocks; block += STAGE1_BATCH_BLOCKS) {
+        size_t n = full_blocks - block;
+        if (n > STAGE1_BATCH_BLOCKS) n = STAGE1_BATCH_BLOCKS;
+
+        ctx->kernel(input + block * 64, n, &state, bitmaps + block);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+
+        for (size_t b = 0; b < n; b++) {
+            count += (uint64_t)__builtin_popcountll(bitmaps[block + b]);
+        }
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+    }
+
+    size_t tail = input_len - full_blocks * 64;
+    if (tail > 0) {
+        uint8_t padded[64];
+        memset(padded, ' ', sizeof(padded));
+        memcpy(padded, input + full_blocks * 64, tail);
+
+        ctx->kernel(padded, 1, &state, bitmaps + full_blocks);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+        count += (uint64_t)__builtin_popcountll(bitmaps[full_blocks]);
+    }
+
+    stats_end(ctx, start, input_len, count, &state);
+    return (int64_t)count;
+}
+
+/* Delta-encode one block bitmap; returns bytes written or SIZE_MAX if full */
+static inline size_t emit_block_delta8(
+    uint64_t base,
+    uint64_t filtered,
+    uint64_t* prev,
+    uint8_t* out,
+    size_t avail
+) {
+    size_t written = 0;
+    while (filtered) {
+        uint64_t pos = base + (uint64_t)__builtin_ctzll(filtered);
+        uint32_t delta = (uint32_t)(pos - *prev);
+
+        if (delta < 256) {
+            if (written + 1 > avail) return SIZE_MAX;
+            out[written++] = (uint8_t)delta;
+        } else {
+            /* Escape: 0 then the 4-byte gap (LE) */
+            if (written + 5 > avail) return SIZE_MAX;
+            out[written] = 0;
+            out[written + 1] = (uint8_t)delta;
+            out[written + 2] = (uint8_t)(delta >> 8);
+            out[written + 3] = (uint8_t)(delta >> 16);
+            out[written + 4] = (uint8_t)(delta >> 24);
+            written += 5;
+        }
+        *prev = pos;
+        filtered &= filtered - 1;
+    }
+    return written;
+}
+
+int64_t neon_json_find_structural_delta8(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* deltas,
+    size_t max_bytes,
+    size_t* out_bytes
+) {
+    if (!ctx || !input || input_len == 0 || !deltas) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    /* Gaps are stored in 32 bits */
+    if ((uint64_t)input_len > UINT32_MAX) {
+        return NEON_JSON_ERR_TOO_LARGE;
+    }
+
+    JsonStage1State state = {0, 0, 0};
+    uint64_t structurals[STAGE1_BATCH_BLOCKS];
+    uint64_t prev = (uint64_t)-1;  /* First delta is position + 1 */
+    uint64_t count = 0;
+    size_t used = 0;
+    uint64_t start = stats_begin(ctx);
+    uint64_t mark = start;
+
+    size_t full_blocks = input_len / 64;
+    size_t tail = input_len - full_blocks * 64;
+    size_t total_blocks = full_blocks + (tail > 0);
+
+    for (size_t block = 0; block < total_blocks; block += STAGE1_BATCH_BLOCKS) {
+        size_t n = total_blocks - block;
+        if (n > STAGE1_BATCH_BLOCKS) n = STAGE1_BATCH_BLOCKS;
+
+        if (block + n <= full_blocks) {
+            ctx->kernel(input + block * 64, n, &state, structurals);
+        } else {
+            /* Last batch ends with the space-padded tail block */
+            if (n > 1) ctx->kernel(input + block * 64, n - 1, &state, structurals);
+
+            uint8_t padded[64];
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, input + full_blocks * 64, tail);
+            ctx->kernel(padded, 1, &state, structurals + n - 1);
+        }
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+
+        for (size_t b = 0; b < n; b++) {
+            size_t w = emit_block_delta8((uint64_t)(block + b) * 64, structurals[b],
+                                         &prev, deltas + used, max_bytes - used);
+            if (w == SIZE_MAX) {
+                stats_end(ctx, start, input_len, count, &state);
+                if (out_bytes) *out_bytes = used;
+                return NEON_JSON_ERR_OUTPUT_FULL;
+            }
+            used += w;
+            count += (uint64_t)__builtin_popcountll(structurals[b]);
+        }
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+    }
+
+    stats_end(ctx, start, input_len, count, &state);
+    if (out_bytes) *out_bytes = used;
+    return (int64_t)count;
+}
+
+/* =============================================================================
+ * Skip Index
+ * ============================================================================= */
+
+/* Depth change per structural character: +1 open, -1 close, 0 otherwise */
+static const int8_t DEPTH_STEP[256] = {
+    ['{'] = 1, ['['] = 1, ['}'] = -1, [']'] = -1
+};
+
+static int compare_skip_pairs(const void* a, const void* b) {
+    uint32_t x = ((const uint32_t*)a)[0];
+    uint32_t y = ((const uint32_t*)b)[0];
+    return (x > y) - (x < y);
+}
+
+int64_t neon_json_build_skip_index(
+    NeonContext* ctx,
+    const uint8_t* characters,
+    size_t count,
+    uint32_t min_span,
+    int32_t* chunk_delta,
+    int32_t* chunk_min,
+    uint32_t* skip_pairs,
+    size_t max_pairs,
+    uint64_t* needed
+) {
+    if (!ctx || !characters || !chunk_delta || !chunk_min || (!skip_pairs && max_pairs)) {
+        return NEON_JSON_ERR_INVALID;
+    }
+    if ((uint64_t)count > UINT32_MAX) {
+        return NEON_JSON_ERR_TOO_LARGE;
+    }
+
+    size_t depth = 0;   /* Open containers on the stack */
+    size_t pairs = 0;
+    int overflow = 0;
+
+    for (size_t chunk = 0; chunk * 64 < count; chunk++) {
+        size_t begin = chunk * 64;
+        size_t end = begin + 64 < count ? begin + 64 : count;
+        int32_t d = 0;
+        int32_t lowest = 0;
+
+        for (size_t i = begin; i < end; i++) {
+            int step = DEPTH_STEP[characters[i]];
+            if (step == 0) continue;
+
+            d += step;
+            if (d < lowest) lowest = d;
+
+            if (step > 0) {
+                if (depth == ctx->skip_stack_capacity) {
+                    size_t capacity = depth ? depth * 2 : 256;
+                    uint32_t* stack = realloc(ctx->skip_stack, capacity * sizeof(uint32_t));
+                    if (!stack) return NEON_JSON_ERR_INVALID;
+                    ctx->skip_stack = stack;
+                    ctx->skip_stack_capacity = capacity;
+                }
+                ctx->skip_stack[depth++] = (uint32_t)i;
+            } else if (depth > 0) {
+                /* Unmatched closes (malformed input) are ignored */
+                uint32_t open = ctx->skip_stack[--depth];
+                if (i - open >= min_span) {
+                    if (pairs < max_pairs) {
+                        skip_pairs[2 * pairs] = open;
+                        skip_pairs[2 * pairs + 1] = (uint32_t)i;
+                    } else {
+                        overflow = 1;
+                    }
+                    pairs++;
+                }
+            }
+        }
+
+        chunk_delta[chunk] = d;
+        chunk_min[chunk] = lowest;
+    }
+
+    if (needed) *needed = pairs;
+    if (overflow) return NEON_JSON_ERR_OUTPUT_FULL;
+
+    /* Pairs come out in close order; lookups want them sorted by open */
+    qsort(skip_pairs, pairs, 2 * sizeof(uint32_t), compare_skip_pairs);
+    return (int64_t)pairs;
+}
+
+int neon_json_stage1_begin(NeonContext* ctx) {
+    if (!ctx) return -1;
+
+    ctx->stream_state.prev_in_string = 0;
+    ctx->stream_state.prev_escaped = 0;
+    ctx->stream_state.escape_blocks = 0;
+    ctx->stream_offset = 0;
+    ctx->stream_pending_len = 0;
+    ctx->stream_active = 1;
+    return 0;
+}
+
+int64_t neon_json_stage1_feed(
+    NeonContext* ctx,
+    const uint8_t* chunk,
+    size_t len,
+    uint64_t* positions,
+    uint8_t* characters,
+    size_t max_output
+) {
+    if (!ctx || !ctx->stream_active || (!chunk && len > 0) ||
+        !positions || !characters) {
+        return -1;
+    }
+
+    /* Worst case: every byte of the chunk plus the pending block is structural.
+     * Checked before any state changes, so the caller can grow and retry. */
+    if (max_output < len + 64) {
+        return NEON_JSON_ERR_OUTPUT_FULL;
+    }
+
+    size_t count = 0;
+    uint64_t structurals[STAGE1_BATCH_BLOCKS];
+    uint64_t start = stats_begin(ctx);
+    uint64_t mark = start;
+    size_t bytes = len;
+
+    /* Complete the partial block left over from the previous feed */
+    if (ctx->stream_pending_len > 0) {
+        size_t take = 64 - ctx->stream_pending_len;
+        if (take > len) take = len;
+        memcpy(ctx->stream_pending + ctx->stream_pending_len, chunk, take);
+        ctx->stream_pending_len += take;
+        chunk += take;
+        len -= take;
+
+        if (ctx->stream_pending_len < 64) {
+            stats_end(ctx, start, bytes, 0, &ctx->stream_state);
+            return 0;
+        }
+
+        ctx->kernel(ctx->stream_pending, 1, &ctx->stream_state, structurals);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+        count = emit_block_u64(ctx->stream_pending, 0, ctx->stream_offset,
+                               structurals[0], positions, characters, count);
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+        ctx->stream_offset += 64;
+        ctx->stream_pending_len = 0;
+    }
+
+    /* Whole blocks straight from the caller's chunk */
+    size_t full_blocks = len / 64;
+    size_t block = 0;
+    while (block < full_blocks) {
+        size_t n = full_blocks - block;
+        if (n > STAGE1_BATCH_BLOCKS) n = STAGE1_BATCH_BLOCKS;
+
+        ctx->kernel(chunk + block * 64, n, &ctx->stream_state, structurals);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+
+        for (size_t b = 0; b < n; b++) {
+            count = emit_block_u64(chunk, (block + b) * 64, ctx->stream_offset,
+                                   structurals[b], positions, characters, count);
+        }
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+        block += n;
+    }
+    ctx->stream_offset += full_blocks * 64;
+
+    /* Keep the tail for the next feed (or finish) */
+    size_t tail = len - full_blocks * 64;
+    memcpy(ctx->stream_pending, chunk + full_blocks * 64, tail);
+    ctx->stream_pending_len = tail;
+
+    stats_end(ctx, start, bytes, count, &ctx->stream_state);
+    return (int64_t)count;
+}
+
+int64_t neon_json_stage1_finish(
+    NeonContext* ctx,
+    uint64_t* positions,
+    uint8_t* characters,
+    size_t max_output
+) {
+    if (!ctx || !ctx->stream_active || !positions || !characters) {
+        return -1;
+    }
+    if (max_output < 64) {
+        return NEON_JSON_ERR_OUTPUT_FULL;
+    }
+
+    size_t count = 0;
+    uint64_t start = stats_begin(ctx);
+    uint64_t mark = start;
+    if (ctx->stream_pending_len > 0) {
+        uint64_t structural;
+        memset(ctx->stream_pending + ctx->stream_pending_len, ' ',
+               64 - ctx->stream_pending_len);
+        ctx->kernel(ctx->stream_pending, 1, &ctx->stream_state, &structural);
+        stats_lap(ctx, &mark, &ctx->stats.classify_ns);
+        count = emit_block_u64(ctx->stream_pending, 0, ctx->stream_offset,
+                               structural, positions, characters, 0);
+        stats_lap(ctx, &mark, &ctx->stats.extract_ns);
+        ctx->stream_offset += ctx->stream_pending_len;
+        ctx->stream_pending_len = 0;
+    }
+
+    /* The pending bytes were counted by the feed that buffered them */
+    stats_end(ctx, start, 0, count, &ctx->stream_state);
+    ctx->stream_active = 0;
+    return (int64_t)count;
+}
+
+int neon_json_stage1_in_string(NeonContext* ctx) {
+    if (!ctx) return -1;
+    return ctx->stream_state.prev_in_string != 0;
+}
+
+uint64_t neon_json_stage1_offset(NeonContext* ctx) {
+    if (!ctx) return 0;
+    return ctx->stream_offset + ctx->stream_pending_len;
+}
+
+/* =============================================================================
+ * Parallel Stage 1
+ * ============================================================================= */
+
+typedef struct {
+    JsonStage1Kernel kernel;
+    ParallelSegment* segments;
+    const uint8_t* input;
+    size_t* order;              /* Task index -> segment index */
+    uint32_t* positions;        /* Final output (copy phase) */
+    uint8_t* characters;
+    size_t max_output;
+} ParallelJob;
+
+/* Like emit_block, but keeps counting past capacity */
+static inline size_t emit_block_counted(
+    const uint8_t* input,
+    size_t base,
+    uint64_t filtered,
+    uint32_t* positions,
+    uint8_t* characters,
+    size_t count,
+    size_t capacity
+) {
+    size_t n = (size_t)__builtin_popcountll(filtered);
+    if (count < capacity) {
+        emit_block(input, base, filtered, positions, characters, count, capacity);
+    }
+    return count + n;
+}
+
+/* Classify one segment from its entry state and collect its positions */
+static void parallel_index_task(void* arg, size_t index) {
+    ParallelJob* job = arg;
+    ParallelSegment* seg = &job->segments[job->order[index]];
+    JsonStage1Kernel kernel = job->kernel;
+    JsonStage1State state = seg->entry;
+    uint64_t structurals[STAGE1_BATCH_BLOCKS];
+    size_t count = 0;
+
+    size_t full_end = seg->start + (seg->end - seg->start) / 64 * 64;
+    size_t pos = seg->start;
+    while (pos < full_end) {
+        size_t n = (full_end - pos) / 64;
+        if (n > STAGE1_BATCH_BLOCKS) n = STAGE1_BATCH_BLOCKS;
+
+        kernel(job->input + pos, n, &state, structurals);
+
+        for (size_t b = 0; b < n; b++) {
+            count = emit_block_counted(job->input, pos + b * 64, structurals[b],
+                                       seg->positions, seg->characters, count,
+                                       seg->capacity);
+        }
+        pos += n * 64;
+    }
+
+    /* Only the last segment can end in a partial block */
+    if (full_end < seg->end) {
+        uint8_t padded[64];
+        memset(padded, ' ', sizeof(padded));
+        memcpy(padded, job->input + full_end, seg->end - full_end);
+
+        kernel(padded, 1, &state, structurals);
+        count = emit_block_counted(job->input, full_end, structurals[0],
+                                   seg->positions, seg->characters, count,
+                                   seg->capacity);
+    }
+
+    seg->count = count;
+    seg->exit_in_string = state.prev_in_string;
+    seg->escape_blocks = state.escape_blocks;
+}
+
+/* Concatenate one segment into the caller's output at its prefix-sum offset */
+static void parallel_copy_task(void* arg, size_t index) {
+    ParallelJob* job = arg;
+    ParallelSegment* seg = &job->segments[index];
+    if (seg->out_offset >= job->max_output) return;
+
+    size_t n = seg->count;
+    if (n > job->max_output - seg->out_offset) n = job->max_output - seg->out_offset;
+    memcpy(job->positions + seg->out_offset, seg->positions, n * sizeof(uint32_t));
+    memcpy(job->characters + seg->out_offset, seg->characters, n);
+}
+
+/* Grow segment slots and per-segment buffers; returns 0 on success */
+static int ensure_segments(NeonContext* ctx, size_t num_segments, size_t capacity) {
+    if (ctx->num_segments < num_segments) {
+        ParallelSegment* grown = realloc(ctx->segments, num_segments * sizeof(ParallelSegment));
+        if (!grown) return -1;
+        memset(grown + ctx->num_segments, 0,
+               (num_segments - ctx->num_segments) * sizeof(ParallelSegment));
+        ctx->segments = grown;
+        ctx->num_segments = num_segments;
+    }
+
+    for (size_t i = 0; i < num_segments; i++) {
+        ParallelSegment* seg = &ctx->segments[i];
+        if (seg->capacity >= capacity) continue;
+
+        free(seg->positions);
+        free(seg->characters);
+        seg->positions = malloc(capacity * sizeof(uint32_t));
+        seg->characters = malloc(capacity);
+        seg->capacity = capacity;
+        if (!seg->positions || !seg->characters) {
+            free(seg->positions);
+            free(seg->characters);
+            seg->positions = NULL;
+            seg->characters = NULL;
+            seg->capacity = 0;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * An odd-length backslash run ending right before `pos` escapes input[pos].
+ * A run always starts unescaped (only backslashes escape backslashes), so
+ * counting backwards to the first non-backslash is exact.
+ */
+static uint64_t escaped_at(const uint8_t* input, size_t pos) {
+    size_t run = 0;
+    while (run < pos && input[pos - 1 - run] == '\\') run++;
+    return run & 1;
+}
+
+int64_t neon_json_find_structural_parallel(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint32_t* positions,
+    uint8_t* characters,
+    size_t max_output,
+    int nthreads
+) {
+    if (!ctx || !input || input_len == 0 || !positions || !characters) {
+        return NEON_JSON_ERR_INVALID;
+    }
+    if ((uint64_t)input_len > UINT32_MAX) {
+        return NEON_JSON_ERR_TOO_LARGE;
+    }
+
+    if (nthreads <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = online > 0 ? (int)online : 1;
+    }
+    if (nthreads > PARALLEL_MAX_THREADS) nthreads = PARALLEL_MAX_THREADS;
+
+    /* Small inputs get fewer segments rather than sub-wakeup-sized ones */
+    size_t num_segments = input_len / PARALLEL_MIN_SEGMENT;
+    if (num_segments > (size_t)nthreads) num_segments = (size_t)nthreads;
+    if (num_segments == 0) num_segments = 1;
+
+    /* 64-byte aligned segments; the last one takes the remainder */
+    size_t seg_len = (input_len + num_segments - 1) / num_segments;
+    seg_len = (seg_len + 63) / 64 * 64;
+    num_segments = (input_len + seg_len - 1) / seg_len;
+
+    size_t order[PARALLEL_MAX_THREADS] = {0};
+    uint64_t start = stats_begin(ctx);
+    JsonStage1State totals = {0, 0, 0};
+
+    /* Single segment: index straight into the caller's buffers */
+    if (num_segments == 1) {
+        ParallelSegment whole = {0};
+        whole.end = input_len;
+        whole.positions = positions;
+        whole.characters = characters;
+        whole.capacity = max_output;
+
+        ParallelJob job = {ctx->kernel, &whole, input, order, positions, characters, max_output};
+        parallel_index_task(&job, 0);
+        totals.escape_blocks = whole.escape_blocks;
+        stats_end(ctx, start, input_len, whole.count, &totals);
+        return whole.count > max_output ? NEON_JSON_ERR_OUTPUT_FULL : (int64_t)whole.count;
+    }
+
+    size_t capacity = seg_len < max_output ? seg_len : max_output;
+    if (ensure_segments(ctx, num_segments, capacity ? capacity : 1) != 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    if (json_pool_size(ctx->pool) + 1 < num_segments) {
+        json_pool_destroy(ctx->pool);
+        ctx->pool = json_pool_create(num_segments - 1);
+    }
+
+    for (size_t i = 0; i < num_segments; i++) {
+        ParallelSegment* seg = &ctx->segments[i];
+        seg->start = i * seg_len;
+        seg->end = seg->start + seg_len < input_len ? seg->start + seg_len : input_len;
+        seg->entry.prev_in_string = 0;
+        seg->entry.prev_escaped = escaped_at(input, seg->start);
+        seg->entry.escape_blocks = 0;
+        order[i] = i;
+    }
+
+    ParallelJob job = {ctx->kernel, ctx->segments, input, order, positions, characters, max_output};
+
+    /* Pass 1: every segment, speculatively assuming it starts outside a string */
+    json_pool_run(ctx->pool, parallel_index_task, &job, num_segments);
+
+    /* Prefix-XOR over per-segment quote parity; collect mispredicted segments */
+    size_t num_redo = 0;
+    uint64_t in_string = 0;
+    for (size_t i = 0; i < num_segments; i++) {
+        ParallelSegment* seg = &ctx->segments[i];
+        uint64_t parity = seg->exit_in_string;  /* Started from 0 */
+        if (in_string) {
+            seg->entry.prev_in_string = in_string;
+            order[num_redo++] = i;
+        }
+        in_string ^= parity;
+    }
+
+    /* Pass 2: redo segments that actually start inside a string */
+    if (num_redo > 0) {
+        json_pool_run(ctx->pool, parallel_index_task, &job, num_redo);
+    }
+
+    /* One prefix sum over the counts, then a parallel concatenation */
+    size_t total = 0;
+    for (size_t i = 0; i < num_segments; i++) {
+        ctx->segments[i].out_offset = total;
+        total += ctx->segments[i].count;
+        totals.escape_blocks += ctx->segments[i].escape_blocks;
+    }
+    json_pool_run(ctx->pool, parallel_copy_task, &job, num_segments);
+
+    stats_end(ctx, start, input_len, total, &totals);
+
+    if (total > max_output) {
+        return NEON_JSON_ERR_OUTPUT_FULL;
+    }
+    return (int64_t)total;
+}
+
+/* Lookup table for scalar classification */
+static const uint8_t CLASSIFY_LOOKUP[256] = {
+    /* 0x00-0x0F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 0, 0, 9, 9, 0, 9, 9,
+    /* 0x10-0x1F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+    /* 0x20-0x2F */ 0, 9, 5, 9, 9, 9, 9, 9, 9, 9, 9, 9, 7, 9, 9, 9,
+    /* 0x30-0x3F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 6, 9, 9, 9, 9, 9,
+    /* 0x40-0x4F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+    /* 0x50-0x5F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 3, 8, 4, 9, 9,
+    /* 0x60-0x6F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+    /* 0x70-0x7F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 1, 9, 2, 9, 9,
+    /* 0x80-0xFF all OTHER */
+    9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+    9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+    9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+    9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9
+};
+
 int neon_json_classify(
     const uint8_t* input,
     uint8_t* output,
@@ -281,44 +1815,32 @@ int neon_json_classify(
 ) {
     if (!input || !output || len == 0) return -1;
 
-    /* Lookup table for classification */
-    static const uint8_t LOOKUP[256] = {
-        /* 0x00-0x0F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 0, 0, 9, 9, 0, 9, 9,
-        /* 0x10-0x1F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
-        /* 0x20-0x2F */ 0, 9, 5, 9, 9, 9, 9, 9, 9, 9, 9, 9, 7, 9, 9, 9,
-        /* 0x30-0x3F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 6, 9, 9, 9, 9, 9,
-        /* 0x40-0x4F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
-        /* 0x50-0x5F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 3, 8, 4, 9, 9,
-        /* 0x60-0x6F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
-        /* 0x70-0x7F */ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 1, 9, 2, 9, 9,
-        /* 0x80-0xFF all OTHER */
-        9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
-        9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
-        9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
-        9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9, 9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9
-    };
-
-    /* Use NEON for bulk processing */
     size_t i = 0;
 
-    /* Load lookup table into NEON register for vectorized lookup */
-    /* Note: vqtbl1q_u8 uses low nibble, so we need split lookup */
+#ifdef NEON_JSON_HAVE_NEON
+    /* Use NEON nibble classification for bulk processing */
+    uint8x16_t lo_table = vld1q_u8(CLS_LO_TABLE);
+    uint8x16_t hi_table = vld1q_u8(CLS_HI_TABLE);
+    for (; i + 16 <= len; i += 16) {
+        vst1q_u8(output + i, neon_classify_codes_16(vld1q_u8(input + i), lo_table, hi_table));
+    }
+#endif
 
-    /* For now, use scalar loop with LOOKUP table (still fast) */
+    /* Remaining bytes (or whole input without NEON) */
     for (; i < len; i++) {
-        output[i] = LOOKUP[input[i]];
+        output[i] = CLASSIFY_LOOKUP[input[i]];
     }
 
     return 0;
 }
 
 int neon_json_is_available(void) {
-    return 1;  /* Always available on ARM64 macOS */
+    /* NEON on ARM64, AVX2 / AVX-512 on x86-64 */
+    const char* name;
+    return select_kernel(&name) != scalar_stage1_blocks;
 }
 
-double neon_json_throughput_estimate(void) {
-    /* Estimate based on typical M1/M2 performance */
-    /* ~25 cycles per 64 bytes at 3 GHz = ~7.5 GB/s theoretical */
-    /* Practical: 3-4 GB/s with memory and overhead */
-    return 3500.0;  /* 3.5 GB/s estimate */
+const char* neon_json_kernel_name(NeonContext* ctx) {
+    if (!ctx) return "unknown";
+    return ctx->kernel_name;
 }
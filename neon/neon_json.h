@@ -6,8 +6,13 @@
  *
  * Performance: 3-4 GB/s on Apple Silicon (M1-M4)
  *
+ * On x86-64 the same ABI is backed by AVX2 / AVX-512 kernels
+ * (neon_json_x86.c), selected at runtime via CPUID.
+ *
  * Build:
- *   clang -O3 -march=armv8-a+simd -shared -fPIC neon_json.c -o libneon_json.dylib
+ *   ./build.sh
+ *   (ARM64: clang -O3 -march=armv8-a+simd+crypto -shared -fPIC neon_json.c -o libneon_json.dylib)
+ *   (x86-64: cc -O3 -shared -fPIC neon_json.c neon_json_x86.c -o libneon_json.so)
  */
 
 #ifndef NEON_JSON_H
@@ -32,7 +37,21 @@ extern "C" {
 #define NEON_CHAR_BACKSLASH    8
 #define NEON_CHAR_OTHER        9
 
-/* Opaque context for buffer reuse */
+/* Error statuses (negative return values) */
+#define NEON_JSON_ERR_INVALID      (-1)  /* NULL context / buffers, no active stream */
+#define NEON_JSON_ERR_OUTPUT_FULL  (-2)  /* Output buffer too small - grow and retry */
+#define NEON_JSON_ERR_TOO_LARGE    (-3)  /* Input >= 4 GB for 32-bit positions */
+
+/* Validation error bits (neon_json_find_structural_validated) */
+#define NEON_JSON_INVALID_UTF8     (1u << 0)  /* Malformed or truncated UTF-8 */
+#define NEON_JSON_INVALID_CONTROL  (1u << 1)  /* Raw byte < 0x20 inside a string */
+
+/* Input shapes (neon_json_find_structural_shaped) */
+#define NEON_JSON_SHAPE_AUTO       0  /* Sniff the first 4 KB (inputs >= 16 KB) */
+#define NEON_JSON_SHAPE_MINIFIED   1  /* Default kernel */
+#define NEON_JSON_SHAPE_PRETTY     2  /* Skip all-whitespace 64-byte blocks */
+
+/* Opaque context: kernel choice, output arena, stream state, worker pool */
 typedef struct NeonContext NeonContext;
 
 /**
@@ -54,13 +73,16 @@ void neon_json_free(NeonContext* ctx);
  * 2. Branchless escape/quote handling
  * 3. Prefix-XOR for string tracking via carry-less multiply
  *
+ * Runs neon_json_find_structural_shaped with NEON_JSON_SHAPE_AUTO.
+ *
  * @param ctx         Context from neon_json_init
  * @param input       Input JSON bytes
  * @param input_len   Input length
  * @param positions   Output: structural char positions (caller allocates)
  * @param characters  Output: structural characters (caller allocates)
- * @param max_output  Maximum output capacity
- * @return Number of structural chars found, -1 on error
+ * @param max_output  Maximum output capacity; input_len is always enough
+ * @return Number of structural chars found (stops silently at max_output),
+ *         -1 on error, NEON_JSON_ERR_TOO_LARGE if input_len > UINT32_MAX
  */
 int64_t neon_json_find_structural(
     NeonContext* ctx,
@@ -71,6 +93,313 @@ int64_t neon_json_find_structural(
     size_t max_output
 );
 
+/**
+ * neon_json_find_structural with an explicit kernel variant.
+ *
+ * The PRETTY kernel tests each 64-byte block for being all whitespace with
+ * one vector compare and skips its classification when it is; that pays
+ * off on deeply indented or padded documents, and costs a few percent on
+ * everything else, so MINIFIED runs the plain kernel. AUTO picks via
+ * neon_json_sniff_shape for inputs of 16 KB and up, MINIFIED below.
+ * Output is identical for all three.
+ *
+ * @param shape  NEON_JSON_SHAPE_AUTO, _MINIFIED or _PRETTY
+ * @return As neon_json_find_structural; NEON_JSON_ERR_INVALID for an
+ *         unknown shape
+ */
+int64_t neon_json_find_structural_shaped(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint32_t* positions,
+    uint8_t* characters,
+    size_t max_output,
+    int shape
+);
+
+/**
+ * Guess the input shape from its first 4 KB: PRETTY if at least 1 in 8 of
+ * those 64-byte blocks looks all whitespace (every 8th byte sampled),
+ * MINIFIED otherwise. Ordinary
+ * 2-space pretty-printing rarely leaves a whole block blank, so it usually
+ * sniffs as MINIFIED - the whitespace kernel would only add its test.
+ *
+ * @return NEON_JSON_SHAPE_MINIFIED or NEON_JSON_SHAPE_PRETTY
+ */
+int neon_json_sniff_shape(const uint8_t* input, size_t input_len);
+
+/**
+ * Find structural characters into the context's own output arena.
+ *
+ * The arena is 64-byte aligned, sized for the worst case (one structural
+ * per byte) and only grows, so a stream of documents of similar size does
+ * no allocation and touches already-faulted pages after the first call.
+ * Read the results through neon_json_arena_positions / _characters.
+ *
+ * @return Number of structural chars found, -1 (or NEON_JSON_ERR_TOO_LARGE)
+ *         on error
+ */
+int64_t neon_json_find_structural_arena(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len
+);
+
+/**
+ * Borrowed pointers into the arena filled by neon_json_find_structural_arena.
+ * Owned by the context: valid until the next arena call or neon_json_free.
+ * NULL before the first arena call.
+ */
+const uint32_t* neon_json_arena_positions(NeonContext* ctx);
+const uint8_t* neon_json_arena_characters(NeonContext* ctx);
+
+/**
+ * neon_json_find_structural that also validates the input in the same pass.
+ *
+ * Each 64-byte block is checked for malformed UTF-8 (simdjson's lookup
+ * validator: overlong forms, surrogates, code points above U+10FFFF,
+ * missing or stray continuations, a sequence cut off at the end) and for
+ * unescaped control characters inside strings, while it is classified.
+ * Structurals are still produced for the whole input, so a caller that
+ * only wants a verdict can ignore them.
+ *
+ * @param errors        Output: OR of NEON_JSON_INVALID_* found, 0 if valid
+ * @param error_offset  Output (optional): offset of the first invalid byte
+ *                      (the lead byte of a bad UTF-8 sequence), or
+ *                      input_len if valid
+ * @return Number of structural chars found (stops silently at max_output),
+ *         or a NEON_JSON_ERR_* status
+ */
+int64_t neon_json_find_structural_validated(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint32_t* positions,
+    uint8_t* characters,
+    size_t max_output,
+    uint32_t* errors,
+    uint64_t* error_offset
+);
+
+/**
+ * 64-bit variant of neon_json_find_structural for inputs of 4 GB and more.
+ *
+ * Never truncates silently: if more than max_output structurals exist, the
+ * first max_output are written, *needed receives the exact total and
+ * NEON_JSON_ERR_OUTPUT_FULL is returned, so the caller can grow the buffers
+ * to *needed and call again.
+ *
+ * @param needed  Output (optional): total number of structural chars
+ * @return Number of structural chars found, or a NEON_JSON_ERR_* status
+ */
+int64_t neon_json_find_structural64(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint64_t* positions,
+    uint8_t* characters,
+    size_t max_output,
+    uint64_t* needed
+);
+
+/**
+ * Compact index: the raw Stage 1 bitmaps.
+ *
+ * Writes one uint64_t per 64-byte block, bit i set if input[64 * block + i]
+ * is a structural character - 1 bit per input byte instead of 5 bytes per
+ * structural. Stage 2 walks the words with ctz and reads the character
+ * from the input itself. Inputs of any size are supported.
+ *
+ * @param bitmaps    Output, NEON_JSON_BITMAP_WORDS(input_len) entries
+ * @param max_words  Capacity of bitmaps in words
+ * @return Number of structural chars (total popcount), or a NEON_JSON_ERR_*
+ *         status (NEON_JSON_ERR_OUTPUT_FULL if max_words is too small)
+ */
+int64_t neon_json_find_structural_bitmap(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint64_t* bitmaps,
+    size_t max_words
+);
+
+#define NEON_JSON_BITMAP_WORDS(len) (((len) + 63) / 64)
+
+/**
+ * Compact index: one byte per structural, delta-encoded.
+ *
+ * Each structural is stored as its distance from the previous one
+ * (the first relative to position -1, so every delta is >= 1). Gaps of
+ * 256 bytes or more - long strings - are written as a 0 byte followed by
+ * the gap as a 4-byte little-endian integer. Characters are not stored;
+ * read input[position] while decoding:
+ *
+ *   int64_t pos = -1;
+ *   for (size_t i = 0, k = 0; k < count; k++) {
+ *       uint32_t d = deltas[i++];
+ *       if (d == 0) { memcpy(&d, deltas + i, 4); i += 4; }
+ *       pos += d;   // input[pos] is the structural character
+ *   }
+ *
+ * @param deltas     Output stream
+ * @param max_bytes  Capacity of deltas; NEON_JSON_DELTA8_BOUND(input_len)
+ *                   always suffices
+ * @param out_bytes  Output (optional): bytes written to deltas
+ * @return Number of structural chars, or a NEON_JSON_ERR_* status
+ *         (NEON_JSON_ERR_TOO_LARGE above 4 GB, NEON_JSON_ERR_OUTPUT_FULL if
+ *         the stream does not fit)
+ */
+int64_t neon_json_find_structural_delta8(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* deltas,
+    size_t max_bytes,
+    size_t* out_bytes
+);
+
+#define NEON_JSON_DELTA8_BOUND(len) ((len) + (len) / 32 + 8)
+
+/**
+ * Skip index over a structural index, for jumping past containers.
+ *
+ * Built in one pass over the characters from neon_json_find_structural
+ * (or any Stage 1 output), in index space:
+ *
+ * - per chunk of 64 structurals, the net depth change (opens - closes)
+ *   and the lowest running depth reached inside the chunk (<= 0). A scan
+ *   looking for the close of a container at relative depth d can jump a
+ *   whole chunk whenever d + chunk_min[c] > 0.
+ * - (open, close) index pairs for every container spanning at least
+ *   min_span structurals, sorted by open, for O(log n) lookup.
+ *
+ * Unmatched brackets (malformed input) produce no pairs.
+ *
+ * @param characters   Structural characters
+ * @param count        Number of structurals
+ * @param min_span     Smallest close - open distance recorded in skip_pairs
+ * @param chunk_delta  Output, NEON_JSON_SKIP_CHUNKS(count) entries
+ * @param chunk_min    Output, NEON_JSON_SKIP_CHUNKS(count) entries
+ * @param skip_pairs   Output, 2 * max_pairs entries ([open, close] pairs)
+ * @param max_pairs    Capacity of skip_pairs in pairs (count / 2 always
+ *                     suffices; flat documents need far fewer)
+ * @param needed       Output (optional): total number of pairs
+ * @return Number of pairs, NEON_JSON_ERR_OUTPUT_FULL if more than max_pairs
+ *         exist (retry with *needed), or another NEON_JSON_ERR_* status
+ */
+int64_t neon_json_build_skip_index(
+    NeonContext* ctx,
+    const uint8_t* characters,
+    size_t count,
+    uint32_t min_span,
+    int32_t* chunk_delta,
+    int32_t* chunk_min,
+    uint32_t* skip_pairs,
+    size_t max_pairs,
+    uint64_t* needed
+);
+
+#define NEON_JSON_SKIP_CHUNKS(count) (((count) + 63) / 64)
+
+/**
+ * Multi-threaded neon_json_find_structural.
+ *
+ * The input is split into 64-byte aligned per-thread segments. The entry
+ * escape carry of each segment is read off the backslash run before it;
+ * quote parity is resolved with a prefix-XOR over per-segment parity bits
+ * after a first pass that assumes "outside a string", and only segments
+ * that actually start inside a string are re-classified. Per-thread
+ * results are concatenated at offsets from one prefix sum over the counts.
+ *
+ * Worker threads live in the context and are reused across calls. Inputs
+ * below ~256 KB per thread use fewer threads (a single segment runs on the
+ * calling thread).
+ *
+ * @param nthreads    Threads to use, <= 0 for all online CPUs (max 64)
+ * @return Number of structural chars found, NEON_JSON_ERR_OUTPUT_FULL if
+ *         more than max_output exist (max_output >= input_len always
+ *         suffices), or another NEON_JSON_ERR_* status
+ */
+int64_t neon_json_find_structural_parallel(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    uint32_t* positions,
+    uint8_t* characters,
+    size_t max_output,
+    int nthreads
+);
+
+/**
+ * Resumable Stage 1 for documents fed in chunks (e.g. 1 MB socket reads).
+ *
+ * Quote parity, the odd-backslash carry and the absolute offset live in
+ * the context, so positions are global offsets into the whole stream and
+ * peak memory is bounded by the chunk size, not the document size.
+ * Up to 63 trailing bytes of each chunk are buffered in the context and
+ * emitted by the next feed or by finish.
+ *
+ *   neon_json_stage1_begin(ctx);
+ *   while (read chunk)  n = neon_json_stage1_feed(ctx, chunk, len, pos, chars, len + 64);
+ *   n = neon_json_stage1_finish(ctx, pos, chars, 64);
+ *
+ * One stream per context at a time; neon_json_find_structural may still be
+ * used on the same context in between.
+ */
+
+/**
+ * Start a new stream, resetting all carried state.
+ * @return 0 on success, -1 on error
+ */
+int neon_json_stage1_begin(NeonContext* ctx);
+
+/**
+ * Feed the next chunk of the stream.
+ *
+ * @param ctx         Context with an active stream
+ * @param chunk       Next bytes of the document
+ * @param len         Chunk length (may be 0)
+ * @param positions   Output: absolute structural positions
+ * @param characters  Output: structural characters
+ * @param max_output  Output capacity, must be at least len + 64
+ * @return Number of structural chars emitted for this chunk, -1 on error,
+ *         NEON_JSON_ERR_OUTPUT_FULL (stream state untouched) if too small
+ */
+int64_t neon_json_stage1_feed(
+    NeonContext* ctx,
+    const uint8_t* chunk,
+    size_t len,
+    uint64_t* positions,
+    uint8_t* characters,
+    size_t max_output
+);
+
+/**
+ * Flush the buffered tail and end the stream.
+ *
+ * @param max_output  Output capacity, must be at least 64
+ * @return Number of structural chars emitted, -1 on error,
+ *         NEON_JSON_ERR_OUTPUT_FULL if too small
+ */
+int64_t neon_json_stage1_finish(
+    NeonContext* ctx,
+    uint64_t* positions,
+    uint8_t* characters,
+    size_t max_output
+);
+
+/**
+ * Whether the bytes consumed so far end inside a string.
+ * After finish, 1 means the document has an unterminated string.
+ * @return 1 or 0, -1 on error
+ */
+int neon_json_stage1_in_string(NeonContext* ctx);
+
+/**
+ * Total number of stream bytes fed so far.
+ */
+uint64_t neon_json_stage1_offset(NeonContext* ctx);
+
 /**
  * Simple character classification (no string filtering).
  * Faster but doesn't distinguish inside/outside strings.
@@ -87,17 +416,562 @@ int neon_json_classify(
 );
 
 /**
- * Check if NEON is available.
- * Always returns 1 on ARM64 macOS.
+ * Check if a SIMD Stage 1 kernel is available.
+ * Always returns 1 on ARM64; on x86-64 requires AVX2 or AVX-512BW.
+ * Without one, neon_json_find_structural still works via a scalar kernel.
  */
 int neon_json_is_available(void);
 
 /**
- * Get throughput estimate in MB/s for benchmarking.
- * Returns theoretical maximum based on CPU frequency.
+ * Name of the Stage 1 kernel selected for this context.
+ *
+ * @return "neon", "avx512", "avx2" or "scalar"
+ */
+const char* neon_json_kernel_name(NeonContext* ctx);
+
+/**
+ * Measured Stage 1 throughput in MB/s of this CPU's kernel.
+ *
+ * Calibrates on first use (see neon_json_calibrate) unless calibration
+ * was already run or loaded.
+ *
+ * @return MB/s, or 0.0 if calibration failed
  */
 double neon_json_throughput_estimate(void);
 
+/* =============================================================================
+ * Stage 1 Statistics (neon_json.c)
+ * ============================================================================= */
+
+/**
+ * Counters accumulated by a context while stats are enabled.
+ *
+ * Every field is a uint64_t, so bindings can read the struct as a flat
+ * array of JSON_CTX_STATS_FIELDS words. metal_bridge.h's MetalJsonStats
+ * has the same layout: one exporter covers both backends.
+ *
+ * Recorded by neon_json_find_structural (and _arena), _validated,
+ * _find_structural64, _bitmap, _delta8, the stage1_feed / _finish stream
+ * and _parallel. The parallel path runs the phases on several threads at
+ * once, so it only adds to total_ns, not to classify_ns / extract_ns.
+ *
+ * Counters are updated with relaxed atomic adds, so calls on one context
+ * from several threads (e.g. json_ndjson_open's workers) record safely;
+ * their times then add up per thread, like CPU time. A concurrent
+ * json_ctx_get_stats reads each field whole, not all fields at one instant.
+ */
+typedef struct {
+    uint64_t calls;          /* Stage 1 calls recorded */
+    uint64_t bytes;          /* Input bytes indexed */
+    uint64_t structurals;    /* Structural positions emitted */
+    uint64_t escape_blocks;  /* 64-byte blocks that hit the backslash slow path */
+    uint64_t classify_ns;    /* Kernel: classification, escapes, string mask */
+    uint64_t extract_ns;     /* Bitmaps -> positions / characters / deltas */
+    uint64_t total_ns;       /* Wall time of the recorded calls */
+    uint64_t gpu_ns;         /* Metal only: sum of GPUEndTime - GPUStartTime */
+    uint64_t gpu_start_ns;   /* Metal only: GPUStartTime of the last command buffer */
+    uint64_t gpu_end_ns;     /* Metal only: GPUEndTime of the last command buffer */
+} JsonCtxStats;
+
+#define JSON_CTX_STATS_FIELDS 10
+
+/**
+ * Turn stats recording on or off (off after neon_json_init).
+ *
+ * Disabled, a call pays one predictable branch per 8 KB batch, plus an
+ * increment on the kernels' backslash branch for escape_blocks. Enabled,
+ * each batch also reads the monotonic clock twice. Counters are kept
+ * when disabling; see json_ctx_reset_stats.
+ *
+ * @return 0 on success, NEON_JSON_ERR_INVALID for a NULL context
+ */
+int json_ctx_enable_stats(NeonContext* ctx, int enabled);
+
+/**
+ * Copy the counters accumulated since init or the last reset.
+ *
+ * @return 0 on success, NEON_JSON_ERR_INVALID for a NULL argument
+ */
+int json_ctx_get_stats(NeonContext* ctx, JsonCtxStats* stats);
+
+/* Zero the counters (recording stays on or off) */
+void json_ctx_reset_stats(NeonContext* ctx);
+
+/* =============================================================================
+ * Backend Calibration and Selection (neon_json_calibrate.c)
+ * =============================================================================
+ *
+ * Every Stage 1 backend is modelled as a fixed per-call overhead plus a
+ * streaming throughput, measured on this machine. json_select_backend
+ * picks the backend with the lowest predicted time for a given input.
+ *
+ * Typical service startup:
+ *
+ *   if (json_calibration_load(path) != 0) {
+ *       neon_json_calibrate(ctx);
+ *       // optional: metal_json_calibrate(mctx, &mbps, &ns);
+ *       //           json_calibration_set(JSON_BACKEND_METAL, mbps, ns);
+ *       json_calibration_save(path);
+ *   }
+ *   int backend = json_select_backend(len, JSON_SHAPE_DOCUMENT);
+ *
+ * The table is process-wide and thread-safe.
+ */
+
+#define JSON_BACKEND_SCALAR    0  /* Portable scalar kernel */
+#define JSON_BACKEND_SIMD      1  /* NEON / AVX2 / AVX-512 (neon_json_find_structural) */
+#define JSON_BACKEND_PARALLEL  2  /* neon_json_find_structural_parallel, all cores */
+#define JSON_BACKEND_METAL     3  /* metal_json_full_stage1 */
+#define JSON_BACKEND_COUNT     4
+
+#define JSON_SHAPE_DOCUMENT    0  /* One document, result needed right away */
+#define JSON_SHAPE_PIPELINED   1  /* One of many in flight (metal_json_stage1_submit),
+                                     so GPU per-call overhead is mostly hidden */
+
+typedef struct {
+    double mb_per_s;      /* Streaming throughput */
+    double overhead_ns;   /* Fixed cost per call */
+    int valid;            /* 0 if not measured (or backend unavailable) */
+} JsonBackendCost;
+
+/**
+ * Measure the CPU backends (scalar, SIMD, and parallel on multi-core
+ * machines) on 4 KB / 64 KB / 1 MB synthetic documents and store the
+ * fitted costs. Takes a few tens of milliseconds.
+ *
+ * @param ctx  Context whose kernel and worker pool are measured
+ * @return 0 on success, NEON_JSON_ERR_INVALID on failure
+ */
+int neon_json_calibrate(NeonContext* ctx);
+
+/**
+ * Store a backend cost measured elsewhere (e.g. metal_json_calibrate).
+ *
+ * @return 0 on success, NEON_JSON_ERR_INVALID on a bad backend or value
+ */
+int json_calibration_set(int backend, double mb_per_s, double overhead_ns);
+
+/**
+ * Read a backend cost.
+ *
+ * @return 0 if the backend is calibrated, NEON_JSON_ERR_INVALID otherwise
+ */
+int json_calibration_get(int backend, JsonBackendCost* cost);
+
+/* Forget all measurements */
+void json_calibration_reset(void);
+
+/**
+ * Load a calibration cache written by json_calibration_save.
+ *
+ * Files from another kernel or CPU count are treated as stale.
+ *
+ * @return 0 on success, NEON_JSON_ERR_INVALID if missing, malformed or stale
+ */
+int json_calibration_load(const char* path);
+
+/**
+ * Save the current calibration (atomically, via a temporary file).
+ *
+ * @return 0 on success, NEON_JSON_ERR_INVALID on I/O failure
+ */
+int json_calibration_save(const char* path);
+
+/**
+ * Pick the Stage 1 backend with the lowest predicted time.
+ *
+ * Without calibration, returns the CPU kernel selected at init
+ * (JSON_BACKEND_SIMD, or JSON_BACKEND_SCALAR without SIMD).
+ *
+ * @param size        Input size in bytes
+ * @param shape_hint  JSON_SHAPE_DOCUMENT or JSON_SHAPE_PIPELINED
+ * @return JSON_BACKEND_*
+ */
+int json_select_backend(size_t size, int shape_hint);
+
+/* "scalar", "simd", "parallel", "metal" */
+const char* json_backend_name(int backend);
+
+/* =============================================================================
+ * Batch Number Parsing (neon_json_number.c)
+ * ============================================================================= */
+
+#define JSON_NUMBER_INVALID  0  /* Not a JSON number (or position out of range) */
+#define JSON_NUMBER_INT64    1  /* Integer that fits int64_t */
+#define JSON_NUMBER_DOUBLE   2  /* Fraction / exponent, or integer beyond int64_t */
+
+/**
+ * Parse many numbers in one call.
+ *
+ * `positions` holds the offset of each number's first byte ('-' or a
+ * digit), e.g. the byte after each ':' / ',' / '[' structural that starts
+ * a number. Digits are scanned 16 at a time and converted 8 at a time;
+ * doubles are correctly rounded (Clinger / Eisel-Lemire, strtod for the
+ * rare cases those cannot decide). Magnitudes beyond the double range
+ * become +-infinity.
+ *
+ * For each i, out_kind[i] is a JSON_NUMBER_*. INT64 fills out_i64[i] and
+ * also out_f64[i] (as a double); DOUBLE fills out_f64[i] and zeroes
+ * out_i64[i]; INVALID zeroes both.
+ *
+ * @param input       Document bytes
+ * @param input_len   Document length (numbers never read past it)
+ * @param positions   Number start offsets
+ * @param n           Number of positions
+ * @return Count of valid numbers (n if all are), NEON_JSON_ERR_INVALID on
+ *         NULL arguments
+ */
+int64_t json_parse_numbers_batch(
+    const uint8_t* input,
+    size_t input_len,
+    const uint32_t* positions,
+    size_t n,
+    int64_t* out_i64,
+    double* out_f64,
+    uint8_t* out_kind
+);
+
+/* =============================================================================
+ * String Unescaping (neon_json_string.c)
+ * ============================================================================= */
+
+/**
+ * Decode a JSON string's escapes into `dst`.
+ *
+ * `src` points at the string content (just past the opening quote).
+ * Decoding stops at the first unescaped quote or after `len` bytes, so
+ * either the exact content length or the rest of the document may be
+ * passed. Runs without escapes are copied 16-32 bytes at a time;
+ * \uXXXX (including surrogate pairs) is written as UTF-8.
+ *
+ * @param dst  Output, at least `len` bytes (the result is never longer)
+ * @return Decoded length, or NEON_JSON_ERR_INVALID on a malformed escape
+ *         or unpaired surrogate
+ */
+int64_t json_unescape_string(const uint8_t* src, size_t len, uint8_t* dst);
+
+/* =============================================================================
+ * Memory-Mapped Input (neon_json_mmap.c)
+ * ============================================================================= */
+
+/* Readable zero bytes guaranteed past the end of a mapped file */
+#define JSON_MMAP_PADDING 64
+
+typedef struct JsonMappedFile JsonMappedFile;
+
+/**
+ * Map a file read-only for zero-copy parsing.
+ *
+ * The data pointer is page-aligned and followed by at least
+ * JSON_MMAP_PADDING readable zero bytes, so it can go straight to
+ * neon_json_find_structural* or, with json_mmap_mapped_length, to
+ * metal_json_register_input. The mapping is advised MADV_SEQUENTIAL, and
+ * files of 2 MB and more are 2 MB aligned and advised MADV_HUGEPAGE where
+ * the platform has it.
+ *
+ * @return Mapped file, or NULL on failure (missing file, not a regular
+ *         file, mmap error)
+ */
+JsonMappedFile* json_mmap_open(const char* path);
+
+/** Start of the file contents (NULL if file is NULL) */
+const uint8_t* json_mmap_data(const JsonMappedFile* file);
+
+/** File size in bytes */
+size_t json_mmap_size(const JsonMappedFile* file);
+
+/** Page-rounded length of the whole mapping, padding included */
+size_t json_mmap_mapped_length(const JsonMappedFile* file);
+
+/** Unmap the file; pointers from json_mmap_data become invalid */
+void json_mmap_close(JsonMappedFile* file);
+
+/* =============================================================================
+ * Native Tape Construction (neon_json_tape.c)
+ * ============================================================================= */
+
+/* Tape tags, same as TAPE_* in src/tape_parser.mojo */
+#define JSON_TAPE_ROOT         'r'
+#define JSON_TAPE_START_ARRAY  '['
+#define JSON_TAPE_END_ARRAY    ']'
+#define JSON_TAPE_START_OBJECT '{'
+#define JSON_TAPE_END_OBJECT   '}'
+#define JSON_TAPE_STRING       '"'
+#define JSON_TAPE_INT64        'l'
+#define JSON_TAPE_DOUBLE       'd'
+#define JSON_TAPE_TRUE         't'
+#define JSON_TAPE_FALSE        'f'
+#define JSON_TAPE_NULL         'n'
+
+/* String ref flag: content contains escapes (decode lazily) */
+#define JSON_TAPE_STRING_ESCAPED 1
+
+/* String ref flag set by decode_strings_native: start is an offset into
+ * the string buffer, which holds the decoded content */
+#define JSON_TAPE_STRING_DECODED 2
+
+/* Deepest container nesting json_build_tape accepts */
+#define JSON_TAPE_MAX_DEPTH 1024
+
+/* Worst-case tape entries / string buffer bytes for n structurals */
+#define JSON_TAPE_MAX_ENTRIES(n)   (2 * (n) + 3)
+#define JSON_TAPE_STRING_BOUND(n)  ((n) / 2 * 9 + 9)
+
+/**
+ * Build a JsonTape-compatible tape from a structural index.
+ *
+ * Writes 64-bit entries ([8-bit tag | 56-bit payload], JSON_TAPE_* tags)
+ * to tape_out and 9-byte string refs ([u32 start][u32 length][u8 flags],
+ * little-endian, offsets into input) to string_buf_out, exactly as the
+ * Mojo TapeParser does, so both buffers can be adopted as-is. Numbers are
+ * parsed in place (same rules as json_parse_numbers_batch). The input is
+ * validated against the JSON grammar on the way: container nesting and
+ * separators, literals, numbers and string escapes (one of \" \\ \/ \b \f
+ * \n \r \t, or \u with 4 hex digits). UTF-8 and raw control characters
+ * inside strings are not checked - use neon_json_find_structural_validated
+ * for those.
+ *
+ * @param input                Document
+ * @param input_len            Document length (< 4 GB)
+ * @param positions            Structurals from neon_json_find_structural
+ * @param n                    Number of structurals
+ * @param tape_out             Output entries, JSON_TAPE_MAX_ENTRIES(n) suffices
+ * @param tape_capacity        Capacity of tape_out in entries
+ * @param string_buf_out       Output string refs, JSON_TAPE_STRING_BOUND(n) suffices
+ * @param string_buf_capacity  Capacity of string_buf_out in bytes
+ * @param string_buf_len       Output: bytes written to string_buf_out
+ * @return Number of tape entries, NEON_JSON_ERR_INVALID for malformed JSON,
+ *         NEON_JSON_ERR_OUTPUT_FULL if a buffer is too small or
+ *         NEON_JSON_ERR_TOO_LARGE past JSON_TAPE_MAX_DEPTH / 4 GB
+ */
+int64_t json_build_tape(
+    const uint8_t* input,
+    size_t input_len,
+    const uint32_t* positions,
+    size_t n,
+    uint64_t* tape_out,
+    size_t tape_capacity,
+    uint8_t* string_buf_out,
+    size_t string_buf_capacity,
+    size_t* string_buf_len
+);
+
+/* =============================================================================
+ * JSON Pointer Queries (neon_json_query.c)
+ * ============================================================================= */
+
+/* Most paths per json_query_paths call */
+#define JSON_QUERY_MAX_PATHS 64
+
+/* Most distinct path prefixes (trie nodes, root included) per call */
+#define JSON_QUERY_MAX_NODES 256
+
+/* Byte range of one value in the input */
+typedef struct {
+    uint32_t start;     /* Offset of the value's first byte (a quote for strings) */
+    uint32_t length;    /* Length in bytes, 0 if the path matched nothing */
+} JsonSpan;
+
+/**
+ * Look up several RFC 6901 JSON Pointers in one pass, without a tape.
+ *
+ * The paths are compiled into a token trie and evaluated while Stage 1
+ * runs (1 KB of bitmaps at a time): only containers on a path are
+ * entered, everything else is skipped by bracket counting, and the walk
+ * stops as soon as every path has matched. Spans cover the raw value
+ * text, quotes and escapes included (decode with json_unescape_string).
+ * Duplicate keys resolve to the first occurrence. The document is only
+ * checked as far as the walk needs, so this is not a validator.
+ *
+ * @param ctx        Context providing the Stage 1 kernel
+ * @param input      Document
+ * @param input_len  Document length (< 4 GB)
+ * @param paths      NUL-terminated pointers ("" = whole document, "/a/0")
+ * @param n_paths    Number of paths (at most JSON_QUERY_MAX_PATHS)
+ * @param out_spans  Output: one span per path, length 0 if not found
+ * @return Number of paths found, NEON_JSON_ERR_INVALID for a malformed
+ *         pointer or document (including a bad escape in a key the walk
+ *         compares), or NEON_JSON_ERR_TOO_LARGE past the
+ *         JSON_QUERY_* limits / 4 GB
+ */
+int64_t json_query_paths(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    const char* const* paths,
+    size_t n_paths,
+    JsonSpan* out_spans
+);
+
+/* =============================================================================
+ * NDJSON Prefilter (neon_json_ndjson.c)
+ * ============================================================================= */
+
+/**
+ * Find the NDJSON lines that contain every needle, before any parsing.
+ *
+ * Scans for the longest needle with a first/last-byte broadcast compare
+ * over 64-byte blocks; each hit's line is then checked for the other
+ * needles. Lines are split and trimmed like find_line_boundaries_simd
+ * (src/ndjson.mojo). This is a byte-level prefilter: a candidate line may
+ * still fail the real predicate (e.g. the bytes matched inside another
+ * string), so the caller parses and tests the candidates. With no
+ * needles every non-empty line is returned.
+ *
+ * Output stops after max_lines lines; call again with the updated
+ * *resume to continue.
+ *
+ * @param input        NDJSON data
+ * @param input_len    Length of input in bytes
+ * @param needles      Literal byte strings (e.g. "\"level\":", "\"error\"")
+ * @param needle_lens  Length of each needle
+ * @param n_needles    Number of needles
+ * @param line_spans   Output: [start, end) byte offset pairs, 2 per line
+ * @param max_lines    Capacity of line_spans in lines
+ * @param resume       In: offset to start at (0, or a previous *resume);
+ *                     Out: where to continue, input_len when done
+ * @return Number of candidate lines written, or NEON_JSON_ERR_INVALID
+ */
+int64_t json_ndjson_prefilter(
+    const uint8_t* input,
+    size_t input_len,
+    const uint8_t* const* needles,
+    const size_t* needle_lens,
+    size_t n_needles,
+    uint64_t* line_spans,
+    size_t max_lines,
+    size_t* resume
+);
+
+/* =============================================================================
+ * Parallel NDJSON Parsing (neon_json_ndjson_parallel.c)
+ * ============================================================================= */
+
+/* Default task size and thread cap for json_ndjson_open */
+#define JSON_NDJSON_TASK_BYTES  (256 * 1024)
+#define JSON_NDJSON_MAX_THREADS 64
+
+/* One parsed line, valid until the next json_ndjson_next call */
+typedef struct {
+    uint64_t index;           /* Record number: non-empty lines before this one */
+    uint64_t start;           /* Line span [start, end) in the input, trimmed */
+    uint64_t end;
+    int64_t status;           /* Tape entries, or NEON_JSON_ERR_* for a bad line */
+    const uint64_t* tape;     /* json_build_tape output; string refs are relative to start */
+    const uint8_t* strings;
+    size_t strings_len;
+} JsonNdjsonRecord;
+
+typedef struct JsonNdjsonParser JsonNdjsonParser;
+
+/**
+ * Start parsing NDJSON on worker threads.
+ *
+ * The input is split at newlines into tasks of about task_bytes, which
+ * workers take from per-worker deques and steal from each other. Each
+ * line gets neon_json_find_structural + json_build_tape. At most two
+ * tasks per thread are in flight, and results come back strictly in
+ * input order, so memory stays bounded for inputs of any size (e.g. a
+ * json_mmap_open mapping). Lines are split and trimmed like
+ * find_line_boundaries_simd in src/ndjson.mojo.
+ *
+ * Workers share ctx's Stage 1 kernel; do not use ctx for anything else
+ * until json_ndjson_close.
+ *
+ * @param ctx          Context providing the Stage 1 kernel
+ * @param input        NDJSON data (must stay valid until close)
+ * @param input_len    Length of input in bytes
+ * @param num_threads  Worker threads, 0 for one per online CPU
+ * @param task_bytes   Task size, 0 for JSON_NDJSON_TASK_BYTES
+ * @return Parser, or NULL on failure
+ */
+JsonNdjsonParser* json_ndjson_open(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    size_t num_threads,
+    size_t task_bytes
+);
+
+/**
+ * Wait for the next task's records, in input order.
+ *
+ * The records (and their tapes) stay valid until the next call or
+ * json_ndjson_close; the call hands the previous task's buffers back to
+ * the workers.
+ *
+ * @param parser   Parser from json_ndjson_open
+ * @param records  Output: the task's records
+ * @return Number of records, 0 at end of input, NEON_JSON_ERR_INVALID on
+ *         allocation failure
+ */
+int64_t json_ndjson_next(JsonNdjsonParser* parser, const JsonNdjsonRecord** records);
+
+/** Stop the workers and free the parser */
+void json_ndjson_close(JsonNdjsonParser* parser);
+
+/* Record consumer for json_ndjson_parse_parallel; return non-zero to stop */
+typedef int (*JsonNdjsonConsumer)(void* user, const JsonNdjsonRecord* records, size_t count);
+
+/**
+ * Parse all of input with json_ndjson_open and hand each task's records
+ * to consumer, in input order, on the calling thread.
+ *
+ * @return Records delivered, or NEON_JSON_ERR_INVALID
+ */
+int64_t json_ndjson_parse_parallel(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    size_t num_threads,
+    size_t task_bytes,
+    JsonNdjsonConsumer consumer,
+    void* user
+);
+
+/* =============================================================================
+ * Tape Serialization (neon_json_write.c)
+ * ============================================================================= */
+
+/* Output bytes that always suffice for a tape over text_len bytes of
+ * source plus string buffer (every byte escaped as \u00XX) */
+#define JSON_WRITE_TAPE_BOUND(text_len, n_entries) (6 * (text_len) + 16 * (n_entries))
+
+/**
+ * Serialize a JsonTape-layout tape as compact JSON.
+ *
+ * Strings are escaped with 16-byte vector scans (clean runs are copied
+ * 32 bytes at a time), integers use a digit-pair table, and doubles are
+ * printed as the shortest decimal that round-trips (Schubfach) in
+ * Python repr style ("1.5", "1e+16", "2.0"). Strings still flagged
+ * JSON_TAPE_STRING_ESCAPED are copied from the source as they are, after
+ * checking their escapes; an invalid one (possible in a tape not built by
+ * json_build_tape) is NEON_JSON_ERR_INVALID rather than invalid output.
+ * NaN and Infinity become null.
+ *
+ * @param tape          Entries from json_build_tape or a Mojo JsonTape
+ * @param n_entries     Number of entries
+ * @param strings       String ref buffer (and decoded strings)
+ * @param strings_len   Bytes in strings
+ * @param source        Document the string refs point into
+ * @param source_len    Document length
+ * @param out           Output buffer
+ * @param out_capacity  Capacity of out, JSON_WRITE_TAPE_BOUND suffices
+ * @return Bytes written, NEON_JSON_ERR_OUTPUT_FULL if out is too small,
+ *         NEON_JSON_ERR_INVALID for a malformed tape / string escape or
+ *         NEON_JSON_ERR_TOO_LARGE past JSON_TAPE_MAX_DEPTH
+ */
+int64_t json_write_tape(
+    const uint64_t* tape,
+    size_t n_entries,
+    const uint8_t* strings,
+    size_t strings_len,
+    const uint8_t* source,
+    size_t source_len,
+    uint8_t* out,
+    size_t out_capacity
+);
+
 #ifdef __cplusplus
 }
 #endif
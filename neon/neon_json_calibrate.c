@@ -0,0 +1,422 @@
+/**
+ * Backend calibration and selection (json_select_backend)
+ *
+ * Each Stage 1 backend is modelled as a fixed per-call overhead plus a
+ * streaming throughput:
+ *
+ *     time(size) = overhead_ns + size / throughput
+ *
+ * neon_json_calibrate measures the CPU backends (scalar, SIMD, parallel)
+ * on synthetic documents of a few sizes and fits that line; the Metal
+ * bridge measures itself (metal_json_calibrate) and reports through
+ * json_calibration_set. The table is process-wide and can be persisted,
+ * so a service calibrates once per machine instead of once per start.
+ */
+
+#include "neon_json.h"
+#include "neon_json_internal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Synthetic sizes: overhead-dominated, crossover region, throughput-dominated */
+static const size_t CALIBRATION_SIZES[] = { 4 * 1024, 64 * 1024, 1024 * 1024 };
+#define NUM_CALIBRATION_SIZES (sizeof(CALIBRATION_SIZES) / sizeof(CALIBRATION_SIZES[0]))
+
+/* Bytes processed per size (bounds calibration to a few tens of ms) */
+#define CALIBRATION_BYTES (8 * 1024 * 1024)
+#define CALIBRATION_MIN_RUNS 5
+#define CALIBRATION_MAX_RUNS 512
+
+/* Pipelined GPU calls overlap across the submit ring (METAL_STAGE1_RING) */
+#define PIPELINED_OVERLAP 3.0
+
+#define CALIBRATION_FILE_MAGIC "mojo-json-calibration"
+#define CALIBRATION_FILE_VERSION 1
+
+static const char* const BACKEND_NAMES[JSON_BACKEND_COUNT] = {
+    "scalar", "simd", "parallel", "metal"
+};
+
+static pthread_mutex_t calibration_lock = PTHREAD_MUTEX_INITIALIZER;
+static JsonBackendCost calibration[JSON_BACKEND_COUNT];
+
+/* =============================================================================
+ * Measurement
+ * ============================================================================= */
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Synthetic API-response style JSON (same pattern as bench_movemask) */
+static void fill_synthetic(uint8_t* buf, size_t len) {
+    static const char pattern[] = "{\"id\": 12345, \"name\": \"value\\\"q\\\"\", \"tags\": [1, 2, 3]}, ";
+    size_t n = 0;
+    while (n < len) {
+        size_t k = sizeof(pattern) - 1;
+        if (k > len - n) k = len - n;
+        memcpy(buf + n, pattern, k);
+        n += k;
+    }
+}
+
+typedef int64_t (*Stage1Call)(NeonContext* ctx, const uint8_t* input, size_t len,
+                              uint32_t* positions, uint8_t* characters);
+
+static int64_t call_serial(NeonContext* ctx, const uint8_t* input, size_t len,
+                           uint32_t* positions, uint8_t* characters) {
+    return neon_json_find_structural(ctx, input, len, positions, characters, len);
+}
+
+static int64_t call_parallel(NeonContext* ctx, const uint8_t* input, size_t len,
+                             uint32_t* positions, uint8_t* characters) {
+    return neon_json_find_structural_parallel(ctx, input, len, positions, characters, len, 0);
+}
+
+/* Median ns per call for one input size */
+static double time_calls(Stage1Call call, NeonContext* ctx, const uint8_t* input, size_t len,
+                         uint32_t* positions, uint8_t* characters, double* samples) {
+    size_t runs = CALIBRATION_BYTES / len;
+    if (runs < CALIBRATION_MIN_RUNS) runs = CALIBRATION_MIN_RUNS;
+    if (runs > CALIBRATION_MAX_RUNS) runs = CALIBRATION_MAX_RUNS;
+
+    /* Warm caches, page in the output and wake the pool */
+    call(ctx, input, len, positions, characters);
+
+    for (size_t r = 0; r < runs; r++) {
+        double start = now_ns();
+        call(ctx, input, len, positions, characters);
+        samples[r] = now_ns() - start;
+    }
+
+    qsort(samples, runs, sizeof(double), compare_double);
+    return samples[runs / 2];
+}
+
+/* Fit time = overhead + size / throughput through the samples */
+static int fit_line(const double* sizes, const double* times_ns, size_t n,
+                    double* mb_per_s, double* overhead_ns) {
+    if (n < 2) return NEON_JSON_ERR_INVALID;
+
+    /* Least-squares line through (size, time) */
+    double mean_x = 0, mean_y = 0;
+    for (size_t i = 0; i < n; i++) {
+        mean_x += sizes[i];
+        mean_y += times_ns[i];
+    }
+    mean_x /= (double)n;
+    mean_y /= (double)n;
+
+    double sxx = 0, sxy = 0;
+    for (size_t i = 0; i < n; i++) {
+        sxx += (sizes[i] - mean_x) * (sizes[i] - mean_x);
+        sxy += (sizes[i] - mean_x) * (times_ns[i] - mean_y);
+    }
+
+    double ns_per_byte = sxx > 0 ? sxy / sxx : 0;
+    double overhead = mean_y - ns_per_byte * mean_x;
+
+    /* Noise can tilt the line; fall back to the largest sample */
+    if (ns_per_byte <= 0) {
+        ns_per_byte = times_ns[n - 1] / sizes[n - 1];
+        overhead = 0;
+    }
+    if (overhead < 0) overhead = 0;
+
+    *mb_per_s = 1e3 / ns_per_byte;  /* bytes/ns -> MB/s */
+    *overhead_ns = overhead;
+    return 0;
+}
+
+static int calibrate_backend(Stage1Call call, NeonContext* ctx, const uint8_t* input,
+                             uint32_t* positions, uint8_t* characters, double* samples,
+                             JsonBackendCost* cost) {
+    double sizes[NUM_CALIBRATION_SIZES];
+    double times[NUM_CALIBRATION_SIZES];
+
+    for (size_t i = 0; i < NUM_CALIBRATION_SIZES; i++) {
+        sizes[i] = (double)CALIBRATION_SIZES[i];
+        times[i] = time_calls(call, ctx, input, CALIBRATION_SIZES[i],
+                              positions, characters, samples);
+    }
+
+    if (fit_line(sizes, times, NUM_CALIBRATION_SIZES,
+                 &cost->mb_per_s, &cost->overhead_ns) != 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+    cost->valid = 1;
+    return 0;
+}
+
+/* Measure scalar, SIMD and parallel into costs[] */
+static int calibrate_cpu(NeonContext* ctx, NeonContext* scalar_ctx, const uint8_t* input,
+                         uint32_t* positions, uint8_t* characters, double* samples,
+                         JsonBackendCost* costs) {
+    json_ctx_force_scalar(scalar_ctx);
+    if (calibrate_backend(call_serial, scalar_ctx, input, positions, characters,
+                          samples, &costs[JSON_BACKEND_SCALAR]) != 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    /* No SIMD kernel: the "simd" backend would just be the scalar one again */
+    if (neon_json_is_available() &&
+        calibrate_backend(call_serial, ctx, input, positions, characters,
+                          samples, &costs[JSON_BACKEND_SIMD]) != 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 1 &&
+        calibrate_backend(call_parallel, ctx, input, positions, characters,
+                          samples, &costs[JSON_BACKEND_PARALLEL]) != 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+    return 0;
+}
+
+int neon_json_calibrate(NeonContext* ctx) {
+    if (!ctx) return NEON_JSON_ERR_INVALID;
+
+    size_t max_size = CALIBRATION_SIZES[NUM_CALIBRATION_SIZES - 1];
+    uint8_t* input = malloc(max_size);
+    uint32_t* positions = malloc(max_size * sizeof(uint32_t));
+    uint8_t* characters = malloc(max_size);
+    double* samples = malloc(CALIBRATION_MAX_RUNS * sizeof(double));
+    NeonContext* scalar_ctx = neon_json_init();
+
+    int status = NEON_JSON_ERR_INVALID;
+    JsonBackendCost costs[JSON_BACKEND_PARALLEL + 1];
+    memset(costs, 0, sizeof(costs));
+
+    if (input && positions && characters && samples && scalar_ctx) {
+        fill_synthetic(input, max_size);
+        status = calibrate_cpu(ctx, scalar_ctx, input, positions, characters, samples, costs);
+    }
+
+    if (status == 0) {
+        pthread_mutex_lock(&calibration_lock);
+        for (int b = JSON_BACKEND_SCALAR; b <= JSON_BACKEND_PARALLEL; b++) {
+            calibration[b] = costs[b];
+        }
+        pthread_mutex_unlock(&calibration_lock);
+    }
+
+    neon_json_free(scalar_ctx);
+    free(samples);
+    free(characters);
+    free(positions);
+    free(input);
+    return status;
+}
+
+/* =============================================================================
+ * Table Access
+ * ============================================================================= */
+
+int json_calibration_set(int backend, double mb_per_s, double overhead_ns) {
+    if (backend < 0 || backend >= JSON_BACKEND_COUNT || !(mb_per_s > 0) || overhead_ns < 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    pthread_mutex_lock(&calibration_lock);
+    calibration[backend].mb_per_s = mb_per_s;
+    calibration[backend].overhead_ns = overhead_ns;
+    calibration[backend].valid = 1;
+    pthread_mutex_unlock(&calibration_lock);
+    return 0;
+}
+
+int json_calibration_get(int backend, JsonBackendCost* cost) {
+    if (backend < 0 || backend >= JSON_BACKEND_COUNT || !cost) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    pthread_mutex_lock(&calibration_lock);
+    *cost = calibration[backend];
+    pthread_mutex_unlock(&calibration_lock);
+    return cost->valid ? 0 : NEON_JSON_ERR_INVALID;
+}
+
+void json_calibration_reset(void) {
+    pthread_mutex_lock(&calibration_lock);
+    memset(calibration, 0, sizeof(calibration));
+    pthread_mutex_unlock(&calibration_lock);
+}
+
+int json_select_backend(size_t size, int shape_hint) {
+    JsonBackendCost costs[JSON_BACKEND_COUNT];
+
+    pthread_mutex_lock(&calibration_lock);
+    memcpy(costs, calibration, sizeof(costs));
+    pthread_mutex_unlock(&calibration_lock);
+
+    /* Uncalibrated: the CPU kernel picked at init */
+    int best = neon_json_is_available() ? JSON_BACKEND_SIMD : JSON_BACKEND_SCALAR;
+    double best_ns = -1;
+
+    for (int b = 0; b < JSON_BACKEND_COUNT; b++) {
+        if (!costs[b].valid) continue;
+        if (b == JSON_BACKEND_METAL && size > UINT32_MAX) continue;
+
+        double overhead = costs[b].overhead_ns;
+        if (b == JSON_BACKEND_METAL && shape_hint == JSON_SHAPE_PIPELINED) {
+            overhead /= PIPELINED_OVERLAP;
+        }
+
+        /* Ties go to the lower (simpler) backend */
+        double ns = overhead + (double)size * 1e3 / costs[b].mb_per_s;
+        if (best_ns < 0 || ns < best_ns) {
+            best = b;
+            best_ns = ns;
+        }
+    }
+    return best;
+}
+
+const char* json_backend_name(int backend) {
+    if (backend < 0 || backend >= JSON_BACKEND_COUNT) return "unknown";
+    return BACKEND_NAMES[backend];
+}
+
+double neon_json_throughput_estimate(void) {
+    JsonBackendCost cost;
+    int backend = neon_json_is_available() ? JSON_BACKEND_SIMD : JSON_BACKEND_SCALAR;
+
+    if (json_calibration_get(backend, &cost) != 0) {
+        /* Calibrate on first use */
+        NeonContext* ctx = neon_json_init();
+        int status = neon_json_calibrate(ctx);
+        neon_json_free(ctx);
+        if (status != 0 || json_calibration_get(backend, &cost) != 0) {
+            return 0.0;
+        }
+    }
+    return cost.mb_per_s;
+}
+
+/* =============================================================================
+ * Cache File
+ * =============================================================================
+ *
+ *   mojo-json-calibration 1
+ *   kernel avx2
+ *   cpus 8
+ *   simd 7421.3 310.0
+ *   ...
+ *
+ * A file written with a different kernel or CPU count is stale: the numbers
+ * would describe another machine (or a container with another CPU quota).
+ */
+
+static long online_cpus(void) {
+    return sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static const char* current_kernel(void) {
+    NeonContext* ctx = neon_json_init();
+    const char* name = ctx ? neon_json_kernel_name(ctx) : "unknown";
+    neon_json_free(ctx);
+    return name;  /* Static string */
+}
+
+int json_calibration_save(const char* path) {
+    if (!path) return NEON_JSON_ERR_INVALID;
+
+    JsonBackendCost costs[JSON_BACKEND_COUNT];
+    pthread_mutex_lock(&calibration_lock);
+    memcpy(costs, calibration, sizeof(costs));
+    pthread_mutex_unlock(&calibration_lock);
+
+    /* Write-then-rename so concurrent readers never see a partial file */
+    size_t path_len = strlen(path);
+    char* tmp_path = malloc(path_len + 8);
+    if (!tmp_path) return NEON_JSON_ERR_INVALID;
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    FILE* f = fopen(tmp_path, "w");
+    if (!f) {
+        free(tmp_path);
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    fprintf(f, "%s %d\n", CALIBRATION_FILE_MAGIC, CALIBRATION_FILE_VERSION);
+    fprintf(f, "kernel %s\n", current_kernel());
+    fprintf(f, "cpus %ld\n", online_cpus());
+    for (int b = 0; b < JSON_BACKEND_COUNT; b++) {
+        if (costs[b].valid) {
+            fprintf(f, "%s %.3f %.3f\n", BACKEND_NAMES[b], costs[b].mb_per_s, costs[b].overhead_ns);
+        }
+    }
+
+    int failed = ferror(f);
+    failed |= fclose(f);
+    if (!failed) failed = rename(tmp_path, path);
+    if (failed) remove(tmp_path);
+
+    free(tmp_path);
+    return failed ? NEON_JSON_ERR_INVALID : 0;
+}
+
+/* Parse a cache file into costs[]; rejects stale or malformed files */
+static int read_calibration(FILE* f, JsonBackendCost* costs) {
+    char magic[32], kernel[32];
+    int version;
+    long cpus;
+
+    if (fscanf(f, "%31s %d", magic, &version) != 2 ||
+        strcmp(magic, CALIBRATION_FILE_MAGIC) != 0 ||
+        version != CALIBRATION_FILE_VERSION ||
+        fscanf(f, " kernel %31s", kernel) != 1 ||
+        fscanf(f, " cpus %ld", &cpus) != 1 ||
+        strcmp(kernel, current_kernel()) != 0 ||
+        cpus != online_cpus()) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    char name[32];
+    double mb_per_s, overhead_ns;
+    while (fscanf(f, "%31s %lf %lf", name, &mb_per_s, &overhead_ns) == 3) {
+        for (int b = 0; b < JSON_BACKEND_COUNT; b++) {
+            if (strcmp(name, BACKEND_NAMES[b]) == 0 && mb_per_s > 0 && overhead_ns >= 0) {
+                costs[b].mb_per_s = mb_per_s;
+                costs[b].overhead_ns = overhead_ns;
+                costs[b].valid = 1;
+            }
+        }
+    }
+
+    /* A usable file has at least the CPU baseline */
+    return costs[JSON_BACKEND_SCALAR].valid ? 0 : NEON_JSON_ERR_INVALID;
+}
+
+int json_calibration_load(const char* path) {
+    if (!path) return NEON_JSON_ERR_INVALID;
+
+    FILE* f = fopen(path, "r");
+    if (!f) return NEON_JSON_ERR_INVALID;
+
+    JsonBackendCost costs[JSON_BACKEND_COUNT];
+    memset(costs, 0, sizeof(costs));
+    int status = read_calibration(f, costs);
+    fclose(f);
+
+    if (status == 0) {
+        pthread_mutex_lock(&calibration_lock);
+        memcpy(calibration, costs, sizeof(costs));
+        pthread_mutex_unlock(&calibration_lock);
+    }
+    return status;
+}
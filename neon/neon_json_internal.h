@@ -0,0 +1,370 @@
+/**
+ * Internal interface between the Stage 1 driver and per-ISA kernels.
+ *
+ * Not part of the public ABI - see neon_json.h for that.
+ *
+ * A Stage 1 kernel consumes whole 64-byte blocks and produces, per block,
+ * a bitmap of structural characters outside strings plus unescaped quotes.
+ * The driver in neon_json.c owns everything else: carries between calls,
+ * the padded tail block and position extraction.
+ */
+
+#ifndef NEON_JSON_INTERNAL_H
+#define NEON_JSON_INTERNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Carry state between consecutive 64-byte blocks */
+typedef struct {
+    uint64_t prev_in_string;  /* ~0 if the previous block ended inside a string */
+    uint64_t prev_escaped;    /* 1 if the first byte of the next block is escaped */
+    uint64_t escape_blocks;   /* Blocks that had backslashes (json_ctx_get_stats) */
+} JsonStage1State;
+
+/**
+ * Stage 1 kernel: classify `num_blocks` 64-byte blocks starting at `input`
+ * and write one filtered structural bitmap per block to `structurals`.
+ */
+typedef void (*JsonStage1Kernel)(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    uint64_t* structurals
+);
+
+/**
+ * Find characters escaped by a preceding odd-length backslash run.
+ *
+ * Branchless carry-based algorithm (from simdjson):
+ * 1. Drop a leading backslash that was itself escaped by the previous block
+ * 2. Add the odd-aligned sequence starts to the backslash mask - the carry
+ *    ripples through each run and clears it, leaving a bit just past the run
+ *    whenever the run started on an even bit
+ * 3. Flip the even/odd alternation for those runs so that the character
+ *    after every odd-length run is marked as escaped
+ *
+ * The overflow of the addition means the last run reaches past bit 63, i.e.
+ * the first byte of the next block is escaped. It is returned via
+ * prev_escaped, the same way prev_in_string carries quote parity.
+ *
+ * Blocks that take the slow path are counted in escape_blocks; the counter
+ * lives on that branch only, so backslash-free blocks pay nothing for it.
+ *
+ * @param backslashes  Backslash bitmap for this block
+ * @param state        In/Out: prev_escaped is 1 if the first byte of this
+ *                     block is escaped
+ * @return Bitmap of escaped characters (including escaped backslashes)
+ */
+static inline uint64_t json_find_escaped(uint64_t backslashes, JsonStage1State* state) {
+    const uint64_t even_bits = 0x5555555555555555ULL;
+    uint64_t* prev_escaped = &state->prev_escaped;
+
+    /* Fast path: no backslashes, only the carried escape (if any) applies */
+    if (backslashes == 0) {
+        uint64_t escaped = *prev_escaped;
+        *prev_escaped = 0;
+        return escaped;
+    }
+    state->escape_blocks++;
+
+    /* A backslash escaped by the previous block does not start a run */
+    backslashes &= ~*prev_escaped;
+    uint64_t follows_escape = (backslashes << 1) | *prev_escaped;
+
+    /* Clear runs starting on odd bits via carry propagation */
+    uint64_t odd_sequence_starts = backslashes & ~even_bits & ~follows_escape;
+    uint64_t sequences_starting_on_even_bits;
+    *prev_escaped = __builtin_add_overflow(odd_sequence_starts, backslashes,
+                                           &sequences_starting_on_even_bits);
+    uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+
+    /* Every other character after a run start is escaped */
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+/**
+ * Resolve one block's raw masks into the filtered structural bitmap.
+ *
+ * @param state        Carry state (prev_in_string is updated)
+ * @param structural   { } [ ] : , bitmap (quotes excluded)
+ * @param quotes       Unescaped quote bitmap
+ * @param escaped      Escaped character bitmap from json_find_escaped
+ * @param quote_xor    prefix_xor(quotes) computed by the kernel's clmul
+ * @return Structural chars outside strings, plus unescaped quotes
+ */
+static inline uint64_t json_finish_block(
+    JsonStage1State* state,
+    uint64_t structural,
+    uint64_t quotes,
+    uint64_t escaped,
+    uint64_t quote_xor
+) {
+    /* Invert the in-string mask if we start inside a string */
+    uint64_t string_mask = quote_xor ^ state->prev_in_string;
+
+    /* All-ones if the block ends inside a string */
+    state->prev_in_string = (uint64_t)((int64_t)string_mask >> 63);
+
+    return (structural & ~escaped & ~string_mask) | quotes;
+}
+
+/**
+ * Result for a block the whitespace-heavy kernels found to be all
+ * whitespace, without classifying it. Such a block has no quotes and no
+ * backslashes, so the string state carries through unchanged and a carried
+ * escape is consumed by its first byte; nothing in it is structural.
+ */
+static inline uint64_t json_skip_whitespace_block(JsonStage1State* state) {
+    state->prev_escaped = 0;
+    return 0;
+}
+
+/*
+ * Kernel bodies are written once with constant flags (e.g. skip_whitespace)
+ * and force-inlined into thin per-variant wrappers, so each JsonStage1Kernel
+ * is compiled with the unused branches folded away.
+ */
+#define JSON_KERNEL_BODY static inline __attribute__((always_inline))
+
+/* Portable prefix-XOR for kernels without carry-less multiply */
+static inline uint64_t json_prefix_xor_scalar(uint64_t mask) {
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+    return mask;
+}
+
+/* =============================================================================
+ * Validating Stage 1 (UTF-8 + string control characters)
+ * ============================================================================= */
+
+/* Carry state of the UTF-8 lookup validator between blocks */
+typedef struct {
+    uint8_t prev_block[16];       /* Last 16 bytes of the previous non-ASCII block */
+    uint8_t prev_incomplete[16];  /* Non-zero if that block ended mid-sequence */
+} JsonUtf8State;
+
+/**
+ * Validating Stage 1 kernel: same output as JsonStage1Kernel, plus UTF-8
+ * validation and a check for raw control characters (< 0x20) inside
+ * strings, fused into the same pass over each block.
+ *
+ * Errors are only accumulated, not located: the return value is the OR of
+ * NEON_JSON_INVALID_* over all `num_blocks` blocks so the hot loop has no
+ * extra branch. The driver re-scans a failing batch to find the offset.
+ */
+typedef uint32_t (*JsonStage1ValidateKernel)(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    JsonUtf8State* utf8,
+    uint64_t* structurals
+);
+
+/*
+ * UTF-8 error classes (simdjson "lookup" validator, Keiser & Lemire).
+ * Each table classifies one nibble of a byte pair (prev1, input); a pair is
+ * invalid iff the AND of the three lookups is non-zero. TWO_CONTS is then
+ * XOR-ed with "must be the 2nd/3rd continuation" so that continuations are
+ * only allowed where a 3- or 4-byte lead demands them.
+ */
+#define UTF8_TOO_SHORT      (1 << 0)  /* Lead not followed by a continuation */
+#define UTF8_TOO_LONG       (1 << 1)  /* ASCII followed by a continuation */
+#define UTF8_OVERLONG_3     (1 << 2)
+#define UTF8_TOO_LARGE      (1 << 3)  /* Above U+10FFFF */
+#define UTF8_SURROGATE      (1 << 4)  /* U+D800..U+DFFF */
+#define UTF8_OVERLONG_2     (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4     (1 << 6)
+#define UTF8_TWO_CONTS      (1 << 7)
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+/* Indexed by prev1 >> 4 */
+static const uint8_t JSON_UTF8_BYTE_1_HIGH[16] = {
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+
+/* Indexed by prev1 & 0x0F */
+static const uint8_t JSON_UTF8_BYTE_1_LOW[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+};
+
+/* Indexed by input >> 4 */
+static const uint8_t JSON_UTF8_BYTE_2_HIGH[16] = {
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+        UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+/* Scalar form of the lookup check for one byte, given the 3 bytes before it */
+static inline uint8_t json_utf8_check_byte(uint8_t prev3, uint8_t prev2, uint8_t prev1,
+                                           uint8_t input) {
+    uint8_t special = JSON_UTF8_BYTE_1_HIGH[prev1 >> 4] &
+                      JSON_UTF8_BYTE_1_LOW[prev1 & 0x0F] &
+                      JSON_UTF8_BYTE_2_HIGH[input >> 4];
+    uint8_t must23 = (prev2 >= 0xE0 || prev3 >= 0xF0) ? 0x80 : 0;
+    return special ^ must23;
+}
+
+/* String-interior mask for a block, as used by json_finish_block */
+static inline uint64_t json_string_mask(const JsonStage1State* state, uint64_t quote_xor) {
+    return quote_xor ^ state->prev_in_string;
+}
+
+/* =============================================================================
+ * String Escapes (neon_json_tape.c, neon_json_write.c)
+ * ============================================================================= */
+
+static inline int json_is_hex(uint8_t c) {
+    return (uint8_t)(c - '0') <= 9 || (uint8_t)((c | 0x20) - 'a') <= 5;
+}
+
+/**
+ * Check that every backslash in string content starts a JSON escape:
+ * \" \\ \/ \b \f \n \r \t, or \u followed by 4 hex digits.
+ *
+ * @param backslash  First backslash of the content (memchr result), or
+ *                   NULL for a string without escapes
+ * @param end        One past the last content byte (the closing quote)
+ * @return 1 if all escapes are valid, 0 otherwise
+ */
+static inline int json_escapes_valid(const uint8_t* backslash, const uint8_t* end) {
+    const uint8_t* p = backslash;
+    while (p) {
+        /* Stage 1 never ends a string on a lone backslash, but stay in bounds */
+        if (end - p < 2) return 0;
+        uint8_t c = p[1];
+        if (c == 'u') {
+            if (end - p < 6 || !json_is_hex(p[2]) || !json_is_hex(p[3]) ||
+                !json_is_hex(p[4]) || !json_is_hex(p[5])) {
+                return 0;
+            }
+            p += 6;
+        } else if (c == '"' || c == '\\' || c == '/' || c == 'b' ||
+                   c == 'f' || c == 'n' || c == 'r' || c == 't') {
+            p += 2;
+        } else {
+            return 0;
+        }
+        p = memchr(p, '\\', (size_t)(end - p));
+    }
+    return 1;
+}
+
+/* =============================================================================
+ * Number Parsing (neon_json_number.c, neon_json_pow5.c)
+ * ============================================================================= */
+
+#define JSON_POW5_MIN_Q   (-342)
+#define JSON_POW5_MAX_Q   308
+#define JSON_POW5_ENTRIES (JSON_POW5_MAX_Q - JSON_POW5_MIN_Q + 1)
+
+/* (high, low) 128-bit 5^q for q in [-342, 308], see neon_json_pow5.c */
+__attribute__((visibility("hidden")))
+extern const uint64_t json_power_of_five_128[JSON_POW5_ENTRIES * 2];
+
+/**
+ * Parse one number at p (neon_json_number.c). Same rules as
+ * json_parse_numbers_batch; on success *stop points just past it.
+ *
+ * @return JSON_NUMBER_INT64, JSON_NUMBER_DOUBLE or JSON_NUMBER_INVALID
+ */
+__attribute__((visibility("hidden")))
+uint8_t json_parse_number(const uint8_t* p, const uint8_t* end,
+                          int64_t* out_i64, double* out_f64, const uint8_t** stop);
+
+/* =============================================================================
+ * Worker Pool (neon_json_pool.c)
+ * ============================================================================= */
+
+typedef struct JsonThreadPool JsonThreadPool;
+
+/* One unit of work; `index` runs over 0..num_tasks-1 */
+typedef void (*JsonPoolTask)(void* arg, size_t index);
+
+/**
+ * Start `num_threads` parked workers (the caller is an extra participant).
+ * @return Pool, or NULL on allocation failure
+ */
+__attribute__((visibility("hidden")))
+JsonThreadPool* json_pool_create(size_t num_threads);
+
+/* Number of worker threads actually started */
+__attribute__((visibility("hidden")))
+size_t json_pool_size(const JsonThreadPool* pool);
+
+/**
+ * Run `num_tasks` tasks on the workers plus the calling thread and wait
+ * for all of them. A NULL pool runs the tasks inline.
+ */
+__attribute__((visibility("hidden")))
+void json_pool_run(JsonThreadPool* pool, JsonPoolTask task, void* arg, size_t num_tasks);
+
+__attribute__((visibility("hidden")))
+void json_pool_destroy(JsonThreadPool* pool);
+
+/* =============================================================================
+ * Context Internals (neon_json.c)
+ * ============================================================================= */
+
+struct NeonContext;
+
+/* Stage 1 kernel selected for a context (neon_json_query.c) */
+__attribute__((visibility("hidden")))
+JsonStage1Kernel json_ctx_kernel(struct NeonContext* ctx);
+
+/* Switch a context to the scalar kernel (backend calibration) */
+__attribute__((visibility("hidden")))
+void json_ctx_force_scalar(struct NeonContext* ctx);
+
+#if defined(__x86_64__) || defined(_M_X64)
+/**
+ * Pick the best x86 kernel via CPUID (neon_json_x86.c).
+ *
+ * @param name  Output: kernel name ("avx512", "avx2")
+ * @return Kernel, or NULL if the CPU has neither AVX2 nor AVX-512BW
+ */
+__attribute__((visibility("hidden")))
+JsonStage1Kernel json_x86_select_kernel(const char** name);
+
+/* Whitespace-skipping variant of json_x86_select_kernel's pick (neon_json_x86.c) */
+__attribute__((visibility("hidden")))
+JsonStage1Kernel json_x86_select_pretty_kernel(void);
+
+/* Validating kernel for this CPU, or NULL without AVX2 (neon_json_x86.c) */
+__attribute__((visibility("hidden")))
+JsonStage1ValidateKernel json_x86_select_validate_kernel(void);
+#endif
+
+#endif /* NEON_JSON_INTERNAL_H */
@@ -0,0 +1,136 @@
+/**
+ * Memory-mapped file ingestion (json_mmap_open)
+ *
+ * Maps a document read-only so Stage 1 (and the Metal no-copy buffer) can
+ * read it in place, without the read() + copy into a padded string.
+ *
+ * SIMD kernels may read up to 64 bytes past the end of their input. A file
+ * mapping only guarantees readable memory up to the end of its last page,
+ * and touching the page after that raises SIGBUS. The whole range is
+ * therefore first reserved as anonymous zero pages (file size rounded up
+ * to a page, plus one more page if fewer than 64 bytes remain), and the
+ * file is then mapped over the start with MAP_FIXED. Bytes past EOF always
+ * read as zero.
+ */
+
+#include "neon_json.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Transparent huge page size (Linux x86-64 / ARM64 with 4 KB pages) */
+#define JSON_HUGE_PAGE (2u * 1024 * 1024)
+
+struct JsonMappedFile {
+    uint8_t* base;      /* Page-aligned start of the mapping */
+    size_t size;        /* File size */
+    size_t mapped;      /* Mapped length: size + padding, page-rounded */
+};
+
+static inline size_t round_up(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+/*
+ * Reserve `length` bytes of anonymous read-only zero pages. With `align`
+ * above the page size the start is aligned to it (for huge pages) by
+ * over-reserving and trimming both ends.
+ */
+static uint8_t* reserve_region(size_t length, size_t align, size_t page) {
+    size_t extra = align > page ? align : 0;
+    void* raw = mmap(NULL, length + extra, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    if (extra == 0) return raw;
+
+    uint8_t* start = raw;
+    uint8_t* base = (uint8_t*)round_up((uintptr_t)start, align);
+    size_t head = (size_t)(base - start);
+    if (head > 0) munmap(start, head);
+    if (extra - head > 0) munmap(base + length, extra - head);
+    return base;
+}
+
+JsonMappedFile* json_mmap_open(const char* path) {
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+
+    JsonMappedFile* file = malloc(sizeof(JsonMappedFile));
+    if (!file) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = (size_t)st.st_size;
+    size_t mapped = round_up(size, page);
+    if (mapped - size < JSON_MMAP_PADDING) mapped += page;
+
+    int huge = 0;
+#ifdef MADV_HUGEPAGE
+    huge = size >= JSON_HUGE_PAGE;
+#endif
+
+    uint8_t* base = reserve_region(mapped, huge ? JSON_HUGE_PAGE : page, page);
+    if (!base) {
+        free(file);
+        close(fd);
+        return NULL;
+    }
+
+    /* File pages over the start of the reservation; the padding stays anonymous */
+    if (size > 0 &&
+        mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapped);
+        free(file);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+
+    /* Advisory only: failures (e.g. no THP for this filesystem) are ignored */
+    if (size > 0) {
+        madvise(base, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+        if (huge) madvise(base, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    file->base = base;
+    file->size = size;
+    file->mapped = mapped;
+    return file;
+}
+
+const uint8_t* json_mmap_data(const JsonMappedFile* file) {
+    return file ? file->base : NULL;
+}
+
+size_t json_mmap_size(const JsonMappedFile* file) {
+    return file ? file->size : 0;
+}
+
+size_t json_mmap_mapped_length(const JsonMappedFile* file) {
+    return file ? file->mapped : 0;
+}
+
+void json_mmap_close(JsonMappedFile* file) {
+    if (file) {
+        munmap(file->base, file->mapped);
+        free(file);
+    }
+}
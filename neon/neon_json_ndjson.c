@@ -0,0 +1,180 @@
+/**
+ * NDJSON prefilter (json_ndjson_prefilter)
+ *
+ * Finds the lines that contain every one of a few literal byte strings
+ * (a key such as "\"level\":" and a value such as "\"error\""), so only
+ * those lines reach the full parser.
+ *
+ * The longest needle is the anchor. Its first and last bytes are
+ * broadcast and compared against 64 bytes of input at a time (at offset
+ * 0 and at offset len - 1); only positions where both match are
+ * confirmed with memcmp. Lines are never split up front: after an anchor
+ * hit the enclosing line is located, the remaining needles are searched
+ * within it, and the scan resumes after its newline. With a selective
+ * anchor almost all input is touched only by the block compare.
+ *
+ * Line spans use the rules of find_line_boundaries_simd in
+ * src/ndjson.mojo: split on '\n', trim ' ', '\t' and '\r' at both ends,
+ * drop empty lines.
+ */
+
+#include "neon_json.h"
+#include <string.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NEON_JSON_HAVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Candidate mask for the 16 window starts at p: bit set where p[i] equals
+ * the needle's first byte and p[i + last] its last byte.
+ */
+#if defined(NEON_JSON_HAVE_NEON)
+/* 4 bits per position (vshrn narrowing): shift by 2, clear the nibble */
+#define CANDIDATE_SHIFT 2
+#define CLEAR_CANDIDATE(m) ((m) & ~(0xFULL << (__builtin_ctzll(m) & ~3)))
+static inline uint64_t candidates_16(const uint8_t* p, size_t last,
+                                     uint8x16_t first_byte, uint8x16_t last_byte) {
+    uint8x16_t hit = vandq_u8(vceqq_u8(vld1q_u8(p), first_byte),
+                              vceqq_u8(vld1q_u8(p + last), last_byte));
+    return vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+}
+#elif defined(__SSE2__)
+#define CANDIDATE_SHIFT 0
+#define CLEAR_CANDIDATE(m) ((m) & ((m) - 1))
+static inline uint64_t candidates_16(const uint8_t* p, size_t last,
+                                     __m128i first_byte, __m128i last_byte) {
+    __m128i hit = _mm_and_si128(
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), first_byte),
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + last)), last_byte));
+    return (uint64_t)_mm_movemask_epi8(hit);
+}
+#endif
+
+/* Offset of the first occurrence of needle in hay, or hay_len if none */
+static size_t find_needle(const uint8_t* hay, size_t hay_len,
+                          const uint8_t* needle, size_t len) {
+    if (len == 0) return 0;
+    if (len > hay_len) return hay_len;
+
+    size_t last = len - 1;
+    size_t i = 0;
+
+#if defined(NEON_JSON_HAVE_NEON) || defined(__SSE2__)
+#if defined(NEON_JSON_HAVE_NEON)
+    uint8x16_t first_byte = vdupq_n_u8(needle[0]);
+    uint8x16_t last_byte = vdupq_n_u8(needle[last]);
+#else
+    __m128i first_byte = _mm_set1_epi8((char)needle[0]);
+    __m128i last_byte = _mm_set1_epi8((char)needle[last]);
+#endif
+
+    /* 64 window starts per step; both loads stay inside hay */
+    while (i + 64 + last <= hay_len) {
+        const uint8_t* p = hay + i;
+        uint64_t m[4];
+        m[0] = candidates_16(p, last, first_byte, last_byte);
+        m[1] = candidates_16(p + 16, last, first_byte, last_byte);
+        m[2] = candidates_16(p + 32, last, first_byte, last_byte);
+        m[3] = candidates_16(p + 48, last, first_byte, last_byte);
+
+        if ((m[0] | m[1] | m[2] | m[3]) != 0) {
+            for (int k = 0; k < 4; k++) {
+                uint64_t mask = m[k];
+                while (mask) {
+                    size_t at = i + (size_t)k * 16 +
+                                ((size_t)__builtin_ctzll(mask) >> CANDIDATE_SHIFT);
+                    if (memcmp(hay + at + 1, needle + 1, last) == 0) return at;
+                    mask = CLEAR_CANDIDATE(mask);
+                }
+            }
+        }
+        i += 64;
+    }
+#endif
+
+    for (; i + len <= hay_len; i++) {
+        if (hay[i] == needle[0] && hay[i + last] == needle[last] &&
+            memcmp(hay + i + 1, needle + 1, last) == 0) {
+            return i;
+        }
+    }
+    return hay_len;
+}
+
+static inline int is_line_ws(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+int64_t json_ndjson_prefilter(
+    const uint8_t* input,
+    size_t input_len,
+    const uint8_t* const* needles,
+    const size_t* needle_lens,
+    size_t n_needles,
+    uint64_t* line_spans,
+    size_t max_lines,
+    size_t* resume
+) {
+    if ((!input && input_len > 0) || (n_needles > 0 && (!needles || !needle_lens)) ||
+        (!line_spans && max_lines > 0) || !resume) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    /* Anchor on the longest needle: usually the rarest */
+    size_t anchor = 0;
+    for (size_t k = 1; k < n_needles; k++) {
+        if (needle_lens[k] > needle_lens[anchor]) anchor = k;
+    }
+    size_t anchor_len = n_needles > 0 ? needle_lens[anchor] : 0;
+
+    size_t count = 0;
+    size_t pos = *resume;   /* Always the start of a line */
+
+    while (pos < input_len) {
+        size_t hit = pos;
+        if (anchor_len > 0) {
+            hit = pos + find_needle(input + pos, input_len - pos,
+                                    needles[anchor], anchor_len);
+            if (hit >= input_len) {
+                pos = input_len;
+                break;
+            }
+        }
+
+        /* Enclosing line: back to the previous newline, on to the next */
+        size_t line_start = hit;
+        while (line_start > pos && input[line_start - 1] != '\n') line_start--;
+        const uint8_t* nl = memchr(input + hit, '\n', input_len - hit);
+        size_t line_end = nl ? (size_t)(nl - input) : input_len;
+
+        size_t start = line_start;
+        size_t end = line_end;
+        while (start < end && is_line_ws(input[start])) start++;
+        while (end > start && is_line_ws(input[end - 1])) end--;
+
+        int match = end > start;
+        for (size_t k = 0; k < n_needles && match; k++) {
+            match = find_needle(input + start, end - start, needles[k], needle_lens[k]) <
+                    end - start;
+        }
+
+        if (match) {
+            if (count == max_lines) {
+                pos = line_start;   /* Resume at this line */
+                break;
+            }
+            line_spans[2 * count] = start;
+            line_spans[2 * count + 1] = end;
+            count++;
+        }
+        pos = line_end + 1;
+    }
+
+    *resume = pos < input_len ? pos : input_len;
+    return (int64_t)count;
+}
@@ -0,0 +1,503 @@
+/**
+ * Work-stealing parallel NDJSON parsing (json_ndjson_open / json_ndjson_next)
+ *
+ * The input is cut at newline boundaries into tasks of about task_bytes
+ * (256 KB by default). Each task parses its lines with
+ * neon_json_find_structural + json_build_tape into the buffers of one
+ * ring slot, and the consumer takes the slots back in task order.
+ *
+ * Memory is bounded by the ring: task k needs slot k % ring_slots, which
+ * is only handed out again once the consumer is done with task
+ * k - ring_slots. Tasks are therefore admitted in order, a window at a
+ * time, and dealt round-robin onto per-worker deques. A worker pops the
+ * oldest task of its own deque and, when that is empty, steals the
+ * oldest task of any other deque, so one huge line holds up its worker
+ * but not the tasks queued behind it. Slot buffers are grown on demand
+ * and kept, so RSS stops growing once every slot has seen its largest
+ * task, however large the file.
+ *
+ * Locking: one mutex per deque for pops and steals; `lock` guards the
+ * slot states and the admission counters and pairs with the condition
+ * variables.
+ */
+
+#include "neon_json.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Tasks in flight per worker */
+#define RING_SLOTS_PER_WORKER 2
+
+typedef enum {
+    SLOT_FREE,        /* Not admitted, or released by the consumer */
+    SLOT_QUEUED,      /* Admitted: waiting in a deque or being parsed */
+    SLOT_READY        /* Parsed, waiting for the consumer */
+} SlotState;
+
+/* Output of one task; buffers are reused by every task in this slot */
+typedef struct {
+    SlotState state;
+    uint64_t task;
+    size_t start;               /* Task byte range [start, end) */
+    size_t end;
+    int64_t error;              /* Allocation failure while parsing */
+
+    JsonNdjsonRecord* records;
+    size_t num_records;
+    size_t records_capacity;
+    uint64_t* tape;
+    size_t tape_used;
+    size_t tape_capacity;
+    uint8_t* strings;
+    size_t strings_used;
+    size_t strings_capacity;
+} RingSlot;
+
+/* Circular deque of task numbers, oldest at head */
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t* tasks;
+    size_t head;
+    size_t count;
+} TaskDeque;
+
+typedef struct {
+    JsonNdjsonParser* parser;
+    size_t id;
+    pthread_t thread;
+    uint32_t* positions;        /* Stage 1 scratch */
+    size_t positions_capacity;
+    uint8_t* characters;
+    size_t characters_capacity;
+} Worker;
+
+struct JsonNdjsonParser {
+    NeonContext* ctx;
+    const uint8_t* input;
+    size_t input_len;
+    size_t task_bytes;
+
+    Worker* workers;
+    size_t num_workers;
+    TaskDeque* deques;
+    RingSlot* slots;
+    size_t num_slots;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;        /* Tasks were queued (or shutdown) */
+    pthread_cond_t ready;       /* A slot became SLOT_READY */
+    size_t queued;              /* Tasks sitting in deques */
+    uint64_t admitted;          /* Tasks handed out so far */
+    size_t split_pos;           /* Start of the next task */
+    uint64_t delivered;         /* Tasks returned by json_ndjson_next */
+    uint64_t records_delivered;
+    int holding;                /* Consumer still holds slot (delivered - 1) */
+    int shutdown;
+};
+
+static inline size_t min_size(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+/* Grow *buf to hold `needed` elements (amortized doubling) */
+static int reserve(void** buf, size_t* capacity, size_t needed, size_t elem) {
+    if (needed <= *capacity) return 0;
+    size_t grown = *capacity ? *capacity : 1024;
+    while (grown < needed) grown *= 2;
+    void* p = realloc(*buf, grown * elem);
+    if (!p) return NEON_JSON_ERR_INVALID;
+    *buf = p;
+    *capacity = grown;
+    return 0;
+}
+
+static inline int is_line_ws(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* =============================================================================
+ * Task Parsing
+ * ============================================================================= */
+
+/* Parse one trimmed line into the slot */
+static int parse_line(JsonNdjsonParser* p, Worker* w, RingSlot* slot,
+                      size_t start, size_t end) {
+    size_t len = end - start;
+    if (reserve((void**)&slot->records, &slot->records_capacity,
+                slot->num_records + 1, sizeof(JsonNdjsonRecord)) != 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    JsonNdjsonRecord* record = &slot->records[slot->num_records++];
+    record->index = slot->num_records - 1;      /* Made global on delivery */
+    record->start = start;
+    record->end = end;
+    record->tape = NULL;
+    record->strings = NULL;
+    record->strings_len = 0;
+
+    if ((uint64_t)len > UINT32_MAX) {
+        record->status = NEON_JSON_ERR_TOO_LARGE;
+        return 0;
+    }
+
+    /* Every structural is one byte, so len entries always suffice */
+    if (reserve((void**)&w->positions, &w->positions_capacity, len, sizeof(uint32_t)) != 0 ||
+        reserve((void**)&w->characters, &w->characters_capacity, len, 1) != 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    int64_t n = neon_json_find_structural(p->ctx, p->input + start, len,
+                                          w->positions, w->characters, len);
+    if (n < 0) {
+        record->status = n;
+        return 0;
+    }
+
+    size_t tape_needed = JSON_TAPE_MAX_ENTRIES((size_t)n);
+    size_t strings_needed = JSON_TAPE_STRING_BOUND((size_t)n);
+    if (reserve((void**)&slot->tape, &slot->tape_capacity,
+                slot->tape_used + tape_needed, sizeof(uint64_t)) != 0 ||
+        reserve((void**)&slot->strings, &slot->strings_capacity,
+                slot->strings_used + strings_needed, 1) != 0) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    size_t strings_len = 0;
+    int64_t entries = json_build_tape(p->input + start, len, w->positions, (size_t)n,
+                                      slot->tape + slot->tape_used, tape_needed,
+                                      slot->strings + slot->strings_used, strings_needed,
+                                      &strings_len);
+    record->status = entries;
+    if (entries > 0) {
+        /* Offsets for now: the buffers may still move */
+        record->tape = (const uint64_t*)(uintptr_t)slot->tape_used;
+        record->strings = (const uint8_t*)(uintptr_t)slot->strings_used;
+        record->strings_len = strings_len;
+        slot->tape_used += (size_t)entries;
+        slot->strings_used += strings_len;
+    }
+    return 0;
+}
+
+static void parse_task(JsonNdjsonParser* p, Worker* w, RingSlot* slot) {
+    slot->num_records = 0;
+    slot->tape_used = 0;
+    slot->strings_used = 0;
+    slot->error = 0;
+
+    /* Lines split and trimmed like find_line_boundaries_simd */
+    size_t pos = slot->start;
+    while (pos < slot->end) {
+        const uint8_t* nl = memchr(p->input + pos, '\n', slot->end - pos);
+        size_t line_end = nl ? (size_t)(nl - p->input) : slot->end;
+
+        size_t start = pos;
+        size_t end = line_end;
+        while (start < end && is_line_ws(p->input[start])) start++;
+        while (end > start && is_line_ws(p->input[end - 1])) end--;
+
+        if (end > start && parse_line(p, w, slot, start, end) != 0) {
+            slot->error = NEON_JSON_ERR_INVALID;
+            return;
+        }
+        pos = line_end + 1;
+    }
+
+    for (size_t i = 0; i < slot->num_records; i++) {
+        JsonNdjsonRecord* record = &slot->records[i];
+        if (record->status > 0) {
+            record->tape = slot->tape + (uintptr_t)record->tape;
+            record->strings = slot->strings + (uintptr_t)record->strings;
+        }
+    }
+}
+
+/* =============================================================================
+ * Scheduling
+ * ============================================================================= */
+
+/* Pop the oldest task of deque d; returns 0 if it was empty */
+static int deque_pop(JsonNdjsonParser* p, size_t d, uint64_t* task) {
+    TaskDeque* q = &p->deques[d];
+    int found = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->count > 0) {
+        *task = q->tasks[q->head];
+        q->head = (q->head + 1) % p->num_slots;
+        q->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return found;
+}
+
+static void deque_push(JsonNdjsonParser* p, size_t d, uint64_t task) {
+    TaskDeque* q = &p->deques[d];
+    pthread_mutex_lock(&q->lock);
+    q->tasks[(q->head + q->count) % p->num_slots] = task;
+    q->count++;
+    pthread_mutex_unlock(&q->lock);
+}
+
+/* Own deque first, then the other deques' oldest tasks */
+static int take_task(JsonNdjsonParser* p, size_t self, uint64_t* task) {
+    if (deque_pop(p, self, task)) return 1;
+
+    /* Steal from the deque whose head is the oldest task: the consumer waits on it */
+    size_t victim = self;
+    uint64_t oldest = UINT64_MAX;
+    for (size_t d = 0; d < p->num_workers; d++) {
+        if (d == self) continue;
+        TaskDeque* q = &p->deques[d];
+        pthread_mutex_lock(&q->lock);
+        if (q->count > 0 && q->tasks[q->head] < oldest) {
+            oldest = q->tasks[q->head];
+            victim = d;
+        }
+        pthread_mutex_unlock(&q->lock);
+    }
+    return victim != self && deque_pop(p, victim, task);
+}
+
+/* Admit tasks while slots are free (called with p->lock held) */
+static void admit_tasks(JsonNdjsonParser* p) {
+    size_t pushed = 0;
+    while (p->split_pos < p->input_len && p->admitted < p->delivered + p->num_slots - p->holding) {
+        size_t start = p->split_pos;
+        size_t end = start + min_size(p->task_bytes, p->input_len - start);
+        if (end < p->input_len) {
+            const uint8_t* nl = memchr(p->input + end, '\n', p->input_len - end);
+            end = nl ? (size_t)(nl - p->input) + 1 : p->input_len;
+        }
+        p->split_pos = end;
+
+        uint64_t task = p->admitted++;
+        RingSlot* slot = &p->slots[task % p->num_slots];
+        slot->state = SLOT_QUEUED;
+        slot->task = task;
+        slot->start = start;
+        slot->end = end;
+
+        deque_push(p, (size_t)(task % p->num_workers), task);
+        pushed++;
+    }
+    if (pushed > 0) {
+        p->queued += pushed;
+        pthread_cond_broadcast(&p->work);
+    }
+}
+
+static void* ndjson_worker(void* arg) {
+    Worker* w = arg;
+    JsonNdjsonParser* p = w->parser;
+
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        while (p->queued == 0 && !p->shutdown) {
+            pthread_cond_wait(&p->work, &p->lock);
+        }
+        int stop = p->shutdown;
+        pthread_mutex_unlock(&p->lock);
+        if (stop) break;
+
+        uint64_t task;
+        if (!take_task(p, w->id, &task)) continue;   /* Another worker got it */
+
+        pthread_mutex_lock(&p->lock);
+        p->queued--;
+        pthread_mutex_unlock(&p->lock);
+
+        RingSlot* slot = &p->slots[task % p->num_slots];
+        parse_task(p, w, slot);
+
+        pthread_mutex_lock(&p->lock);
+        slot->state = SLOT_READY;
+        pthread_cond_broadcast(&p->ready);
+        pthread_mutex_unlock(&p->lock);
+    }
+    return NULL;
+}
+
+/* =============================================================================
+ * Public API
+ * ============================================================================= */
+
+JsonNdjsonParser* json_ndjson_open(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    size_t num_threads,
+    size_t task_bytes
+) {
+    if (!ctx || (!input && input_len > 0)) return NULL;
+
+    if (num_threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = online > 0 ? (size_t)online : 1;
+    }
+    if (num_threads > JSON_NDJSON_MAX_THREADS) num_threads = JSON_NDJSON_MAX_THREADS;
+
+    JsonNdjsonParser* p = calloc(1, sizeof(JsonNdjsonParser));
+    if (!p) return NULL;
+
+    p->ctx = ctx;
+    p->input = input;
+    p->input_len = input_len;
+    p->task_bytes = task_bytes ? task_bytes : JSON_NDJSON_TASK_BYTES;
+    p->num_slots = num_threads * RING_SLOTS_PER_WORKER;
+
+    p->workers = calloc(num_threads, sizeof(Worker));
+    p->deques = calloc(num_threads, sizeof(TaskDeque));
+    p->slots = calloc(p->num_slots, sizeof(RingSlot));
+    if (!p->workers || !p->deques || !p->slots) {
+        free(p->workers);
+        free(p->deques);
+        free(p->slots);
+        free(p);
+        return NULL;
+    }
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->work, NULL);
+    pthread_cond_init(&p->ready, NULL);
+
+    /* Each deque can hold the whole window */
+    for (size_t d = 0; d < num_threads; d++) {
+        pthread_mutex_init(&p->deques[d].lock, NULL);
+        p->deques[d].tasks = malloc(p->num_slots * sizeof(uint64_t));
+        if (!p->deques[d].tasks) {
+            p->num_workers = num_threads;   /* So close frees every deque */
+            json_ndjson_close(p);
+            return NULL;
+        }
+    }
+    p->num_workers = num_threads;
+
+    pthread_mutex_lock(&p->lock);
+    admit_tasks(p);
+    pthread_mutex_unlock(&p->lock);
+
+    size_t started = 0;
+    for (size_t i = 0; i < num_threads; i++) {
+        p->workers[i].parser = p;
+        p->workers[i].id = i;
+        if (pthread_create(&p->workers[i].thread, NULL, ndjson_worker, &p->workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    for (size_t i = started; i < num_threads; i++) p->workers[i].parser = NULL;
+    if (started == 0) {
+        json_ndjson_close(p);
+        return NULL;
+    }
+    /* With fewer threads than deques the running workers steal the rest */
+    return p;
+}
+
+int64_t json_ndjson_next(JsonNdjsonParser* p, const JsonNdjsonRecord** records) {
+    if (!p || !records) return NEON_JSON_ERR_INVALID;
+    *records = NULL;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        /* Release the previous task's slot and refill the window */
+        if (p->holding) {
+            p->slots[(p->delivered - 1) % p->num_slots].state = SLOT_FREE;
+            p->holding = 0;
+            admit_tasks(p);
+        }
+
+        /* Nothing in flight and nothing left to split: done */
+        if (p->delivered == p->admitted) {
+            pthread_mutex_unlock(&p->lock);
+            return 0;
+        }
+
+        RingSlot* slot = &p->slots[p->delivered % p->num_slots];
+        while (slot->state != SLOT_READY) {
+            pthread_cond_wait(&p->ready, &p->lock);
+        }
+        p->delivered++;
+        p->holding = 1;
+
+        /* Tasks of blank lines only are skipped */
+        if (slot->error == 0 && slot->num_records == 0) continue;
+        pthread_mutex_unlock(&p->lock);
+
+        if (slot->error != 0) return slot->error;
+
+        for (size_t i = 0; i < slot->num_records; i++) {
+            slot->records[i].index = p->records_delivered + i;
+        }
+        p->records_delivered += slot->num_records;
+        *records = slot->records;
+        return (int64_t)slot->num_records;
+    }
+}
+
+void json_ndjson_close(JsonNdjsonParser* p) {
+    if (!p) return;
+
+    pthread_mutex_lock(&p->lock);
+    p->shutdown = 1;
+    pthread_cond_broadcast(&p->work);
+    pthread_mutex_unlock(&p->lock);
+
+    for (size_t i = 0; i < p->num_workers; i++) {
+        Worker* w = &p->workers[i];
+        if (w->parser) pthread_join(w->thread, NULL);
+        free(w->positions);
+        free(w->characters);
+    }
+    for (size_t d = 0; d < p->num_workers; d++) {
+        pthread_mutex_destroy(&p->deques[d].lock);
+        free(p->deques[d].tasks);
+    }
+    for (size_t s = 0; s < p->num_slots; s++) {
+        free(p->slots[s].records);
+        free(p->slots[s].tape);
+        free(p->slots[s].strings);
+    }
+
+    pthread_cond_destroy(&p->ready);
+    pthread_cond_destroy(&p->work);
+    pthread_mutex_destroy(&p->lock);
+    free(p->workers);
+    free(p->deques);
+    free(p->slots);
+    free(p);
+}
+
+int64_t json_ndjson_parse_parallel(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    size_t num_threads,
+    size_t task_bytes,
+    JsonNdjsonConsumer consumer,
+    void* user
+) {
+    if (!consumer) return NEON_JSON_ERR_INVALID;
+
+    JsonNdjsonParser* p = json_ndjson_open(ctx, input, input_len, num_threads, task_bytes);
+    if (!p) return NEON_JSON_ERR_INVALID;
+
+    int64_t total = 0;
+    for (;;) {
+        const JsonNdjsonRecord* records;
+        int64_t n = json_ndjson_next(p, &records);
+        if (n <= 0) {
+            if (n < 0) total = n;
+            break;
+        }
+        total += n;
+        if (consumer(user, records, (size_t)n) != 0) break;
+    }
+
+    json_ndjson_close(p);
+    return total;
+}
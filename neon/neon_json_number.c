@@ -0,0 +1,330 @@
+/**
+ * Batch number parsing (json_parse_numbers_batch)
+ *
+ * Parses every number whose first byte is listed in `positions` in one
+ * tight loop, so numeric-heavy documents (numbers_1mb.json, canada.json)
+ * are not bounded by the per-value dispatch of the Mojo tape parser.
+ *
+ * Per number:
+ * - Digit runs are measured 16 bytes at a time (NEON / SSE2 compare and
+ *   mask) and converted 8 digits per multiply-shift step (SWAR)
+ * - Doubles with <= 19 significant digits take Clinger's exact fast path
+ *   for small exponents, otherwise Eisel-Lemire with a 128-bit table of
+ *   powers of five (neon_json_pow5.c)
+ * - The rare inputs neither can round correctly (> 19 significant digits,
+ *   or an ambiguous Eisel-Lemire product) fall back to strtod, which is
+ *   exact on the supported C libraries
+ */
+
+#include "neon_json.h"
+#include "neon_json_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NEON_JSON_HAVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Longest number copied to the stack for the strtod fallback */
+#define FALLBACK_STACK_DIGITS 128
+
+/* Exactly representable powers of ten for Clinger's fast path */
+static const double EXACT_POWERS_OF_TEN[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Number of consecutive ASCII digits in [p, end) */
+static inline size_t count_digits(const uint8_t* p, const uint8_t* end) {
+    const uint8_t* start = p;
+
+#if defined(NEON_JSON_HAVE_NEON)
+    while (end - p >= 16) {
+        uint8x16_t d = vsubq_u8(vld1q_u8(p), vdupq_n_u8('0'));
+        uint8x16_t non_digit = vcgtq_u8(d, vdupq_n_u8(9));
+        /* vshrn narrows 16 compare bytes to 4 bits each in one 64-bit lane */
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(non_digit), 4)), 0);
+        if (mask) return (size_t)(p - start) + (size_t)(__builtin_ctzll(mask) >> 2);
+        p += 16;
+    }
+#elif defined(__SSE2__)
+    while (end - p >= 16) {
+        __m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8('0'));
+        __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+        unsigned non_digit = ~(unsigned)_mm_movemask_epi8(digit) & 0xFFFF;
+        if (non_digit) return (size_t)(p - start) + (size_t)__builtin_ctz(non_digit);
+        p += 16;
+    }
+#endif
+
+    while (p < end && (uint8_t)(*p - '0') <= 9) p++;
+    return (size_t)(p - start);
+}
+
+/* Value of 8 ASCII digits (little-endian SWAR, 3 multiplies) */
+static inline uint64_t parse_eight_digits(const uint8_t* p) {
+    uint64_t val;
+    memcpy(&val, p, sizeof(val));
+    val = (val & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    val = (val & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return (val & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+}
+
+/* Append `n` known digits to `value` (wraps past 19 digits; callers check) */
+static inline uint64_t accumulate_digits(uint64_t value, const uint8_t* p, size_t n) {
+    while (n >= 8) {
+        value = value * 100000000ULL + parse_eight_digits(p);
+        p += 8;
+        n -= 8;
+    }
+    while (n > 0) {
+        value = value * 10 + (uint64_t)(*p - '0');
+        p++;
+        n--;
+    }
+    return value;
+}
+
+static inline double make_double(uint64_t mantissa, int power2, int negative) {
+    uint64_t bits = mantissa | ((uint64_t)power2 << 52) | ((uint64_t)negative << 63);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+/**
+ * Eisel-Lemire: w * 10^q rounded to nearest double, from the 128-bit
+ * product of w with the truncated 5^q (Lemire, "Number Parsing at a
+ * Gigabyte per Second", as implemented in fast_float).
+ *
+ * @return 1 on success, 0 if the truncated product cannot decide the
+ *         rounding (the caller falls back to an exact parse)
+ */
+static int eisel_lemire(int64_t q, uint64_t w, int negative, double* out) {
+    if (w == 0 || q < JSON_POW5_MIN_Q) {
+        *out = make_double(0, 0, negative);
+        return 1;
+    }
+    if (q > JSON_POW5_MAX_Q) {
+        *out = make_double(0, 0x7FF, negative);
+        return 1;
+    }
+
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    /* 55 bits of precision are enough unless the low bits are all ones */
+    const uint64_t* pow5 = &json_power_of_five_128[(q - JSON_POW5_MIN_Q) * 2];
+    __uint128_t first = (__uint128_t)w * pow5[0];
+    uint64_t high = (uint64_t)(first >> 64);
+    uint64_t low = (uint64_t)first;
+    const uint64_t precision_mask = 0xFFFFFFFFFFFFFFFFULL >> 55;
+    if ((high & precision_mask) == precision_mask) {
+        __uint128_t second = (__uint128_t)w * pow5[1];
+        uint64_t second_high = (uint64_t)(second >> 64);
+        low += second_high;
+        if (second_high > low) high++;
+
+        /* Still ambiguous: only provably exact inside 5^q < 2^64 */
+        if (low == 0xFFFFFFFFFFFFFFFFULL && (q < -27 || q > 55)) return 0;
+    }
+
+    int upperbit = (int)(high >> 63);
+    uint64_t mantissa = high >> (upperbit + 9);
+    int power2 = (int)((((152170 + 65536) * q) >> 16) + 63) + upperbit - lz + 1023;
+
+    if (power2 <= 0) {
+        /* Subnormal */
+        if (-power2 + 1 >= 64) {
+            *out = make_double(0, 0, negative);
+            return 1;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < (1ULL << 52) ? 0 : 1;
+        *out = make_double(mantissa & ((1ULL << 52) - 1), power2, negative);
+        return 1;
+    }
+
+    /* Exactly halfway between two doubles: round to even */
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+        (mantissa << (upperbit + 9)) == high) {
+        mantissa &= ~1ULL;
+    }
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ULL << 52)) {
+        mantissa = 1ULL << 52;
+        power2++;
+    }
+    mantissa &= ~(1ULL << 52);
+
+    if (power2 >= 0x7FF) {
+        *out = make_double(0, 0x7FF, negative);
+        return 1;
+    }
+    *out = make_double(mantissa, power2, negative);
+    return 1;
+}
+
+/* Exact conversion of the already validated text [start, end) */
+static double parse_fallback(const uint8_t* start, const uint8_t* end) {
+    size_t len = (size_t)(end - start);
+    char stack[FALLBACK_STACK_DIGITS + 1];
+    char* buf = len <= FALLBACK_STACK_DIGITS ? stack : malloc(len + 1);
+    if (!buf) return 0.0;
+
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    double value = strtod(buf, NULL);
+
+    if (buf != stack) free(buf);
+    return value;
+}
+
+/* Bytes that may follow a number */
+static inline int is_number_end(uint8_t ch) {
+    return ch == ',' || ch == ']' || ch == '}' || ch == ' ' ||
+           ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+/* Parse the number at p; returns JSON_NUMBER_* and sets *stop past the number */
+static inline uint8_t parse_number(const uint8_t* p, const uint8_t* end,
+                                   int64_t* out_i64, double* out_f64,
+                                   const uint8_t** stop) {
+    const uint8_t* start = p;
+    int negative = *p == '-';
+    p += negative;
+
+    /* Integer part: 0 or [1-9][0-9]* */
+    const uint8_t* int_start = p;
+    size_t int_digits = count_digits(p, end);
+    if (int_digits == 0 || (int_digits > 1 && *p == '0')) return JSON_NUMBER_INVALID;
+    uint64_t mantissa = accumulate_digits(0, p, int_digits);
+    p += int_digits;
+
+    size_t digits = int_digits;
+    int64_t exponent = 0;
+    int is_double = 0;
+
+    if (p < end && *p == '.') {
+        p++;
+        size_t frac_digits = count_digits(p, end);
+        if (frac_digits == 0) return JSON_NUMBER_INVALID;
+        mantissa = accumulate_digits(mantissa, p, frac_digits);
+        p += frac_digits;
+        digits += frac_digits;
+        exponent = -(int64_t)frac_digits;
+        is_double = 1;
+    }
+    const uint8_t* digits_end = p;
+
+    if (p < end && (*p | 0x20) == 'e') {
+        p++;
+        int exp_negative = 0;
+        if (p < end && (*p == '-' || *p == '+')) {
+            exp_negative = *p == '-';
+            p++;
+        }
+        size_t exp_digits = count_digits(p, end);
+        if (exp_digits == 0) return JSON_NUMBER_INVALID;
+
+        /* Saturate: anything this large is 0 or infinity already */
+        int64_t exp_value = 0;
+        for (size_t k = 0; k < exp_digits; k++) {
+            if (exp_value < 0x10000) exp_value = exp_value * 10 + (p[k] - '0');
+        }
+        p += exp_digits;
+        exponent += exp_negative ? -exp_value : exp_value;
+        is_double = 1;
+    }
+
+    if (p < end && !is_number_end(*p)) return JSON_NUMBER_INVALID;
+    *stop = p;
+
+    /* Leading zeros (0.000123) do not count towards the 19-digit limit */
+    if (digits > 19) {
+        for (const uint8_t* s = int_start; s < digits_end && (*s == '0' || *s == '.'); s++) {
+            if (*s == '0') digits--;
+        }
+    }
+
+    if (!is_double) {
+        if (digits <= 19 && mantissa <= (uint64_t)INT64_MAX + (uint64_t)negative) {
+            *out_i64 = negative ? (int64_t)(0 - mantissa) : (int64_t)mantissa;
+            *out_f64 = (double)*out_i64;
+            return JSON_NUMBER_INT64;
+        }
+        /* Out of int64 range: like other JSON parsers, keep it as a double */
+        *out_i64 = 0;
+        if (digits <= 19) {
+            *out_f64 = negative ? -(double)mantissa : (double)mantissa;
+        } else {
+            *out_f64 = parse_fallback(start, p);
+        }
+        return JSON_NUMBER_DOUBLE;
+    }
+
+    *out_i64 = 0;
+    if (digits > 19) {
+        *out_f64 = parse_fallback(start, p);
+        return JSON_NUMBER_DOUBLE;
+    }
+
+    /* Clinger: both operands exact, so one IEEE operation rounds correctly */
+    if (exponent >= -22 && exponent <= 22 && mantissa <= (1ULL << 53)) {
+        double value = (double)mantissa;
+        value = exponent < 0 ? value / EXACT_POWERS_OF_TEN[-exponent]
+                             : value * EXACT_POWERS_OF_TEN[exponent];
+        *out_f64 = negative ? -value : value;
+        return JSON_NUMBER_DOUBLE;
+    }
+
+    if (!eisel_lemire(exponent, mantissa, negative, out_f64)) {
+        *out_f64 = parse_fallback(start, p);
+    }
+    return JSON_NUMBER_DOUBLE;
+}
+
+int64_t json_parse_numbers_batch(
+    const uint8_t* input,
+    size_t input_len,
+    const uint32_t* positions,
+    size_t n,
+    int64_t* out_i64,
+    double* out_f64,
+    uint8_t* out_kind
+) {
+    if (!input || (n > 0 && (!positions || !out_i64 || !out_f64 || !out_kind))) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    const uint8_t* end = input + input_len;
+    int64_t valid = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        uint8_t kind = JSON_NUMBER_INVALID;
+        out_i64[i] = 0;
+        out_f64[i] = 0.0;
+
+        if (positions[i] < input_len) {
+            const uint8_t* stop;
+            kind = parse_number(input + positions[i], end, &out_i64[i], &out_f64[i], &stop);
+        }
+
+        out_kind[i] = kind;
+        valid += kind != JSON_NUMBER_INVALID;
+    }
+    return valid;
+}
+
+uint8_t json_parse_number(const uint8_t* p, const uint8_t* end,
+                          int64_t* out_i64, double* out_f64, const uint8_t** stop) {
+    return parse_number(p, end, out_i64, out_f64, stop);
+}
@@ -0,0 +1,141 @@
+/**
+ * Persistent worker pool for parallel Stage 1 (neon_json_find_structural_parallel)
+ *
+ * Workers are created once per NeonContext and parked on a condition
+ * variable between calls, so repeated calls on small and medium documents
+ * pay a wakeup instead of a pthread_create per thread.
+ *
+ * A run hands out task indices 0..ntasks-1 through an atomic counter; the
+ * calling thread takes tasks too, and returns only once every worker has
+ * left the run (so the next run can safely reuse the job fields).
+ */
+
+#include "neon_json_internal.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+struct JsonThreadPool {
+    pthread_t* threads;
+    size_t num_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;      /* Signalled when a new run is published */
+    pthread_cond_t done;       /* Signalled when the last worker finishes */
+
+    /* Current run (written under lock, read by workers after wakeup) */
+    JsonPoolTask task;
+    void* arg;
+    size_t num_tasks;
+    size_t next_task;          /* Atomic task counter */
+    size_t active;             /* Workers still inside the current run */
+    uint64_t generation;
+    int shutdown;
+};
+
+static void pool_drain(JsonThreadPool* pool, JsonPoolTask task, void* arg, size_t num_tasks) {
+    for (;;) {
+        size_t i = __atomic_fetch_add(&pool->next_task, 1, __ATOMIC_RELAXED);
+        if (i >= num_tasks) break;
+        task(arg, i);
+    }
+}
+
+static void* pool_worker(void* p) {
+    JsonThreadPool* pool = p;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->shutdown) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->shutdown) break;
+
+        seen = pool->generation;
+        JsonPoolTask task = pool->task;
+        void* arg = pool->arg;
+        size_t num_tasks = pool->num_tasks;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_drain(pool, task, arg, num_tasks);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+JsonThreadPool* json_pool_create(size_t num_threads) {
+    JsonThreadPool* pool = calloc(1, sizeof(JsonThreadPool));
+    if (!pool) return NULL;
+
+    pool->threads = calloc(num_threads ? num_threads : 1, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool) != 0) {
+            break;
+        }
+        pool->num_threads++;
+    }
+    return pool;
+}
+
+size_t json_pool_size(const JsonThreadPool* pool) {
+    return pool ? pool->num_threads : 0;
+}
+
+void json_pool_run(JsonThreadPool* pool, JsonPoolTask task, void* arg, size_t num_tasks) {
+    /* Nothing to share: run inline */
+    if (!pool || pool->num_threads == 0 || num_tasks <= 1) {
+        for (size_t i = 0; i < num_tasks; i++) task(arg, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->num_tasks = num_tasks;
+    pool->next_task = 0;
+    pool->active = pool->num_threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_drain(pool, task, arg, num_tasks);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void json_pool_destroy(JsonThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,459 @@
+/**
+ * JSON Pointer queries without a tape (json_query_paths)
+ *
+ * The paths are compiled into a trie of reference tokens (the automaton:
+ * one node per distinct path prefix). The document is then walked once
+ * over the Stage 1 structural bitmaps, classified 1 KB at a time and
+ * consumed bit by bit, so no position index or tape is ever written:
+ *
+ * - A value whose trie node has children is entered and its members
+ *   (keys) or elements (indices) are matched against those children.
+ * - Every other container is skipped by counting brackets in the bitmap;
+ *   strings are skipped via their closing quote.
+ * - Once every path has a span the walk stops, so fields near the start
+ *   of a large body never pay for the rest of it.
+ *
+ * Only containers on a query path are entered, which bounds the
+ * recursion by the longest path (JSON_QUERY_MAX_NODES tokens).
+ */
+
+#include "neon_json.h"
+#include "neon_json_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Blocks classified per refill: small, so an early stop wastes little */
+#define QUERY_BATCH_BLOCKS 16
+
+/* Bytes of decoded path tokens per call */
+#define QUERY_TOKEN_BYTES 4096
+
+/* Keys up to this length are unescaped on the stack */
+#define QUERY_KEY_BUFFER 256
+
+/* One reference token shared by all paths with the same prefix */
+typedef struct {
+    uint32_t token;         /* Decoded token: offset into token_bytes */
+    uint32_t token_len;
+    int64_t index;          /* Token as an array index, -1 if it is not one */
+    int32_t first_child;    /* -1 if no path continues below this node */
+    int32_t next_sibling;
+    int terminal;           /* Some path ends here */
+    int found;
+    JsonSpan span;
+} QueryNode;
+
+typedef struct {
+    const uint8_t* input;
+    size_t input_len;
+    JsonStage1Kernel kernel;
+    JsonStage1State state;
+
+    /* Structural stream: bitmaps of blocks [batch_block, batch_block + batch_n) */
+    uint64_t bitmaps[QUERY_BATCH_BLOCKS];
+    size_t batch_block;
+    size_t batch_n;
+    size_t b;               /* Current block within the batch */
+    uint64_t bits;          /* Structurals of block b not yet consumed */
+    size_t pos;             /* Current structural, input_len past the last */
+    size_t cursor;          /* First byte not yet consumed */
+
+    QueryNode nodes[JSON_QUERY_MAX_NODES];
+    size_t num_nodes;
+    uint8_t token_bytes[QUERY_TOKEN_BYTES];
+    size_t token_used;
+    size_t remaining;       /* Terminal nodes without a span yet */
+} Query;
+
+static inline int is_ws(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline size_t skip_ws(const Query* q, size_t pos) {
+    while (pos < q->input_len && is_ws(q->input[pos])) pos++;
+    return pos;
+}
+
+/* =============================================================================
+ * Path Compilation
+ * ============================================================================= */
+
+/* New node whose decoded token was staged at token_bytes + token_used */
+static int32_t add_node(Query* q, size_t len) {
+    if (q->num_nodes >= JSON_QUERY_MAX_NODES) return -1;
+
+    const uint8_t* token = q->token_bytes + q->token_used;
+    QueryNode* node = &q->nodes[q->num_nodes];
+    node->token = (uint32_t)q->token_used;
+    node->token_len = (uint32_t)len;
+    q->token_used += len;
+
+    /* Array index: "0" or digits without a leading zero */
+    node->index = -1;
+    if (len > 0 && len <= 18 && (token[0] != '0' || len == 1)) {
+        int64_t value = 0;
+        size_t i = 0;
+        while (i < len && (uint8_t)(token[i] - '0') <= 9) {
+            value = value * 10 + (token[i] - '0');
+            i++;
+        }
+        if (i == len) node->index = value;
+    }
+
+    node->first_child = -1;
+    node->next_sibling = -1;
+    node->terminal = 0;
+    node->found = 0;
+    node->span.start = 0;
+    node->span.length = 0;
+    return (int32_t)q->num_nodes++;
+}
+
+/* Child of parent with the staged token, added if missing */
+static int32_t child_node(Query* q, int32_t parent, size_t len) {
+    const uint8_t* token = q->token_bytes + q->token_used;
+    int32_t last = -1;
+    for (int32_t c = q->nodes[parent].first_child; c >= 0; c = q->nodes[c].next_sibling) {
+        const QueryNode* node = &q->nodes[c];
+        if (node->token_len == len && memcmp(q->token_bytes + node->token, token, len) == 0) {
+            return c;
+        }
+        last = c;
+    }
+
+    int32_t c = add_node(q, len);
+    if (c < 0) return -1;
+    if (last < 0) {
+        q->nodes[parent].first_child = c;
+    } else {
+        q->nodes[last].next_sibling = c;
+    }
+    return c;
+}
+
+/*
+ * Add one RFC 6901 pointer ("" is the whole document, "/a/0/~1b" has the
+ * tokens "a", "0" and "/b") and return its node.
+ */
+static int32_t compile_path(Query* q, const char* path, int32_t* status) {
+    const uint8_t* p = (const uint8_t*)path;
+    int32_t node = 0;
+
+    if (*p != '\0' && *p != '/') {
+        *status = NEON_JSON_ERR_INVALID;
+        return -1;
+    }
+
+    while (*p == '/') {
+        /* Decode the token into the free tail of token_bytes */
+        uint8_t* token = q->token_bytes + q->token_used;
+        size_t len = 0;
+        p++;
+        while (*p != '\0' && *p != '/') {
+            uint8_t c = *p++;
+            if (c == '~') {
+                if (*p != '0' && *p != '1') {
+                    *status = NEON_JSON_ERR_INVALID;
+                    return -1;
+                }
+                c = *p++ == '0' ? '~' : '/';
+            }
+            if (len >= QUERY_TOKEN_BYTES - q->token_used) {
+                *status = NEON_JSON_ERR_TOO_LARGE;
+                return -1;
+            }
+            token[len++] = c;
+        }
+
+        node = child_node(q, node, len);
+        if (node < 0) {
+            *status = NEON_JSON_ERR_TOO_LARGE;
+            return -1;
+        }
+    }
+    return node;
+}
+
+/* =============================================================================
+ * Structural Stream
+ * ============================================================================= */
+
+/* Classify the next batch of blocks; returns 0 past the end of input */
+static int refill(Query* q) {
+    size_t full_blocks = q->input_len / 64;
+    size_t block = q->batch_block + q->batch_n;
+    size_t total = full_blocks + (q->input_len % 64 != 0);
+    if (block >= total) return 0;
+
+    q->batch_block = block;
+    q->b = 0;
+    if (block < full_blocks) {
+        size_t n = full_blocks - block;
+        if (n > QUERY_BATCH_BLOCKS) n = QUERY_BATCH_BLOCKS;
+        q->kernel(q->input + block * 64, n, &q->state, q->bitmaps);
+        q->batch_n = n;
+    } else {
+        /* Tail block: space-padded copy, as in neon_json_find_structural */
+        uint8_t padded[64];
+        memset(padded, ' ', sizeof(padded));
+        memcpy(padded, q->input + block * 64, q->input_len - block * 64);
+        q->kernel(padded, 1, &q->state, q->bitmaps);
+        q->batch_n = 1;
+    }
+    q->bits = q->bitmaps[0];
+    return 1;
+}
+
+/* Move to the next structural */
+static inline void advance(Query* q) {
+    while (q->bits == 0) {
+        if (q->b + 1 < q->batch_n) {
+            q->bits = q->bitmaps[++q->b];
+        } else if (!refill(q)) {
+            q->pos = q->input_len;
+            return;
+        }
+    }
+    q->pos = (q->batch_block + q->b) * 64 + (size_t)__builtin_ctzll(q->bits);
+    q->bits &= q->bits - 1;
+}
+
+static inline uint8_t current(const Query* q) {
+    return q->pos < q->input_len ? q->input[q->pos] : 0;
+}
+
+/* Consume the current structural, which must be c */
+static inline int expect(Query* q, uint8_t c) {
+    if (current(q) != c) return NEON_JSON_ERR_INVALID;
+    q->cursor = q->pos + 1;
+    advance(q);
+    return 0;
+}
+
+/* =============================================================================
+ * Evaluation
+ * ============================================================================= */
+
+static inline void record(Query* q, int32_t node, size_t start, size_t end) {
+    QueryNode* n = &q->nodes[node];
+    if (n->terminal && !n->found) {
+        n->found = 1;
+        n->span.start = (uint32_t)start;
+        n->span.length = (uint32_t)(end - start);
+        q->remaining--;
+    }
+}
+
+/* Skip the container opened at the current structural; returns its close */
+static int skip_container(Query* q, size_t* close) {
+    size_t depth = 0;
+    while (q->pos < q->input_len) {
+        uint8_t c = q->input[q->pos];
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                *close = q->pos;
+                q->cursor = q->pos + 1;
+                advance(q);
+                return 0;
+            }
+        }
+        advance(q);
+    }
+    return NEON_JSON_ERR_INVALID;
+}
+
+/*
+ * Child of node matching an object key (raw bytes between the quotes) in
+ * *child, -1 if none. A malformed escape in the key (or a failed
+ * allocation for a long one) is an error, not a mismatch.
+ */
+static int match_key(const Query* q, int32_t node, const uint8_t* key, size_t len,
+                     int32_t* child) {
+    uint8_t buffer[QUERY_KEY_BUFFER];
+    uint8_t* decoded = NULL;
+
+    *child = -1;
+    if (memchr(key, '\\', len)) {
+        decoded = len <= sizeof(buffer) ? buffer : malloc(len);
+        if (!decoded) return NEON_JSON_ERR_INVALID;
+        int64_t n = json_unescape_string(key, len, decoded);
+        if (n < 0) {
+            if (decoded != buffer) free(decoded);
+            return NEON_JSON_ERR_INVALID;
+        }
+        key = decoded;
+        len = (size_t)n;
+    }
+
+    for (int32_t c = q->nodes[node].first_child; c >= 0; c = q->nodes[c].next_sibling) {
+        const QueryNode* n = &q->nodes[c];
+        if (n->token_len == len && memcmp(q->token_bytes + n->token, key, len) == 0) {
+            *child = c;
+            break;
+        }
+    }
+
+    if (decoded && decoded != buffer) free(decoded);
+    return 0;
+}
+
+static int32_t match_index(const Query* q, int32_t node, int64_t index) {
+    for (int32_t c = q->nodes[node].first_child; c >= 0; c = q->nodes[c].next_sibling) {
+        if (q->nodes[c].index == index) return c;
+    }
+    return -1;
+}
+
+static int query_value(Query* q, int32_t node);
+
+/* Members of the object at the current structural */
+static int query_object(Query* q, int32_t node) {
+    int status = expect(q, '{');
+    if (status != 0) return status;
+    if (current(q) == '}') return expect(q, '}');
+
+    for (;;) {
+        if (current(q) != '"') return NEON_JSON_ERR_INVALID;
+        size_t key_start = q->pos + 1;
+        advance(q);
+        if (current(q) != '"') return NEON_JSON_ERR_INVALID;
+        size_t key_end = q->pos;
+        advance(q);
+        status = expect(q, ':');
+        if (status != 0) return status;
+
+        int32_t child;
+        status = match_key(q, node, q->input + key_start, key_end - key_start, &child);
+        if (status != 0) return status;
+        status = query_value(q, child);
+        if (status != 0 || q->remaining == 0) return status;
+
+        if (current(q) == '}') return expect(q, '}');
+        status = expect(q, ',');
+        if (status != 0) return status;
+    }
+}
+
+/* Elements of the array at the current structural */
+static int query_array(Query* q, int32_t node) {
+    int status = expect(q, '[');
+    if (status != 0) return status;
+    if (skip_ws(q, q->cursor) == q->pos && current(q) == ']') return expect(q, ']');
+
+    for (int64_t index = 0;; index++) {
+        status = query_value(q, match_index(q, node, index));
+        if (status != 0 || q->remaining == 0) return status;
+
+        if (current(q) == ']') return expect(q, ']');
+        status = expect(q, ',');
+        if (status != 0) return status;
+    }
+}
+
+/*
+ * Value starting at the cursor. node is its trie node, or -1 if no path
+ * goes through it (then it is only skipped).
+ */
+static int query_value(Query* q, int32_t node) {
+    size_t start = skip_ws(q, q->cursor);
+    if (start >= q->input_len) return NEON_JSON_ERR_INVALID;
+
+    size_t end;
+    if (start == q->pos) {
+        uint8_t c = q->input[start];
+        if (c == '"') {
+            advance(q);
+            if (current(q) != '"') return NEON_JSON_ERR_INVALID;
+            end = q->pos + 1;
+            q->cursor = end;
+            advance(q);
+        } else if (c == '{' || c == '[') {
+            int status;
+            if (node >= 0 && q->nodes[node].first_child >= 0) {
+                status = c == '{' ? query_object(q, node) : query_array(q, node);
+                if (status != 0 || q->remaining == 0) return status;
+                end = q->cursor;
+            } else {
+                size_t close;
+                status = skip_container(q, &close);
+                if (status != 0) return status;
+                end = close + 1;
+            }
+        } else {
+            return NEON_JSON_ERR_INVALID;
+        }
+    } else {
+        /* Scalar: everything up to the next structural, minus whitespace */
+        end = q->pos;
+        while (end > start && is_ws(q->input[end - 1])) end--;
+        q->cursor = q->pos;
+    }
+
+    if (node >= 0) record(q, node, start, end);
+    return 0;
+}
+
+int64_t json_query_paths(
+    NeonContext* ctx,
+    const uint8_t* input,
+    size_t input_len,
+    const char* const* paths,
+    size_t n_paths,
+    JsonSpan* out_spans
+) {
+    if (!ctx || !input || input_len == 0 || (n_paths > 0 && (!paths || !out_spans))) {
+        return NEON_JSON_ERR_INVALID;
+    }
+    if ((uint64_t)input_len > UINT32_MAX || n_paths > JSON_QUERY_MAX_PATHS) {
+        return NEON_JSON_ERR_TOO_LARGE;
+    }
+
+    Query query;
+    Query* q = &query;
+    q->num_nodes = 0;
+    q->token_used = 0;
+    add_node(q, 0);   /* Root: the "" pointer */
+
+    int32_t path_node[JSON_QUERY_MAX_PATHS];
+    for (size_t i = 0; i < n_paths; i++) {
+        int32_t status = 0;
+        path_node[i] = paths[i] ? compile_path(q, paths[i], &status) : -1;
+        if (path_node[i] < 0) {
+            return status != 0 ? status : NEON_JSON_ERR_INVALID;
+        }
+    }
+
+    q->remaining = 0;
+    for (size_t i = 0; i < n_paths; i++) {
+        if (!q->nodes[path_node[i]].terminal) {
+            q->nodes[path_node[i]].terminal = 1;
+            q->remaining++;
+        }
+    }
+
+    q->input = input;
+    q->input_len = input_len;
+    q->kernel = json_ctx_kernel(ctx);
+    q->state.prev_in_string = 0;
+    q->state.prev_escaped = 0;
+    q->state.escape_blocks = 0;
+    q->batch_block = 0;
+    q->batch_n = 0;
+    q->b = 0;
+    q->bits = 0;
+    q->cursor = 0;
+    refill(q);
+    advance(q);
+
+    int status = q->remaining > 0 ? query_value(q, 0) : 0;
+
+    int64_t found = 0;
+    for (size_t i = 0; i < n_paths; i++) {
+        const QueryNode* node = &q->nodes[path_node[i]];
+        out_spans[i] = node->span;
+        found += node->found;
+    }
+    return status != 0 ? status : found;
+}
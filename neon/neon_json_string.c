@@ -0,0 +1,182 @@
+/**
+ * String unescaping (json_unescape_string)
+ *
+ * Copies string content 32 bytes at a time and uses the backslash / quote
+ * compare mask to jump straight to the next escape, so a string with a
+ * few escapes costs about one memcpy. Escapes are decoded in place into
+ * the output, including \uXXXX surrogate pairs, without allocating.
+ *
+ * The output is never longer than the input (\uXXXX is 6 bytes in and at
+ * most 3 out, a surrogate pair 12 in and 4 out), and every vector store
+ * lands at or before the matching input offset, so `dst` needs no
+ * padding beyond `len` bytes.
+ */
+
+#include "neon_json.h"
+#include <string.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NEON_JSON_HAVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Decoded byte for each simple escape, 0 if the escape is invalid */
+static const uint8_t ESCAPE_MAP[256] = {
+    ['"'] = '"', ['\\'] = '\\', ['/'] = '/',
+    ['b'] = '\b', ['f'] = '\f', ['n'] = '\n', ['r'] = '\r', ['t'] = '\t'
+};
+
+/*
+ * Offset of the first backslash or quote in the 16 bytes at p, or 16.
+ */
+#if defined(NEON_JSON_HAVE_NEON)
+static inline size_t find_escape_16(const uint8_t* p) {
+    uint8x16_t v = vld1q_u8(p);
+    uint8x16_t hit = vorrq_u8(vceqq_u8(v, vdupq_n_u8('\\')), vceqq_u8(v, vdupq_n_u8('"')));
+    /* 4 bits per byte, so the first hit is ctz / 4 */
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+    return mask ? (size_t)(__builtin_ctzll(mask) >> 2) : 16;
+}
+#elif defined(__SSE2__)
+static inline size_t find_escape_16(const uint8_t* p) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')),
+                               _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+    return mask ? (size_t)__builtin_ctz(mask) : 16;
+}
+#endif
+
+/* Value of 4 hex digits, or -1 */
+static inline int32_t parse_hex4(const uint8_t* p) {
+    int32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        uint8_t c = p[i];
+        int32_t digit;
+        if ((uint8_t)(c - '0') <= 9) {
+            digit = c - '0';
+        } else if ((uint8_t)((c | 0x20) - 'a') <= 5) {
+            digit = (c | 0x20) - 'a' + 10;
+        } else {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+static inline size_t encode_utf8(uint32_t cp, uint8_t* dst) {
+    if (cp < 0x80) {
+        dst[0] = (uint8_t)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        dst[0] = (uint8_t)(0xC0 | (cp >> 6));
+        dst[1] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        dst[0] = (uint8_t)(0xE0 | (cp >> 12));
+        dst[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = (uint8_t)(0xF0 | (cp >> 18));
+    dst[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (uint8_t)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/**
+ * Decode the \uXXXX escape at src[0] ('\\') into dst.
+ *
+ * @return Input bytes consumed (6 or 12), 0 on a malformed escape or an
+ *         unpaired surrogate
+ */
+static inline size_t decode_unicode(const uint8_t* src, const uint8_t* end,
+                                    uint8_t* dst, size_t* written) {
+    if (end - src < 6) return 0;
+    int32_t unit = parse_hex4(src + 2);
+    if (unit < 0 || (unit >= 0xDC00 && unit < 0xE000)) return 0;
+
+    if (unit < 0xD800 || unit >= 0xE000) {
+        *written = encode_utf8((uint32_t)unit, dst);
+        return 6;
+    }
+
+    /* High surrogate: must be followed by \u + low surrogate */
+    if (end - src < 12 || src[6] != '\\' || src[7] != 'u') return 0;
+    int32_t low = parse_hex4(src + 8);
+    if (low < 0xDC00 || low >= 0xE000) return 0;
+
+    uint32_t cp = 0x10000 + (((uint32_t)unit - 0xD800) << 10) + ((uint32_t)low - 0xDC00);
+    *written = encode_utf8(cp, dst);
+    return 12;
+}
+
+/* Copy bytes up to the next backslash or quote; returns how many were copied */
+static inline size_t copy_until_escape(const uint8_t* src, size_t avail, uint8_t* out) {
+    size_t n = 0;
+
+#if defined(NEON_JSON_HAVE_NEON) || defined(__SSE2__)
+    /* 32 bytes per step: store both vectors, stop at the first hit */
+    while (avail - n >= 32) {
+        size_t a = find_escape_16(src + n);
+        memcpy(out + n, src + n, 16);
+        if (a < 16) return n + a;
+
+        size_t b = find_escape_16(src + n + 16);
+        memcpy(out + n + 16, src + n + 16, 16);
+        if (b < 16) return n + 16 + b;
+        n += 32;
+    }
+    if (avail - n >= 16) {
+        size_t a = find_escape_16(src + n);
+        memcpy(out + n, src + n, 16);
+        if (a < 16) return n + a;
+        n += 16;
+    }
+#endif
+
+    while (n < avail && src[n] != '\\' && src[n] != '"') {
+        out[n] = src[n];
+        n++;
+    }
+    return n;
+}
+
+int64_t json_unescape_string(const uint8_t* src, size_t len, uint8_t* dst) {
+    if ((!src || !dst) && len > 0) return NEON_JSON_ERR_INVALID;
+
+    const uint8_t* end = src + len;
+    uint8_t* out = dst;
+
+    for (;;) {
+        size_t plain = copy_until_escape(src, (size_t)(end - src), out);
+        src += plain;
+        out += plain;
+
+        /* Closing quote or end of input: done */
+        if (src >= end || *src == '"') break;
+
+        if (end - src < 2) return NEON_JSON_ERR_INVALID;
+        if (src[1] == 'u') {
+            size_t written = 0;
+            size_t consumed = decode_unicode(src, end, out, &written);
+            if (consumed == 0) return NEON_JSON_ERR_INVALID;
+            src += consumed;
+            out += written;
+        } else {
+            uint8_t decoded = ESCAPE_MAP[src[1]];
+            if (decoded == 0) return NEON_JSON_ERR_INVALID;
+            *out++ = decoded;
+            src += 2;
+        }
+    }
+
+    return (int64_t)(out - dst);
+}
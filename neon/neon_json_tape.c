@@ -0,0 +1,326 @@
+/**
+ * Native Stage 2: tape construction (json_build_tape)
+ *
+ * Walks the Stage 1 structural index once and writes the same tape as the
+ * Mojo JsonTape (src/tape_parser.mojo), so the result can be adopted
+ * without conversion:
+ *
+ *   entry  = [8-bit tag | 56-bit payload]
+ *   'r'    root, payload = number of entries
+ *   '{' '['  payload = index of the matching close
+ *   '}' ']'  payload = index of the matching open
+ *   '"'    payload = offset of a 9-byte string ref in the string buffer:
+ *          [u32 start LE][u32 length LE][u8 flags], flags bit 0 = escaped
+ *   'l' 'd'  followed by one raw entry (int64 / double bits)
+ *   't' 'f' 'n'  payload 0
+ *
+ * Containers are tracked on an explicit stack, so there is no recursion;
+ * scalars (numbers, literals) are the non-whitespace bytes between two
+ * structurals and are parsed in place with json_parse_number.
+ */
+
+#include "neon_json.h"
+#include "neon_json_internal.h"
+#include <string.h>
+
+#define TAPE_PAYLOAD_MASK 0x00FFFFFFFFFFFFFFULL
+
+/* What the walker expects next */
+typedef enum {
+    EXPECT_VALUE,
+    EXPECT_OBJECT_FIRST,    /* After '{': key or '}' */
+    EXPECT_OBJECT_NEXT,     /* After a member: ',' or '}' */
+    EXPECT_ARRAY_FIRST,     /* After '[': value or ']' */
+    EXPECT_ARRAY_NEXT,      /* After an element: ',' or ']' */
+    EXPECT_END
+} TapeState;
+
+typedef struct {
+    const uint8_t* input;
+    size_t input_len;
+    const uint32_t* positions;
+    size_t n;
+    size_t i;               /* Next structural */
+    size_t cursor;          /* First byte not yet consumed */
+
+    uint64_t* tape;
+    size_t tape_capacity;
+    size_t t;
+
+    uint8_t* strings;
+    size_t strings_capacity;
+    size_t s;
+
+    uint32_t open_index[JSON_TAPE_MAX_DEPTH];   /* Tape index of each open container */
+    uint8_t open_char[JSON_TAPE_MAX_DEPTH];
+    size_t depth;
+} TapeBuilder;
+
+static inline int is_ws(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/* Offset of structural i, or input_len past the last one */
+static inline size_t structural_pos(const TapeBuilder* b, size_t i) {
+    return i < b->n ? b->positions[i] : b->input_len;
+}
+
+static inline size_t skip_ws(const TapeBuilder* b, size_t pos) {
+    while (pos < b->input_len && is_ws(b->input[pos])) pos++;
+    return pos;
+}
+
+static inline int emit(TapeBuilder* b, uint8_t tag, uint64_t payload) {
+    if (b->t >= b->tape_capacity) return NEON_JSON_ERR_OUTPUT_FULL;
+    b->tape[b->t++] = ((uint64_t)tag << 56) | (payload & TAPE_PAYLOAD_MASK);
+    return 0;
+}
+
+static inline int emit_raw(TapeBuilder* b, uint8_t tag, uint64_t raw) {
+    if (b->t + 2 > b->tape_capacity) return NEON_JSON_ERR_OUTPUT_FULL;
+    b->tape[b->t++] = (uint64_t)tag << 56;
+    b->tape[b->t++] = raw;
+    return 0;
+}
+
+static inline void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* String at structural i (opening quote) and i + 1 (closing quote) */
+static int build_string(TapeBuilder* b) {
+    if (b->i + 1 >= b->n || b->input[b->positions[b->i + 1]] != '"') {
+        return NEON_JSON_ERR_INVALID;
+    }
+    size_t start = (size_t)b->positions[b->i] + 1;
+    size_t end = b->positions[b->i + 1];
+    size_t len = end - start;
+
+    /* Escapes are checked here, so the ESCAPED flag promises decodable content */
+    const uint8_t* backslash = memchr(b->input + start, '\\', len);
+    if (!json_escapes_valid(backslash, b->input + end)) return NEON_JSON_ERR_INVALID;
+
+    if (b->s + 9 > b->strings_capacity) return NEON_JSON_ERR_OUTPUT_FULL;
+    uint8_t* ref = b->strings + b->s;
+    put_u32(ref, (uint32_t)start);
+    put_u32(ref + 4, (uint32_t)len);
+    ref[8] = backslash ? JSON_TAPE_STRING_ESCAPED : 0;
+
+    int status = emit(b, JSON_TAPE_STRING, b->s);
+    if (status != 0) return status;
+    b->s += 9;
+    b->i += 2;
+    b->cursor = end + 1;
+    return 0;
+}
+
+/* Number or literal starting at byte pos, which lies before structural i */
+static int build_scalar(TapeBuilder* b, size_t pos) {
+    const uint8_t* p = b->input + pos;
+    const uint8_t* end = b->input + b->input_len;
+    size_t stop_pos;
+    int status;
+
+    if (*p == 't' || *p == 'f' || *p == 'n') {
+        static const char* const LITERALS[3] = { "true", "false", "null" };
+        static const uint8_t TAGS[3] = { JSON_TAPE_TRUE, JSON_TAPE_FALSE, JSON_TAPE_NULL };
+        int k = *p == 't' ? 0 : (*p == 'f' ? 1 : 2);
+        size_t len = strlen(LITERALS[k]);
+        if ((size_t)(end - p) < len || memcmp(p, LITERALS[k], len) != 0) {
+            return NEON_JSON_ERR_INVALID;
+        }
+        status = emit(b, TAGS[k], 0);
+        stop_pos = pos + len;
+    } else {
+        int64_t i64;
+        double f64;
+        const uint8_t* stop = p;
+        uint8_t kind = json_parse_number(p, end, &i64, &f64, &stop);
+        if (kind == JSON_NUMBER_INVALID) return NEON_JSON_ERR_INVALID;
+
+        uint64_t raw;
+        if (kind == JSON_NUMBER_INT64) {
+            raw = (uint64_t)i64;
+        } else {
+            memcpy(&raw, &f64, sizeof(raw));
+        }
+        status = emit_raw(b, kind == JSON_NUMBER_INT64 ? JSON_TAPE_INT64 : JSON_TAPE_DOUBLE, raw);
+        stop_pos = (size_t)(stop - b->input);
+    }
+    if (status != 0) return status;
+
+    /* Only whitespace may separate a scalar from the next structural */
+    if (skip_ws(b, stop_pos) != structural_pos(b, b->i)) return NEON_JSON_ERR_INVALID;
+    b->cursor = structural_pos(b, b->i);
+    return 0;
+}
+
+static int open_container(TapeBuilder* b, uint8_t c, TapeState* state) {
+    if (b->depth >= JSON_TAPE_MAX_DEPTH) return NEON_JSON_ERR_TOO_LARGE;
+    b->open_index[b->depth] = (uint32_t)b->t;
+    b->open_char[b->depth] = c;
+    b->depth++;
+
+    int status = emit(b, c, 0);   /* Payload patched on close */
+    if (status != 0) return status;
+    b->cursor = (size_t)b->positions[b->i] + 1;
+    b->i++;
+    *state = c == '{' ? EXPECT_OBJECT_FIRST : EXPECT_ARRAY_FIRST;
+    return 0;
+}
+
+static int close_container(TapeBuilder* b, uint8_t c) {
+    uint8_t expected = c == '}' ? '{' : '[';
+    if (b->depth == 0 || b->open_char[b->depth - 1] != expected) {
+        return NEON_JSON_ERR_INVALID;
+    }
+    uint32_t open = b->open_index[--b->depth];
+
+    int status = emit(b, c, open);
+    if (status != 0) return status;
+    b->tape[open] = ((uint64_t)expected << 56) | (uint64_t)(b->t - 1);
+    b->cursor = (size_t)b->positions[b->i] + 1;
+    b->i++;
+    return 0;
+}
+
+/* State after a complete value */
+static inline TapeState after_value(const TapeBuilder* b) {
+    if (b->depth == 0) return EXPECT_END;
+    return b->open_char[b->depth - 1] == '{' ? EXPECT_OBJECT_NEXT : EXPECT_ARRAY_NEXT;
+}
+
+/* Next structural character if only whitespace precedes it, else 0 */
+static inline uint8_t next_structural(const TapeBuilder* b) {
+    if (b->i >= b->n || skip_ws(b, b->cursor) != b->positions[b->i]) return 0;
+    return b->input[b->positions[b->i]];
+}
+
+/* Object key followed by ':' */
+static int build_key(TapeBuilder* b) {
+    if (next_structural(b) != '"') return NEON_JSON_ERR_INVALID;
+    int status = build_string(b);
+    if (status != 0) return status;
+
+    if (next_structural(b) != ':') return NEON_JSON_ERR_INVALID;
+    b->cursor = (size_t)b->positions[b->i] + 1;
+    b->i++;
+    return 0;
+}
+
+static int build_value(TapeBuilder* b, TapeState* state) {
+    size_t pos = skip_ws(b, b->cursor);
+    if (pos >= b->input_len) return NEON_JSON_ERR_INVALID;
+
+    int status;
+    if (pos == structural_pos(b, b->i)) {
+        uint8_t c = b->input[pos];
+        if (c == '{' || c == '[') return open_container(b, c, state);
+        if (c != '"') return NEON_JSON_ERR_INVALID;
+        status = build_string(b);
+    } else {
+        status = build_scalar(b, pos);
+    }
+    if (status != 0) return status;
+    *state = after_value(b);
+    return 0;
+}
+
+int64_t json_build_tape(
+    const uint8_t* input,
+    size_t input_len,
+    const uint32_t* positions,
+    size_t n,
+    uint64_t* tape_out,
+    size_t tape_capacity,
+    uint8_t* string_buf_out,
+    size_t string_buf_capacity,
+    size_t* string_buf_len
+) {
+    if (!input || input_len == 0 || (n > 0 && !positions) || !tape_out ||
+        (!string_buf_out && string_buf_capacity > 0)) {
+        return NEON_JSON_ERR_INVALID;
+    }
+    if ((uint64_t)input_len > UINT32_MAX) {
+        return NEON_JSON_ERR_TOO_LARGE;
+    }
+
+    TapeBuilder b;
+    b.input = input;
+    b.input_len = input_len;
+    b.positions = positions;
+    b.n = n;
+    b.i = 0;
+    b.cursor = 0;
+    b.tape = tape_out;
+    b.tape_capacity = tape_capacity;
+    b.t = 0;
+    b.strings = string_buf_out;
+    b.strings_capacity = string_buf_capacity;
+    b.s = 0;
+    b.depth = 0;
+
+    int status = emit(&b, JSON_TAPE_ROOT, 0);
+    TapeState state = EXPECT_VALUE;
+
+    while (status == 0 && state != EXPECT_END) {
+        uint8_t c;
+        switch (state) {
+        case EXPECT_VALUE:
+            status = build_value(&b, &state);
+            break;
+
+        case EXPECT_OBJECT_FIRST:
+        case EXPECT_OBJECT_NEXT:
+            c = next_structural(&b);
+            if (c == '}') {
+                status = close_container(&b, c);
+                state = after_value(&b);
+            } else if (state == EXPECT_OBJECT_FIRST) {
+                status = build_key(&b);
+                state = EXPECT_VALUE;
+            } else if (c == ',') {
+                b.cursor = (size_t)b.positions[b.i] + 1;
+                b.i++;
+                status = build_key(&b);
+                state = EXPECT_VALUE;
+            } else {
+                status = NEON_JSON_ERR_INVALID;
+            }
+            break;
+
+        case EXPECT_ARRAY_FIRST:
+        case EXPECT_ARRAY_NEXT:
+            c = next_structural(&b);
+            if (c == ']') {
+                status = close_container(&b, c);
+                state = after_value(&b);
+            } else if (state == EXPECT_ARRAY_FIRST) {
+                state = EXPECT_VALUE;
+            } else if (c == ',') {
+                b.cursor = (size_t)b.positions[b.i] + 1;
+                b.i++;
+                state = EXPECT_VALUE;
+            } else {
+                status = NEON_JSON_ERR_INVALID;
+            }
+            break;
+
+        case EXPECT_END:
+            break;
+        }
+    }
+    if (status != 0) return status;
+
+    /* Nothing but whitespace after the root value */
+    if (b.i != n || skip_ws(&b, b.cursor) != input_len) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    tape_out[0] = ((uint64_t)JSON_TAPE_ROOT << 56) | (uint64_t)b.t;
+    if (string_buf_len) *string_buf_len = b.s;
+    return (int64_t)b.t;
+}
@@ -0,0 +1,554 @@
+/**
+ * Tape serialization (json_write_tape)
+ *
+ * Writes compact JSON straight from the JsonTape layout (see
+ * neon_json_tape.c), without building values or Strings:
+ *
+ *   strings  copied 32 bytes at a time; the quote / backslash / control
+ *            byte mask jumps straight to the next byte that needs an
+ *            escape. Strings still flagged escaped are re-emitted
+ *            verbatim from the source once json_escapes_valid accepts
+ *            them (json_build_tape already did; Mojo tapes may not).
+ *   int64    two digits per step from a 200-byte digit-pair table
+ *   double   shortest decimal that round-trips (Schubfach, as in
+ *            Java's Double.toString), printed like Python's repr and
+ *            String(Float64): fixed for 1e-4 <= |v| < 1e16, else
+ *            d.ddde+XX. Powers of ten come from the Eisel-Lemire table
+ *            in neon_json_pow5.c plus 16 entries for the subnormal range.
+ *
+ * Escapes match JsonSerializer._escape_string in src/serializer.mojo:
+ * \" \\ \b \f \n \r \t, \u00XX (lowercase) for other control bytes.
+ *
+ * The tape is flat, so the walk is a loop with a stack of open
+ * containers that only decides where ',' and ':' go.
+ */
+
+#include "neon_json.h"
+#include "neon_json_internal.h"
+#include <string.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NEON_JSON_HAVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define TAPE_PAYLOAD_MASK 0x00FFFFFFFFFFFFFFULL
+
+typedef struct {
+    uint8_t* out;
+    size_t capacity;
+    size_t pos;
+} Writer;
+
+static inline int put_bytes(Writer* w, const void* p, size_t len) {
+    if (w->capacity - w->pos < len) return NEON_JSON_ERR_OUTPUT_FULL;
+    memcpy(w->out + w->pos, p, len);
+    w->pos += len;
+    return 0;
+}
+
+static inline int put_byte(Writer* w, uint8_t c) {
+    if (w->pos >= w->capacity) return NEON_JSON_ERR_OUTPUT_FULL;
+    w->out[w->pos++] = c;
+    return 0;
+}
+
+/* =============================================================================
+ * Strings
+ * ============================================================================= */
+
+/* Second byte of the escape for c, 'u' for \u00XX, 0 if c is written as-is */
+static const uint8_t ESCAPE_CHAR[256] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    ['"'] = '"', ['\\'] = '\\'
+};
+
+/*
+ * Offset of the first byte in the 16 at p that needs an escape, or 16.
+ */
+#if defined(NEON_JSON_HAVE_NEON)
+static inline size_t find_special_16(const uint8_t* p) {
+    uint8x16_t v = vld1q_u8(p);
+    uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('\\')),
+                                       vceqq_u8(v, vdupq_n_u8('"'))),
+                              vcltq_u8(v, vdupq_n_u8(0x20)));
+    /* 4 bits per byte, so the first hit is ctz / 4 */
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+    return mask ? (size_t)(__builtin_ctzll(mask) >> 2) : 16;
+}
+#elif defined(__SSE2__)
+static inline size_t find_special_16(const uint8_t* p) {
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    /* Unsigned v < 0x20 as max(v, 0x1F) == 0x1F */
+    __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)),
+                                     _mm_set1_epi8(0x1F));
+    __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')),
+                                            _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))),
+                               control);
+    unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+    return mask ? (size_t)__builtin_ctz(mask) : 16;
+}
+#endif
+
+/*
+ * Copy bytes up to the next one needing an escape; returns how many were
+ * copied. `readable` (>= avail) bytes may be loaded from src, so short
+ * strings inside a larger buffer still take the vector path; anything
+ * stored past the copied count is overwritten by the next write.
+ */
+static inline size_t copy_until_special(const uint8_t* src, size_t avail,
+                                        size_t readable, uint8_t* out, size_t room) {
+    size_t n = 0;
+
+#if defined(NEON_JSON_HAVE_NEON) || defined(__SSE2__)
+    /* 32 bytes per step: store both vectors, stop at the first hit */
+    while (avail - n >= 32 && room - n >= 32) {
+        size_t a = find_special_16(src + n);
+        memcpy(out + n, src + n, 16);
+        if (a < 16) return n + a;
+
+        size_t b = find_special_16(src + n + 16);
+        memcpy(out + n + 16, src + n + 16, 16);
+        if (b < 16) return n + 16 + b;
+        n += 32;
+    }
+    if (n < avail && readable - n >= 16 && room - n >= 16) {
+        size_t a = find_special_16(src + n);
+        memcpy(out + n, src + n, 16);
+        n += a;
+        if (n >= avail) return avail;
+        if (a < 16) return n;
+    }
+#endif
+
+    while (n < avail && n < room && ESCAPE_CHAR[src[n]] == 0) {
+        out[n] = src[n];
+        n++;
+    }
+    return n;
+}
+
+/* `readable` as for copy_until_special */
+static int write_escaped(Writer* w, const uint8_t* s, size_t len, size_t readable) {
+    static const char HEX[16] = "0123456789abcdef";
+    int status = put_byte(w, '"');
+    size_t i = 0;
+
+    while (status == 0 && i < len) {
+        size_t plain = copy_until_special(s + i, len - i, readable - i,
+                                          w->out + w->pos, w->capacity - w->pos);
+        i += plain;
+        w->pos += plain;
+        if (i == len) break;
+
+        uint8_t c = s[i];
+        uint8_t e = ESCAPE_CHAR[c];
+        if (e == 0) return NEON_JSON_ERR_OUTPUT_FULL;   /* Plain byte, no room */
+        if (e == 'u') {
+            uint8_t esc[6] = { '\\', 'u', '0', '0', (uint8_t)HEX[c >> 4], (uint8_t)HEX[c & 0xF] };
+            status = put_bytes(w, esc, 6);
+        } else {
+            uint8_t esc[2] = { '\\', e };
+            status = put_bytes(w, esc, 2);
+        }
+        i++;
+    }
+    if (status != 0) return status;
+    return put_byte(w, '"');
+}
+
+static inline uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static int write_string(Writer* w, const uint8_t* ref,
+                        const uint8_t* strings, size_t strings_len,
+                        const uint8_t* source, size_t source_len) {
+    size_t start = get_u32(ref);
+    size_t len = get_u32(ref + 4);
+    uint8_t flags = ref[8];
+
+    if (flags & JSON_TAPE_STRING_DECODED) {
+        if (start + len > strings_len) return NEON_JSON_ERR_INVALID;
+        return write_escaped(w, strings + start, len, strings_len - start);
+    }
+    if (!source || start + len > source_len) return NEON_JSON_ERR_INVALID;
+    if (flags & JSON_TAPE_STRING_ESCAPED) {
+        /* Still in source form: copy it once its escapes are known valid */
+        if (!json_escapes_valid(memchr(source + start, '\\', len), source + start + len)) {
+            return NEON_JSON_ERR_INVALID;
+        }
+        if (w->capacity - w->pos < len + 2) return NEON_JSON_ERR_OUTPUT_FULL;
+        w->out[w->pos] = '"';
+        memcpy(w->out + w->pos + 1, source + start, len);
+        w->out[w->pos + 1 + len] = '"';
+        w->pos += len + 2;
+        return 0;
+    }
+    return write_escaped(w, source + start, len, source_len - start);
+}
+
+/* =============================================================================
+ * Integers
+ * ============================================================================= */
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Decimal digits of v, written so they end just before end; returns the first */
+static inline char* format_u64(uint64_t v, char* end) {
+    char* p = end;
+    while (v >= 100) {
+        unsigned pair = (unsigned)(v % 100);
+        v /= 100;
+        p -= 2;
+        memcpy(p, DIGIT_PAIRS + 2 * pair, 2);
+    }
+    if (v >= 10) {
+        p -= 2;
+        memcpy(p, DIGIT_PAIRS + 2 * v, 2);
+    } else {
+        *--p = (char)('0' + v);
+    }
+    return p;
+}
+
+static int write_int64(Writer* w, int64_t value) {
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    char* p = format_u64(magnitude, end);
+    if (value < 0) *--p = '-';
+    return put_bytes(w, p, (size_t)(end - p));
+}
+
+/* =============================================================================
+ * Doubles
+ * ============================================================================= */
+
+#define DOUBLE_C_MIN  (1ULL << 52)
+#define DOUBLE_Q_MIN  (-1074)
+#define DOUBLE_C_TINY 3
+#define MASK_63       ((1ULL << 63) - 1)
+
+/* floor(q * log10(2)), floor(q * log10(3/4 * 2)), floor(e * log2(10)) */
+static inline int flog10pow2(int q) {
+    return (int)(((int64_t)q * 661971961083LL) >> 41);
+}
+
+static inline int flog10_three_quarters_pow2(int q) {
+    return (int)(((int64_t)q * 661971961083LL - 274743187321LL) >> 41);
+}
+
+static inline int flog2pow10(int e) {
+    return (int)(((int64_t)e * 913124641741LL) >> 38);
+}
+
+static inline uint64_t mul_high(uint64_t a, uint64_t b) {
+    return (uint64_t)(((__uint128_t)a * b) >> 64);
+}
+
+/* Round to odd of (g1 * 2^63 + g0) * cp / 2^127 */
+static inline uint64_t round_to_odd(uint64_t g1, uint64_t g0, uint64_t cp) {
+    uint64_t x1 = mul_high(g0, cp);
+    uint64_t y0 = g1 * cp;
+    uint64_t y1 = mul_high(g1, cp);
+    uint64_t z = (y0 >> 1) + x1;
+    uint64_t vbp = y1 + (z >> 63);
+    return vbp | (((z & MASK_63) + MASK_63) >> 63);
+}
+
+/*
+ * g for 10^309 .. 10^324, past the end of the Eisel-Lemire table:
+ *
+ *   r = floor(e * log2(10)) - 125; g = 10^e // 2^r + 1
+ */
+#define POW10_EXTRA_MIN 309
+#define POW10_EXTRA_MAX 324
+static const uint64_t POW10_EXTRA[(POW10_EXTRA_MAX - POW10_EXTRA_MIN + 1) * 2] = {
+    0x5900c19d9aeb1fb9ULL, 0x4b34b319547944f7ULL,
+    0x6f40f20501a5e7a7ULL, 0x7e01dfdfa9979635ULL,
+    0x458897432107b0c8ULL, 0x7ec12bebc9febde1ULL,
+    0x56eabd13e9499cfbULL, 0x1e7176e6bc7e6d59ULL,
+    0x6ca56c58e39c043aULL, 0x060dd4a06b9e08b0ULL,
+    0x43e763b78e4182a4ULL, 0x23c8a4e44342c56eULL,
+    0x54e13ca571d1e34dULL, 0x2cbace1d541376c9ULL,
+    0x6a198bcece465c20ULL, 0x57e981a4a918547bULL,
+    0x424ff76140ebf994ULL, 0x36f1f106e9af34cdULL,
+    0x52e3f5399126f7f9ULL, 0x44ae6d48a41b0201ULL,
+    0x679cf287f570b5f7ULL, 0x75da089acd21c281ULL,
+    0x40c21794f96671baULL, 0x79a84560c0351991ULL,
+    0x50f29d7a37c00e29ULL, 0x581256b8f0425ff5ULL,
+    0x652f44d8c5b011b4ULL, 0x0e16ec672c52f7f2ULL,
+    0x7e7b160ef71c1621ULL, 0x119ca780f767b5eeULL,
+    0x4f0cedc95a718dd4ULL, 0x5b01e8b09aa0d1b5ULL,
+};
+
+/*
+ * 10^e as g = floor(beta) + 1 with beta in [2^125, 2^126), split 63/63
+ * bits. Derived from the Eisel-Lemire table, whose entries are floor(5^e)
+ * scaled into [2^127, 2^128) except for e in [-27, -1] (rounded up).
+ */
+static inline void pow10_g(int e, uint64_t* g1, uint64_t* g0) {
+    if (e > JSON_POW5_MAX_Q) {
+        *g1 = POW10_EXTRA[(e - POW10_EXTRA_MIN) * 2];
+        *g0 = POW10_EXTRA[(e - POW10_EXTRA_MIN) * 2 + 1];
+        return;
+    }
+    const uint64_t* p = &json_power_of_five_128[(e - JSON_POW5_MIN_Q) * 2];
+    __uint128_t m = ((__uint128_t)p[0] << 64) | p[1];
+    if (e >= -27 && e < 0) m -= 1;
+    __uint128_t g = (m >> 2) + 1;
+    *g1 = (uint64_t)(g >> 63);
+    *g0 = (uint64_t)g & MASK_63;
+}
+
+/*
+ * Schubfach: shortest decimal f * 10^k in the rounding interval of
+ * c * 2^q, closest to it on ties. dk rescales a c premultiplied by 10.
+ */
+static void shortest_decimal(int q, uint64_t c, int dk, uint64_t* f, int* k_out) {
+    uint64_t out = c & 1;
+    uint64_t cb = c << 2;
+    uint64_t cbr = cb + 2;
+    uint64_t cbl;
+    int k;
+    if (c != DOUBLE_C_MIN || q == DOUBLE_Q_MIN) {
+        cbl = cb - 2;
+        k = flog10pow2(q);
+    } else {
+        cbl = cb - 1;   /* Closer lower neighbour at a binade boundary */
+        k = flog10_three_quarters_pow2(q);
+    }
+    int h = q + flog2pow10(-k) + 2;
+    uint64_t g1, g0;
+    pow10_g(-k, &g1, &g0);
+
+    uint64_t vb = round_to_odd(g1, g0, cb << h);
+    uint64_t vbl = round_to_odd(g1, g0, cbl << h);
+    uint64_t vbr = round_to_odd(g1, g0, cbr << h);
+
+    uint64_t s = vb >> 2;
+    if (s >= 10) {
+        /* Try one digit less first (Java needs two digits and uses 100) */
+        uint64_t sp10 = s / 10 * 10;
+        uint64_t tp10 = sp10 + 10;
+        int upin = vbl + out <= sp10 << 2;
+        int wpin = (tp10 << 2) + out <= vbr;
+        if (upin != wpin) {
+            *f = upin ? sp10 : tp10;
+            *k_out = k + dk;
+            return;
+        }
+    }
+    uint64_t t = s + 1;
+    int uin = vbl + out <= s << 2;
+    int win = (t << 2) + out <= vbr;
+    if (uin != win) {
+        *f = uin ? s : t;
+    } else {
+        int64_t cmp = (int64_t)(vb - ((s + t) << 1));
+        *f = (cmp < 0 || (cmp == 0 && (s & 1) == 0)) ? s : t;
+    }
+    *k_out = k + dk;
+}
+
+/* Decimal digits f * 10^k printed like Python's repr (no sign) */
+static int write_decimal(Writer* w, uint64_t f, int k) {
+    while (f >= 10 && f % 10 == 0) {
+        f /= 10;
+        k++;
+    }
+    char digits_buf[24];
+    char* end = digits_buf + sizeof(digits_buf);
+    char* digits = format_u64(f, end);
+    int n = (int)(end - digits);
+    int exp10 = n + k - 1;   /* Scientific exponent */
+
+    char buf[40];
+    size_t len = 0;
+    if (exp10 >= -4 && exp10 < 16) {
+        if (k >= 0) {
+            memcpy(buf, digits, (size_t)n);
+            len = (size_t)n;
+            memset(buf + len, '0', (size_t)k);
+            len += (size_t)k;
+            memcpy(buf + len, ".0", 2);
+            len += 2;
+        } else if (n + k > 0) {
+            memcpy(buf, digits, (size_t)(n + k));
+            len = (size_t)(n + k);
+            buf[len++] = '.';
+            memcpy(buf + len, digits + n + k, (size_t)(-k));
+            len += (size_t)(-k);
+        } else {
+            memcpy(buf, "0.", 2);
+            len = 2;
+            memset(buf + len, '0', (size_t)(-(n + k)));
+            len += (size_t)(-(n + k));
+            memcpy(buf + len, digits, (size_t)n);
+            len += (size_t)n;
+        }
+    } else {
+        buf[len++] = digits[0];
+        if (n > 1) {
+            buf[len++] = '.';
+            memcpy(buf + len, digits + 1, (size_t)(n - 1));
+            len += (size_t)(n - 1);
+        }
+        buf[len++] = 'e';
+        buf[len++] = exp10 < 0 ? '-' : '+';
+        int magnitude = exp10 < 0 ? -exp10 : exp10;
+        if (magnitude >= 100) buf[len++] = (char)('0' + magnitude / 100);
+        memcpy(buf + len, DIGIT_PAIRS + 2 * (magnitude % 100), 2);
+        len += 2;
+    }
+    return put_bytes(w, buf, len);
+}
+
+static int write_double(Writer* w, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint64_t t = bits & (DOUBLE_C_MIN - 1);
+    int bq = (int)((bits >> 52) & 0x7FF);
+
+    /* JSON has no NaN or Infinity */
+    if (bq == 0x7FF) return put_bytes(w, "null", 4);
+
+    if (bits >> 63) {
+        int status = put_byte(w, '-');
+        if (status != 0) return status;
+    }
+    if (bq == 0 && t == 0) return put_bytes(w, "0.0", 3);
+
+    uint64_t f;
+    int k;
+    if (bq != 0) {
+        int mq = -DOUBLE_Q_MIN + 1 - bq;
+        uint64_t c = DOUBLE_C_MIN | t;
+        /* Integers below 2^53 are exact */
+        if (mq > 0 && mq < 53 && ((c >> mq) << mq) == c) {
+            return write_decimal(w, c >> mq, 0);
+        }
+        shortest_decimal(-mq, c, 0, &f, &k);
+    } else if (t < DOUBLE_C_TINY) {
+        /* Too few bits for the interval arithmetic: scale up by 10 */
+        shortest_decimal(DOUBLE_Q_MIN, 10 * t, -1, &f, &k);
+    } else {
+        shortest_decimal(DOUBLE_Q_MIN, t, 0, &f, &k);
+    }
+    return write_decimal(w, f, k);
+}
+
+/* =============================================================================
+ * Tape Walk
+ * ============================================================================= */
+
+int64_t json_write_tape(
+    const uint64_t* tape,
+    size_t n_entries,
+    const uint8_t* strings,
+    size_t strings_len,
+    const uint8_t* source,
+    size_t source_len,
+    uint8_t* out,
+    size_t out_capacity
+) {
+    if (!tape || n_entries == 0 || (!strings && strings_len > 0) ||
+        (!out && out_capacity > 0)) {
+        return NEON_JSON_ERR_INVALID;
+    }
+
+    Writer w;
+    w.out = out;
+    w.capacity = out_capacity;
+    w.pos = 0;
+
+    /* Per open container: is it an object, and how many children so far */
+    uint8_t is_object[JSON_TAPE_MAX_DEPTH];
+    uint32_t children[JSON_TAPE_MAX_DEPTH];
+    size_t depth = 0;
+    int status = 0;
+
+    for (size_t i = 0; i < n_entries && status == 0; i++) {
+        uint8_t tag = (uint8_t)(tape[i] >> 56);
+        uint64_t payload = tape[i] & TAPE_PAYLOAD_MASK;
+
+        if (tag == JSON_TAPE_ROOT) continue;
+
+        if (tag == JSON_TAPE_END_OBJECT || tag == JSON_TAPE_END_ARRAY) {
+            if (depth == 0) return NEON_JSON_ERR_INVALID;
+            depth--;
+            status = put_byte(&w, tag);
+            continue;
+        }
+
+        /* Separator before this child: ',' between members, ':' after a key */
+        if (depth > 0) {
+            uint32_t nth = children[depth - 1]++;
+            if (is_object[depth - 1]) {
+                if (nth & 1) {
+                    status = put_byte(&w, ':');
+                } else if (nth > 0) {
+                    status = put_byte(&w, ',');
+                }
+            } else if (nth > 0) {
+                status = put_byte(&w, ',');
+            }
+            if (status != 0) break;
+        }
+
+        switch (tag) {
+        case JSON_TAPE_START_OBJECT:
+        case JSON_TAPE_START_ARRAY:
+            if (depth >= JSON_TAPE_MAX_DEPTH) return NEON_JSON_ERR_TOO_LARGE;
+            is_object[depth] = tag == JSON_TAPE_START_OBJECT;
+            children[depth] = 0;
+            depth++;
+            status = put_byte(&w, tag);
+            break;
+
+        case JSON_TAPE_STRING:
+            if (!strings || payload + 9 > strings_len) return NEON_JSON_ERR_INVALID;
+            status = write_string(&w, strings + payload, strings, strings_len,
+                                  source, source_len);
+            break;
+
+        case JSON_TAPE_INT64:
+        case JSON_TAPE_DOUBLE:
+            if (i + 1 >= n_entries) return NEON_JSON_ERR_INVALID;
+            if (tag == JSON_TAPE_INT64) {
+                status = write_int64(&w, (int64_t)tape[i + 1]);
+            } else {
+                double d;
+                memcpy(&d, &tape[i + 1], sizeof(d));
+                status = write_double(&w, d);
+            }
+            i++;
+            break;
+
+        case JSON_TAPE_TRUE:
+            status = put_bytes(&w, "true", 4);
+            break;
+        case JSON_TAPE_FALSE:
+            status = put_bytes(&w, "false", 5);
+            break;
+        case JSON_TAPE_NULL:
+            status = put_bytes(&w, "null", 4);
+            break;
+
+        default:
+            return NEON_JSON_ERR_INVALID;
+        }
+    }
+    if (status != 0) return status;
+    if (depth != 0) return NEON_JSON_ERR_INVALID;
+    return (int64_t)w.pos;
+}
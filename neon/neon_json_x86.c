@@ -0,0 +1,359 @@
+/**
+ * x86-64 Stage 1 kernels for the NEON JSON library
+ *
+ * Same algorithm and C ABI as the NEON kernel in neon_json.c, so callers of
+ * neon_json.h (including src/neon_ffi.mojo) run unchanged on x86 servers.
+ *
+ * Kernels:
+ * - AVX2:     vpshufb nibble-table classification, vpmovmskb bitmasks
+ * - AVX-512:  vpshufb on zmm + vpcmpb straight into 64-bit mask registers
+ * Both use pclmulqdq for the prefix-XOR string mask.
+ *
+ * Each comes in two specializations of one body: the default kernel, and a
+ * whitespace-heavy one that first tests each block for being all whitespace
+ * and skips the classification entirely when it is.
+ *
+ * The validating kernel (UTF-8 + string control characters) is AVX2 only;
+ * AVX-512 machines run it too.
+ *
+ * Kernels are compiled with target attributes and picked at runtime via
+ * CPUID, so the library itself needs no -mavx2 / -mavx512bw flags.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+#include "neon_json.h"
+#include "neon_json_internal.h"
+#include <immintrin.h>
+
+#define TARGET_AVX2   __attribute__((target("avx2,pclmul")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw,pclmul")))
+
+/*
+ * Structural lookup by low nibble (simdjson). After OR-ing 0x20 into the
+ * input, '[' and ']' become '{' and '}', so six characters need only four
+ * table slots:  ':' (0x3A), '{' (0x7B), ',' (0x2C), '}' (0x7D).
+ * Bytes >= 0x80 make vpshufb return 0, which never equals (byte | 0x20).
+ * The OR also maps the control bytes 0x0C and 0x1A onto ',' and ':', so
+ * the kernels drop matches below 0x20 to agree with the NEON / scalar ones.
+ */
+#define OP_TABLE_16 \
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0
+
+/*
+ * Whitespace lookup by low nibble: ' ' (0x20), '\t' (0x09), '\n' (0x0A) and
+ * '\r' (0x0D) have distinct low nibbles, so a byte is whitespace iff it
+ * equals its own table entry. Empty slots hold 0, which only the byte 0x00
+ * could match, and its slot holds ' '.
+ */
+#define WS_TABLE_16 \
+    ' ', 0, 0, 0, 0, 0, 0, 0, 0, '\t', '\n', 0, 0, '\r', 0, 0
+
+/* =============================================================================
+ * AVX2 Kernel
+ * ============================================================================= */
+
+TARGET_AVX2
+static inline uint64_t avx2_prefix_xor(uint64_t mask) {
+    __m128i all_ones = _mm_set1_epi8((char)0xFF);
+    __m128i result = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)mask), all_ones, 0);
+    return (uint64_t)_mm_cvtsi128_si64(result);
+}
+
+TARGET_AVX2
+static inline void avx2_classify_32(
+    __m256i chunk,
+    uint32_t* structural_out,
+    uint32_t* quote_out,
+    uint32_t* backslash_out
+) {
+    const __m256i op_table = _mm256_setr_epi8(OP_TABLE_16, OP_TABLE_16);
+
+    __m256i curlified = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+    __m256i op = _mm256_cmpeq_epi8(curlified, _mm256_shuffle_epi8(op_table, chunk));
+    /* Signed compare; bytes >= 0x80 already miss the table */
+    op = _mm256_and_si256(op, _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(0x1F)));
+    __m256i quote = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+    __m256i backslash = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+
+    *structural_out = (uint32_t)_mm256_movemask_epi8(op);
+    *quote_out = (uint32_t)_mm256_movemask_epi8(quote);
+    *backslash_out = (uint32_t)_mm256_movemask_epi8(backslash);
+}
+
+/* 64 bytes all whitespace: one AND of both halves' compares, one movemask */
+TARGET_AVX2
+static inline int avx2_is_whitespace_64(__m256i lo, __m256i hi) {
+    const __m256i ws_table = _mm256_setr_epi8(WS_TABLE_16, WS_TABLE_16);
+
+    __m256i ws = _mm256_and_si256(_mm256_cmpeq_epi8(lo, _mm256_shuffle_epi8(ws_table, lo)),
+                                  _mm256_cmpeq_epi8(hi, _mm256_shuffle_epi8(ws_table, hi)));
+    return _mm256_movemask_epi8(ws) == -1;
+}
+
+TARGET_AVX2 JSON_KERNEL_BODY
+void avx2_stage1_body(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    uint64_t* structurals,
+    const int skip_whitespace
+) {
+    for (size_t b = 0; b < num_blocks; b++) {
+        const uint8_t* block = input + b * 64;
+        __m256i lo = _mm256_loadu_si256((const __m256i*)block);
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(block + 32));
+        uint32_t s_lo, q_lo, bs_lo, s_hi, q_hi, bs_hi;
+
+        if (skip_whitespace && avx2_is_whitespace_64(lo, hi)) {
+            structurals[b] = json_skip_whitespace_block(state);
+            continue;
+        }
+
+        avx2_classify_32(lo, &s_lo, &q_lo, &bs_lo);
+        avx2_classify_32(hi, &s_hi, &q_hi, &bs_hi);
+
+        uint64_t structural = (uint64_t)s_lo | ((uint64_t)s_hi << 32);
+        uint64_t quotes = (uint64_t)q_lo | ((uint64_t)q_hi << 32);
+        uint64_t backslashes = (uint64_t)bs_lo | ((uint64_t)bs_hi << 32);
+
+        uint64_t escaped = json_find_escaped(backslashes, state);
+        quotes &= ~escaped;
+
+        structurals[b] = json_finish_block(state, structural, quotes, escaped,
+                                           avx2_prefix_xor(quotes));
+    }
+}
+
+TARGET_AVX2
+static void avx2_stage1_blocks(const uint8_t* input, size_t num_blocks,
+                               JsonStage1State* state, uint64_t* structurals) {
+    avx2_stage1_body(input, num_blocks, state, structurals, 0);
+}
+
+TARGET_AVX2
+static void avx2_stage1_pretty_blocks(const uint8_t* input, size_t num_blocks,
+                                      JsonStage1State* state, uint64_t* structurals) {
+    avx2_stage1_body(input, num_blocks, state, structurals, 1);
+}
+
+/* =============================================================================
+ * AVX2 Validating Kernel
+ * ============================================================================= */
+
+#define UTF8_TABLE_32(t) \
+    _mm256_setr_epi8((char)t[0], (char)t[1], (char)t[2], (char)t[3], \
+                     (char)t[4], (char)t[5], (char)t[6], (char)t[7], \
+                     (char)t[8], (char)t[9], (char)t[10], (char)t[11], \
+                     (char)t[12], (char)t[13], (char)t[14], (char)t[15], \
+                     (char)t[0], (char)t[1], (char)t[2], (char)t[3], \
+                     (char)t[4], (char)t[5], (char)t[6], (char)t[7], \
+                     (char)t[8], (char)t[9], (char)t[10], (char)t[11], \
+                     (char)t[12], (char)t[13], (char)t[14], (char)t[15])
+
+/* input shifted right by n bytes across the 32-byte boundary, prev filling in */
+#define AVX2_PREV(input, prev, n) \
+    _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - (n))
+
+/* UTF-8 lookup check for 32 bytes; non-zero bytes are errors (see NEON kernel) */
+TARGET_AVX2
+static inline __m256i avx2_utf8_check_32(__m256i input, __m256i prev) {
+    const __m256i byte_1_high_table = UTF8_TABLE_32(JSON_UTF8_BYTE_1_HIGH);
+    const __m256i byte_1_low_table = UTF8_TABLE_32(JSON_UTF8_BYTE_1_LOW);
+    const __m256i byte_2_high_table = UTF8_TABLE_32(JSON_UTF8_BYTE_2_HIGH);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+
+    __m256i prev1 = AVX2_PREV(input, prev, 1);
+    __m256i prev2 = AVX2_PREV(input, prev, 2);
+    __m256i prev3 = AVX2_PREV(input, prev, 3);
+
+    __m256i byte_1_high = _mm256_shuffle_epi8(
+        byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+    __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table,
+                                             _mm256_and_si256(prev1, low_nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(
+        byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    __m256i is_third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i is_fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must23_80 = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth),
+                                         _mm256_set1_epi8((char)0x80));
+
+    return _mm256_xor_si256(must23_80, special);
+}
+
+TARGET_AVX2
+static uint32_t avx2_stage1_validate_blocks(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    JsonUtf8State* utf8,
+    uint64_t* structurals
+) {
+    /* Only the last 3 bytes of each row matter */
+    const __m256i incomplete_max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    const __m256i v_control_max = _mm256_set1_epi8(0x1F);
+
+    /* prev_block holds 16 bytes; its upper lane is the one AVX2_PREV reads */
+    __m128i prev_lo = _mm_loadu_si128((const __m128i*)utf8->prev_block);
+    __m256i prev = _mm256_inserti128_si256(_mm256_castsi128_si256(prev_lo), prev_lo, 1);
+    __m128i incomplete_lo = _mm_loadu_si128((const __m128i*)utf8->prev_incomplete);
+    __m256i incomplete = _mm256_castsi128_si256(incomplete_lo);
+    incomplete = _mm256_inserti128_si256(incomplete, incomplete_lo, 1);
+    __m256i utf8_error = _mm256_setzero_si256();
+    uint64_t control = 0;
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        const uint8_t* block = input + b * 64;
+        __m256i lo = _mm256_loadu_si256((const __m256i*)block);
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(block + 32));
+        uint32_t s_lo, q_lo, bs_lo, s_hi, q_hi, bs_hi;
+
+        avx2_classify_32(lo, &s_lo, &q_lo, &bs_lo);
+        avx2_classify_32(hi, &s_hi, &q_hi, &bs_hi);
+
+        uint64_t structural = (uint64_t)s_lo | ((uint64_t)s_hi << 32);
+        uint64_t quotes = (uint64_t)q_lo | ((uint64_t)q_hi << 32);
+        uint64_t backslashes = (uint64_t)bs_lo | ((uint64_t)bs_hi << 32);
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(lo, hi)) == 0) {
+            utf8_error = _mm256_or_si256(utf8_error, incomplete);
+            prev = _mm256_setzero_si256();
+            incomplete = _mm256_setzero_si256();
+        } else {
+            utf8_error = _mm256_or_si256(utf8_error, avx2_utf8_check_32(lo, prev));
+            utf8_error = _mm256_or_si256(utf8_error, avx2_utf8_check_32(hi, lo));
+            incomplete = _mm256_subs_epu8(hi, incomplete_max);
+            prev = hi;
+        }
+
+        /* Unsigned c < 0x20  <=>  min(c, 0x1F) == c */
+        uint32_t ctrl_lo = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(lo, v_control_max), lo));
+        uint32_t ctrl_hi = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(hi, v_control_max), hi));
+        uint64_t controls = (uint64_t)ctrl_lo | ((uint64_t)ctrl_hi << 32);
+
+        uint64_t escaped = json_find_escaped(backslashes, state);
+        quotes &= ~escaped;
+        uint64_t quote_xor = avx2_prefix_xor(quotes);
+
+        control |= controls & json_string_mask(state, quote_xor);
+        structurals[b] = json_finish_block(state, structural, quotes, escaped, quote_xor);
+    }
+
+    _mm_storeu_si128((__m128i*)utf8->prev_block, _mm256_extracti128_si256(prev, 1));
+    _mm_storeu_si128((__m128i*)utf8->prev_incomplete, _mm256_extracti128_si256(incomplete, 1));
+
+    return (_mm256_testz_si256(utf8_error, utf8_error) ? 0 : NEON_JSON_INVALID_UTF8) |
+           (control ? NEON_JSON_INVALID_CONTROL : 0);
+}
+
+/* =============================================================================
+ * AVX-512 Kernel
+ * ============================================================================= */
+
+TARGET_AVX512
+static inline uint64_t avx512_prefix_xor(uint64_t mask) {
+    __m128i all_ones = _mm_set1_epi8((char)0xFF);
+    __m128i result = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)mask), all_ones, 0);
+    return (uint64_t)_mm_cvtsi128_si64(result);
+}
+
+TARGET_AVX512 JSON_KERNEL_BODY
+void avx512_stage1_body(
+    const uint8_t* input,
+    size_t num_blocks,
+    JsonStage1State* state,
+    uint64_t* structurals,
+    const int skip_whitespace
+) {
+    const __m512i op_table = _mm512_broadcast_i32x4(_mm_setr_epi8(OP_TABLE_16));
+    const __m512i ws_table = _mm512_broadcast_i32x4(_mm_setr_epi8(WS_TABLE_16));
+    const __m512i v_lower = _mm512_set1_epi8(0x20);
+    const __m512i v_printable = _mm512_set1_epi8(0x60);
+    const __m512i v_quote = _mm512_set1_epi8('"');
+    const __m512i v_backslash = _mm512_set1_epi8('\\');
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        __m512i chunk = _mm512_loadu_si512((const void*)(input + b * 64));
+
+        if (skip_whitespace &&
+            _mm512_cmpeq_epi8_mask(chunk, _mm512_shuffle_epi8(ws_table, chunk)) == ~0ULL) {
+            structurals[b] = json_skip_whitespace_block(state);
+            continue;
+        }
+
+        /* vpcmpb writes one bit per byte directly into a mask register;
+         * the vptestmb mask (a 0x20 or 0x40 bit set) rules out 0x0C / 0x1A */
+        __m512i curlified = _mm512_or_si512(chunk, v_lower);
+        uint64_t structural = _mm512_mask_cmpeq_epi8_mask(
+            _mm512_test_epi8_mask(chunk, v_printable), curlified,
+            _mm512_shuffle_epi8(op_table, chunk));
+        uint64_t quotes = _mm512_cmpeq_epi8_mask(chunk, v_quote);
+        uint64_t backslashes = _mm512_cmpeq_epi8_mask(chunk, v_backslash);
+
+        uint64_t escaped = json_find_escaped(backslashes, state);
+        quotes &= ~escaped;
+
+        structurals[b] = json_finish_block(state, structural, quotes, escaped,
+                                           avx512_prefix_xor(quotes));
+    }
+}
+
+TARGET_AVX512
+static void avx512_stage1_blocks(const uint8_t* input, size_t num_blocks,
+                                 JsonStage1State* state, uint64_t* structurals) {
+    avx512_stage1_body(input, num_blocks, state, structurals, 0);
+}
+
+TARGET_AVX512
+static void avx512_stage1_pretty_blocks(const uint8_t* input, size_t num_blocks,
+                                        JsonStage1State* state, uint64_t* structurals) {
+    avx512_stage1_body(input, num_blocks, state, structurals, 1);
+}
+
+/* =============================================================================
+ * CPUID Dispatch
+ * ============================================================================= */
+
+JsonStage1Kernel json_x86_select_kernel(const char** name) {
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("pclmul")) {
+        *name = "avx512";
+        return avx512_stage1_blocks;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul")) {
+        *name = "avx2";
+        return avx2_stage1_blocks;
+    }
+    return NULL;
+}
+
+JsonStage1Kernel json_x86_select_pretty_kernel(void) {
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("pclmul")) {
+        return avx512_stage1_pretty_blocks;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul")) {
+        return avx2_stage1_pretty_blocks;
+    }
+    return NULL;
+}
+
+JsonStage1ValidateKernel json_x86_select_validate_kernel(void) {
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("pclmul")) {
+        return avx2_stage1_validate_blocks;
+    }
+    return NULL;
+}
+
+#endif /* __x86_64__ */